@@ -0,0 +1,136 @@
+// Micro-benchmark of the CPU mip chain generation:
+//  - Scalar: the former writeMipMaps loop (column-major, one std::vector per level)
+//  - stbir:  LoadTextureMipmap (stbir_resize_uint8_linear per level)
+//  - MipChain: MipGenerator (SIMD box filter, one allocation for all levels)
+// Build in Release. Usage: MipMapBench [iterations]
+
+#include "MipGenerator.h"
+#include "Simd.h"
+
+#include <stb/stb_image_resize2.h>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+volatile uint32_t Sink = 0; // keeps the results alive
+//-----------------------------------------------------------------------------
+// Copy of the former writeMipMaps without the upload
+void scalarMipChain(const uint8_t* pixelData, uint32_t width, uint32_t height, uint32_t mipLevelCount)
+{
+	uint32_t mipWidth = width;
+	uint32_t mipHeight = height;
+	std::vector<unsigned char> previousLevelPixels;
+	uint32_t previousWidth = 0;
+	for (uint32_t level = 0; level < mipLevelCount; ++level)
+	{
+		std::vector<unsigned char> pixels(4 * mipWidth * mipHeight);
+		if (level == 0)
+		{
+			memcpy(pixels.data(), pixelData, pixels.size());
+		}
+		else
+		{
+			for (uint32_t i = 0; i < mipWidth; ++i)
+			{
+				for (uint32_t j = 0; j < mipHeight; ++j)
+				{
+					unsigned char* p = &pixels[4 * (j * mipWidth + i)];
+					unsigned char* p00 = &previousLevelPixels[4 * ((2 * j + 0) * previousWidth + (2 * i + 0))];
+					unsigned char* p01 = &previousLevelPixels[4 * ((2 * j + 0) * previousWidth + (2 * i + 1))];
+					unsigned char* p10 = &previousLevelPixels[4 * ((2 * j + 1) * previousWidth + (2 * i + 0))];
+					unsigned char* p11 = &previousLevelPixels[4 * ((2 * j + 1) * previousWidth + (2 * i + 1))];
+					p[0] = (p00[0] + p01[0] + p10[0] + p11[0]) / 4;
+					p[1] = (p00[1] + p01[1] + p10[1] + p11[1]) / 4;
+					p[2] = (p00[2] + p01[2] + p10[2] + p11[2]) / 4;
+					p[3] = (p00[3] + p01[3] + p10[3] + p11[3]) / 4;
+				}
+			}
+		}
+		Sink = Sink + pixels[0];
+
+		previousLevelPixels = std::move(pixels);
+		previousWidth = mipWidth;
+		mipWidth /= 2;
+		mipHeight /= 2;
+	}
+}
+//-----------------------------------------------------------------------------
+// Same steps as LoadTextureMipmap without the upload
+void stbirMipChain(const uint8_t* pixelData, uint32_t width, uint32_t height, uint32_t mipLevelCount)
+{
+	uint32_t currWidth = width;
+	uint32_t currHeight = height;
+	uint8_t* currData = new uint8_t[4 * size_t(width) * height];
+	memcpy(currData, pixelData, 4 * size_t(width) * height);
+	for (uint32_t level = 1; level < mipLevelCount; ++level)
+	{
+		const uint32_t resizedWidth = std::max(1u, currWidth / 2);
+		const uint32_t resizedHeight = std::max(1u, currHeight / 2);
+		uint8_t* resizedData = new uint8_t[4 * size_t(resizedWidth) * resizedHeight];
+		stbir_resize_uint8_linear(currData, currWidth, currHeight, 0, resizedData, resizedWidth, resizedHeight, 0, STBIR_RGBA);
+		delete[] currData;
+		currData = resizedData;
+		currWidth = resizedWidth;
+		currHeight = resizedHeight;
+		Sink = Sink + currData[0];
+	}
+	delete[] currData;
+}
+//-----------------------------------------------------------------------------
+// Median time of one call in milliseconds
+double measure(int iterations, const std::function<void()>& function)
+{
+	function(); // warm up
+	std::vector<double> times(iterations);
+	for (auto& time : times)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		function();
+		time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+	std::sort(times.begin(), times.end());
+	return times[times.size() / 2];
+}
+//-----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	const int iterations = argc > 1 ? std::max(1, atoi(argv[1])) : 20;
+	printf("MipMapBench: %s, median of %d runs, full RGBA8 chain\n\n", GetSimdName(), iterations);
+	printf("%-11s %12s %12s %12s %10s %10s\n", "size", "Scalar ms", "stbir ms", "MipChain ms", "vs Scalar", "vs stbir");
+
+	struct Size { uint32_t width, height; };
+	// the former loop only works for power of two squares
+	const Size sizes[] = { { 256, 256 }, { 1024, 1024 }, { 2048, 2048 }, { 4096, 4096 }, { 2048, 1024 }, { 1023, 777 } };
+
+	std::mt19937 random(42);
+	MipChain mipChain;
+	for (const Size& size : sizes)
+	{
+		std::vector<uint8_t> image(4 * size_t(size.width) * size.height);
+		for (auto& value : image) value = static_cast<uint8_t>(random());
+
+		const uint32_t levelCount = GetMipLevelCount(size.width, size.height);
+		const bool scalarValid = size.width == size.height && std::has_single_bit(size.width);
+
+		const double scalarTime = scalarValid ? measure(iterations, [&]() { scalarMipChain(image.data(), size.width, size.height, levelCount); }) : 0.0;
+		const double stbirTime = measure(iterations, [&]() { stbirMipChain(image.data(), size.width, size.height, levelCount); });
+		const double mipChainTime = measure(iterations, [&]() { mipChain.Generate(image.data(), size.width, size.height); Sink = Sink + mipChain.GetLevelData(1)[0]; });
+
+		char name[32];
+		snprintf(name, sizeof(name), "%ux%u", size.width, size.height);
+		if (scalarValid)
+			printf("%-11s %12.3f %12.3f %12.3f %9.1fx %9.1fx\n", name, scalarTime, stbirTime, mipChainTime, scalarTime / mipChainTime, stbirTime / mipChainTime);
+		else
+			printf("%-11s %12s %12.3f %12.3f %10s %9.1fx\n", name, "-", stbirTime, mipChainTime, "-", stbirTime / mipChainTime);
+	}
+	return 0;
+}
+//-----------------------------------------------------------------------------
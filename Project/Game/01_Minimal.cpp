@@ -107,7 +107,7 @@ void Render::Destroy()
 	delete m_data;
 }
 //-----------------------------------------------------------------------------
-void Render::Frame()
+void Render::Frame(const FramePacket& packet)
 {
 	wgpu::TextureView backbufferView = m_data->swapChain.GetCurrentTextureView();
 	if (!backbufferView)
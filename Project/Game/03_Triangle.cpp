@@ -214,7 +214,7 @@ void Render::Destroy()
 	delete m_data;
 }
 //-----------------------------------------------------------------------------
-void Render::Frame()
+void Render::Frame(const FramePacket& packet)
 {
 	ubo_vs.projection = Camera.matrices.perspective;
 	ubo_vs.view = Camera.matrices.view;
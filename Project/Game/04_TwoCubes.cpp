@@ -25,9 +25,11 @@ static struct
 {
 	uint64_t number_of_cubes;
 	bool render_bundles;
+	bool instancing; // all cubes in one instanced draw
 } settings = {
   .number_of_cubes = NUMBER_OF_CUBES,
   .render_bundles = false,
+  .instancing = false,
 };
 
 
@@ -36,7 +38,7 @@ static cube_mesh_t cube_mesh = { 0 };
 
 // Cube struct
 struct cube_t {
-	BindGroup uniform_buffer_bind_group;
+	uint32_t uniform_offset; // dynamic offset of the matrix in uniform_buffer (current frame)
 	struct {
 		glm::mat4 model;
 		glm::mat4 model_view_projection;
@@ -49,13 +51,11 @@ static cube_t cubes[NUMBER_OF_CUBES] = {};
 // Vertex buffer
 static VertexBuffer vertices = {};
 
-// Uniform buffer object
-static struct {
-	UniformBuffer buffer;
-	uint64_t offset;
-	uint64_t size;
-	uint64_t size_with_offset;
-} uniform_buffer = {};
+// Uniform buffer object: one ring, the cubes are selected with dynamic offsets
+static UniformRingBuffer uniform_buffer;
+static BindGroupLayout uniform_bind_group_layout;
+static PipelineLayout pipeline_layout;
+static BindGroup uniform_buffer_bind_group;
 
 static struct {
 	glm::mat4 projection;
@@ -65,8 +65,16 @@ static struct {
 // Pipeline
 static RenderPipeline pipeline;
 
-// Render bundle
-static RenderBundle render_bundle;
+// Instanced path: the model matrices are in the instance storage buffer, the view-projection matrix in uniform_buffer
+static InstanceBatcher instance_batcher;
+static BindGroupLayout instanced_bind_group_layout;
+static PipelineLayout instanced_pipeline_layout;
+static BindGroup instanced_bind_group;
+static RenderPipeline instanced_pipeline;
+static uint32_t view_projection_offset = 0;
+
+// Render bundles: one chunk per region of uniform_buffer, the offsets of the cubes differ between regions
+static RenderBundleCache render_bundle_cache;
 
 // Other variables
 static const char* example_title = "Two Cubes";
@@ -84,6 +92,7 @@ struct RenderData
 	wgpu::Surface surface = nullptr;
 	wgpu::TextureFormat swapChainFormat = wgpu::TextureFormat::Undefined;
 	wgpu::SwapChain swapChain = nullptr;
+	wgpu::Texture offscreenTexture = nullptr; // the headless mode renders here instead of the swap chain
 
 	// Depth Buffer
 	wgpu::Texture depthTexture = nullptr;
@@ -98,6 +107,8 @@ bool Render::Create(void* glfwWindow, unsigned frameBufferWidth, unsigned frameB
 	m_frameHeight = frameBufferHeight;
 	if (!createDevice(glfwWindow))
 		return false;
+	if (!m_framePacer.Create(m_data->device, m_pacingInfo))
+		return false;
 	if (!initSwapChain(m_frameWidth, m_frameHeight))
 		return false;
 	if (!initDepthBuffer(m_frameWidth, m_frameHeight))
@@ -154,6 +165,27 @@ fn fs_main(
 	layout.AddAttrib(wgpu::VertexFormat::Float32x4, cube_mesh.position_offset);
 	layout.AddAttrib(wgpu::VertexFormat::Float32x4, cube_mesh.color_offset);
 
+	// Bind group layout with a dynamic offset uniform
+	{
+		wgpu::BindGroupLayoutEntry entry{};
+		entry.binding = 0;
+		entry.visibility = wgpu::ShaderStage::Vertex;
+		entry.buffer.type = wgpu::BufferBindingType::Uniform;
+		entry.buffer.hasDynamicOffset = true;
+		entry.buffer.minBindingSize = sizeof(glm::mat4);
+
+		wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc{};
+		bindGroupLayoutDesc.entryCount = 1;
+		bindGroupLayoutDesc.entries = &entry;
+		uniform_bind_group_layout.layout = m_data->device.CreateBindGroupLayout(&bindGroupLayoutDesc);
+
+		wgpu::PipelineLayoutDescriptor pipelineLayoutDesc{};
+		pipelineLayoutDesc.bindGroupLayoutCount = 1;
+		pipelineLayoutDesc.bindGroupLayouts = &uniform_bind_group_layout.layout;
+		pipeline_layout.layout = m_data->device.CreatePipelineLayout(&pipelineLayoutDesc);
+	}
+
+	pipeline.SetPipelineLayout(pipeline_layout);
 	pipeline.SetPrimitiveState(wgpu::PrimitiveTopology::TriangleList, wgpu::IndexFormat::Undefined, wgpu::FrontFace::CCW, wgpu::CullMode::None);
 	pipeline.SetBlendState(m_data->swapChainFormat);
 	pipeline.SetDepthStencilState(depthStencilState);
@@ -162,6 +194,81 @@ fn fs_main(
 	pipeline.SetFragmentShaderCode(shaderModule);
 	pipeline.Create(m_data->device);
 
+	// prepare_instanced_pipeline
+	{
+		const char* instancedShaderText = R"(
+struct Uniforms {
+	viewProjectionMatrix : mat4x4<f32>,
+}
+struct Instance {
+	modelMatrix : mat4x4<f32>,
+	material : u32,
+}
+@binding(0) @group(0) var<uniform> uniforms : Uniforms;
+@binding(1) @group(0) var<storage, read> instances : array<Instance>;
+
+struct VertexOutput {
+	@builtin(position) Position : vec4<f32>,
+	@location(0) fragUV : vec2<f32>,
+	@location(1) fragPosition: vec4<f32>,
+}
+
+@vertex
+fn vs_main(
+	@builtin(instance_index) instanceIndex : u32,
+	@location(0) position : vec4<f32>,
+	@location(1) uv : vec2<f32>
+) -> VertexOutput {
+	var output : VertexOutput;
+	output.Position = uniforms.viewProjectionMatrix * instances[instanceIndex].modelMatrix * position;
+	output.fragUV = uv;
+	output.fragPosition = 0.5 * (position + vec4(1.0, 1.0, 1.0, 1.0));
+	return output;
+}
+
+@fragment
+fn fs_main(
+	@location(0) fragUV: vec2<f32>,
+	@location(1) fragPosition: vec4<f32>
+) -> @location(0) vec4<f32> {
+	return fragPosition;
+}
+)";
+		wgpu::ShaderModule instancedShaderModule = CreateShaderModule(m_data->device, instancedShaderText);
+
+		wgpu::BindGroupLayoutEntry entries[2] = {};
+		entries[0].binding = 0;
+		entries[0].visibility = wgpu::ShaderStage::Vertex;
+		entries[0].buffer.type = wgpu::BufferBindingType::Uniform;
+		entries[0].buffer.hasDynamicOffset = true;
+		entries[0].buffer.minBindingSize = sizeof(glm::mat4);
+		entries[1].binding = 1;
+		entries[1].visibility = wgpu::ShaderStage::Vertex;
+		entries[1].buffer.type = wgpu::BufferBindingType::ReadOnlyStorage;
+		entries[1].buffer.minBindingSize = sizeof(InstanceData);
+
+		wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc{};
+		bindGroupLayoutDesc.entryCount = 2;
+		bindGroupLayoutDesc.entries = entries;
+		instanced_bind_group_layout.layout = m_data->device.CreateBindGroupLayout(&bindGroupLayoutDesc);
+
+		wgpu::PipelineLayoutDescriptor pipelineLayoutDesc{};
+		pipelineLayoutDesc.bindGroupLayoutCount = 1;
+		pipelineLayoutDesc.bindGroupLayouts = &instanced_bind_group_layout.layout;
+		instanced_pipeline_layout.layout = m_data->device.CreatePipelineLayout(&pipelineLayoutDesc);
+
+		instanced_pipeline.SetPipelineLayout(instanced_pipeline_layout);
+		instanced_pipeline.SetPrimitiveState(wgpu::PrimitiveTopology::TriangleList, wgpu::IndexFormat::Undefined, wgpu::FrontFace::CCW, wgpu::CullMode::None);
+		instanced_pipeline.SetBlendState(m_data->swapChainFormat);
+		instanced_pipeline.SetDepthStencilState(depthStencilState);
+		instanced_pipeline.SetVertexBufferLayout(layout);
+		instanced_pipeline.SetVertexShaderCode(instancedShaderModule);
+		instanced_pipeline.SetFragmentShaderCode(instancedShaderModule);
+		instanced_pipeline.Create(m_data->device);
+
+		instance_batcher.Create(m_data->device, NUMBER_OF_CUBES);
+	}
+
 
 	// prepare_view_matrices
 	{
@@ -195,77 +302,78 @@ fn fs_main(
 
 	// prepare_uniform_buffer
 	{
-		// Unform buffer
-		uniform_buffer.size = sizeof(glm::mat4); // 4x4 matrix
-		uniform_buffer.offset = 256; // uniformBindGroup offset must be 256-byte aligned
-		uniform_buffer.size_with_offset
-			= ((settings.number_of_cubes - 1) * uniform_buffer.offset)
-			+ uniform_buffer.size;
-
-		uniform_buffer.buffer.Create(m_data->device, uniform_buffer.size_with_offset, nullptr);
+		// Every cube matrix takes one minUniformBufferOffsetAlignment slot per frame
+		wgpu::SupportedLimits limits{};
+		m_data->device.GetLimits(&limits);
+		const uint64_t alignment = std::max(limits.limits.minUniformBufferOffsetAlignment, 4u);
+		const uint64_t slotSize = (sizeof(glm::mat4) + alignment - 1) / alignment * alignment;
+		uniform_buffer.Create(m_data->device, settings.number_of_cubes * slotSize);
 	}
 
 	// setup_bind_groups
 	{
-		for (uint64_t i = 0; i < settings.number_of_cubes; ++i) 
-		{
-			wgpu::BindGroupEntry bindings{};
-			// Binding 0 : Uniform buffer
-			bindings.binding = 0;
-			bindings.buffer = uniform_buffer.buffer.buffer;
-			bindings.offset = i * uniform_buffer.offset;
-			bindings.size = uniform_buffer.size;
-
-			wgpu::BindGroupDescriptor bindGroupDesc{};
-			bindGroupDesc.layout = pipeline.pipeline.GetBindGroupLayout(0);
-			bindGroupDesc.entryCount = 1;
-			bindGroupDesc.entries = &bindings;
-			cubes[i].uniform_buffer_bind_group.bindGroup = m_data->device.CreateBindGroup(&bindGroupDesc);
-		}
+		// One bind group for all cubes, the matrix is selected with the dynamic offset
+		wgpu::BindGroupEntry bindings{};
+		// Binding 0 : Uniform buffer
+		bindings.binding = 0;
+		bindings.buffer = uniform_buffer.GetBuffer();
+		bindings.offset = 0;
+		bindings.size = sizeof(glm::mat4);
+
+		wgpu::BindGroupDescriptor bindGroupDesc{};
+		bindGroupDesc.layout = uniform_bind_group_layout.layout;
+		bindGroupDesc.entryCount = 1;
+		bindGroupDesc.entries = &bindings;
+		uniform_buffer_bind_group.bindGroup = m_data->device.CreateBindGroup(&bindGroupDesc);
+
+		wgpu::BindGroupEntry instancedBindings[2] = {};
+		instancedBindings[0].binding = 0;
+		instancedBindings[0].buffer = uniform_buffer.GetBuffer();
+		instancedBindings[0].size = sizeof(glm::mat4);
+		instancedBindings[1].binding = 1;
+		instancedBindings[1].buffer = instance_batcher.GetInstanceBuffer().buffer;
+		instancedBindings[1].size = instance_batcher.GetMaxInstances() * sizeof(InstanceData);
+
+		bindGroupDesc.layout = instanced_bind_group_layout.layout;
+		bindGroupDesc.entryCount = 2;
+		bindGroupDesc.entries = instancedBindings;
+		instanced_bind_group.bindGroup = m_data->device.CreateBindGroup(&bindGroupDesc);
 	}	
 
 	// prepare_render_bundle_encoder
-	{
-		wgpu::TextureFormat color_formats[1] = { m_data->swapChainFormat };
-		wgpu::RenderBundleEncoderDescriptor encoderDesc{};
-		encoderDesc.colorFormatCount = 1;//(uint32_t)ARRAY_SIZE(color_formats);
-		encoderDesc.colorFormats = color_formats;
-		encoderDesc.depthStencilFormat = m_data->depthTextureFormat;
-		encoderDesc.sampleCount = 1;
-
-		wgpu::RenderBundleEncoder render_bundle_encoder = m_data->device.CreateRenderBundleEncoder(&encoderDesc);
-		if (render_bundle_encoder)
-		{
-			render_bundle_encoder.SetPipeline(pipeline.pipeline);
-			render_bundle_encoder.SetVertexBuffer(0, vertices.buffer);
-			for (uint64_t i = 0; i < settings.number_of_cubes; ++i) {
-				render_bundle_encoder.SetBindGroup(0, cubes[i].uniform_buffer_bind_group.bindGroup);
-				render_bundle_encoder.Draw(cube_mesh.vertex_count, 1, 0, 0);
-			}
-		}
-		render_bundle.bundle = render_bundle_encoder.Finish();
-		render_bundle_encoder = nullptr;
-	}
+	render_bundle_cache.Create(m_data->device, m_data->swapChainFormat, m_data->depthTextureFormat);
 
+	// the uploads of the assets are not work of the first frame
+	TakeRenderStats();
 	return true;
 }
 //-----------------------------------------------------------------------------
 void Render::Destroy()
 {
+	m_framePacer.Destroy();
+	render_bundle_cache.Destroy();
+	instance_batcher.Destroy();
+	uniform_buffer.Destroy();
 	terminateDepthBuffer();
 	terminateSwapChain();
 	m_data->dawnInstance.reset();
 	delete m_data;
 }
 //-----------------------------------------------------------------------------
-void Render::Frame()
+void Render::Frame(const FramePacket& packet)
 {
+	// no-op when the engine has already waited before reading the input
+	m_framePacer.BeginFrame();
+	m_frameArena.Reset();
+
 	// update_transformation_matrix
 	{
 
-		const float now = glfwGetTime();
+		const float now = static_cast<float>(packet.time);
 		const float sin_now = sin(now), cos_now = cos(now);
 
+		const uint32_t cube_count = static_cast<uint32_t>(settings.number_of_cubes);
+		glm::mat4* models = m_frameArena.AllocateArray<glm::mat4>(cube_count);
 		cube_t* cube = NULL;
 		for (uint64_t i = 0; i < settings.number_of_cubes; ++i)
 		{
@@ -279,16 +387,41 @@ void Render::Frame()
 			{
 				cube->view_mtx.tmp = glm::rotate(cube->view_mtx.tmp, 1.0f, { cos_now, sin_now, 0.0f });
 			}
-			cube->view_mtx.model_view_projection = view_matrices.projection * view_matrices.view * cube->view_mtx.tmp;
+			models[i] = cube->view_mtx.tmp;
+		}
+		// projection * view once, the model-view-projection matrices in one batch
+		const glm::mat4 view_projection = view_matrices.projection * view_matrices.view;
+		ComputeMvpMatrices(cube_count, view_projection, models, models);
+		for (uint32_t i = 0; i < cube_count; ++i)
+		{
+			cubes[i].view_mtx.model_view_projection = models[i];
 		}
 
-		for (uint64_t i = 0; i < settings.number_of_cubes; ++i)
+		// one upload for all cubes
+		uniform_buffer.BeginFrame();
+		if (settings.instancing)
 		{
-			m_data->queue.WriteBuffer(uniform_buffer.buffer.buffer, i * uniform_buffer.offset, &cubes[i].view_mtx.model_view_projection, sizeof(glm::mat4));
+			view_projection_offset = uniform_buffer.Push(view_projection).offset;
+			instance_batcher.Begin();
+			for (uint64_t i = 0; i < settings.number_of_cubes; ++i)
+			{
+				instance_batcher.Add(0, 0, cubes[i].view_mtx.tmp);
+			}
+			instance_batcher.End();
+		}
+		else
+		{
+			for (uint64_t i = 0; i < settings.number_of_cubes; ++i)
+			{
+				cubes[i].uniform_offset = uniform_buffer.Push(cubes[i].view_mtx.model_view_projection).offset;
+			}
 		}
+		uniform_buffer.Flush();
 	}
 
-	wgpu::TextureView backbufferView = m_data->swapChain.GetCurrentTextureView();
+	wgpu::TextureView backbufferView = m_headless.enabled
+		? m_data->offscreenTexture.CreateView()
+		: m_data->swapChain.GetCurrentTextureView();
 	if (!backbufferView)
 	{
 		Fatal("Cannot acquire next swap chain texture");
@@ -301,9 +434,37 @@ void Render::Frame()
 	wgpu::CommandEncoder encoder = m_data->device.CreateCommandEncoder();
 	{
 		renderPass.Start(encoder);
-		if (settings.render_bundles)
+		if (settings.instancing)
+		{
+			renderPass.SetViewport(0.0f, 0.0f, m_frameWidth, m_frameHeight, 0.0f, 1.0f);
+			renderPass.SetScissorRect(0, 0, m_frameWidth, m_frameHeight);
+			renderPass.SetPipeline(instanced_pipeline);
+			renderPass.SetVertexBuffer(0, vertices);
+			renderPass.SetBindGroup(0, instanced_bind_group, 1, &view_projection_offset);
+			// one draw per mesh+pipeline pair (a single one here)
+			for (const InstanceBatch& batch : instance_batcher.GetBatches())
+			{
+				renderPass.Draw(cube_mesh.vertex_count, batch.instanceCount, 0, batch.firstInstance);
+			}
+		}
+		else if (settings.render_bundles)
 		{
-			renderPass.ExecuteBundles(1, &render_bundle);
+			// recorded on the first use of each ring region, re-recorded only when the number of cubes changes
+			const uint32_t frame = uniform_buffer.GetFrameIndex();
+			render_bundle_cache.BeginFrame();
+			render_bundle_cache.Use(frame, settings.number_of_cubes, [](wgpu::RenderBundleEncoder& encoder)
+				{
+					encoder.SetPipeline(pipeline.pipeline);
+					encoder.SetVertexBuffer(0, vertices.buffer);
+					// recorded right after the matrices were pushed to this region, and the cubes push them
+					// in the same order every frame: the offsets stay valid for all later uses of the region
+					for (uint64_t i = 0; i < settings.number_of_cubes; ++i) {
+						encoder.SetBindGroup(0, uniform_buffer_bind_group.bindGroup, 1, &cubes[i].uniform_offset);
+						encoder.Draw(cube_mesh.vertex_count, 1, 0, 0);
+					}
+					return static_cast<uint32_t>(settings.number_of_cubes);
+				});
+			renderPass.ExecuteBundles(render_bundle_cache.GetFrameBundles());
 		}
 		else 
 		{
@@ -313,7 +474,7 @@ void Render::Frame()
 			renderPass.SetVertexBuffer(0, vertices);
 			for (uint64_t i = 0; i < settings.number_of_cubes; ++i)
 			{
-				renderPass.SetBindGroup(0, cubes[i].uniform_buffer_bind_group);
+				renderPass.SetBindGroup(0, uniform_buffer_bind_group, 1, &cubes[i].uniform_offset);
 				renderPass.Draw(cube_mesh.vertex_count, 1, 0, 0);
 			}
 		}
@@ -322,11 +483,24 @@ void Render::Frame()
 
 	wgpu::CommandBuffer commands = encoder.Finish();
 	m_data->queue.Submit(1, &commands);
+	m_framePacer.EndFrame();
+	m_stats = TakeRenderStats();
 
-	m_data->swapChain.Present();
+	if (!m_headless.enabled)
+		m_data->swapChain.Present();
 	m_data->device.Tick(); // ???   Dawn?
 }
 //-----------------------------------------------------------------------------
+bool Render::ReadFrame(CapturedImage& image)
+{
+	if (!m_data->offscreenTexture)
+	{
+		Error("ReadFrame is only available in the headless mode");
+		return false;
+	}
+	return ReadTexture(m_data->device, m_data->offscreenTexture, image);
+}
+//-----------------------------------------------------------------------------
 bool Render::createDevice(void* glfwWindow)
 {
 #ifdef WEBGPU_BACKEND_WGPU
@@ -344,12 +518,25 @@ bool Render::createDevice(void* glfwWindow)
 		return false;
 	}
 
-	std::vector<dawn::native::Adapter> adapters = m_data->dawnInstance->EnumerateAdapters();
+	// the headless mode may ask for the software rasterizer or the Null backend
+	wgpu::RequestAdapterOptions adapterOptions{};
+	if (m_headless.enabled && m_headless.adapter == HeadlessAdapter::Cpu)
+		adapterOptions.forceFallbackAdapter = true;
+	else if (m_headless.enabled && m_headless.adapter == HeadlessAdapter::Null)
+		adapterOptions.backendType = wgpu::BackendType::Null;
+	std::vector<dawn::native::Adapter> adapters = m_data->dawnInstance->EnumerateAdapters(&adapterOptions);
+	if (adapters.empty())
+	{
+		Error("No WebGPU adapter found!");
+		return false;
+	}
 	dawn::native::Adapter* preferredAdapter = nullptr;
 	wgpu::AdapterProperties properties;
+	if (m_headless.enabled && m_headless.adapter != HeadlessAdapter::Default)
+		preferredAdapter = &adapters[0];
 
 	// find DiscreteGPU
-	for (size_t i = 0; i < adapters.size(); i++)
+	for (size_t i = 0; !preferredAdapter && i < adapters.size(); i++)
 	{
 		adapters[i].GetProperties(&properties);
 		if (properties.adapterType == wgpu::AdapterType::DiscreteGPU)
@@ -387,13 +574,16 @@ bool Render::createDevice(void* glfwWindow)
 	backendProcs.deviceSetDeviceLostCallback(backendDevice, wgpuDeviceLostCallback, nullptr);
 	backendProcs.deviceSetLoggingCallback(backendDevice, wgpuDeviceLogCallback, nullptr);
 
-	auto surfaceChainedDesc = wgpu::glfw::SetupWindowAndGetSurfaceDescriptor((GLFWwindow*)glfwWindow);
-	WGPUSurfaceDescriptor surfaceDesc{};
-	surfaceDesc.nextInChain = reinterpret_cast<WGPUChainedStruct*>(surfaceChainedDesc.get());
-	WGPUSurface surface = wgpuInstanceCreateSurface(m_data->dawnInstance->Get(), &surfaceDesc);
+	if (!m_headless.enabled)
+	{
+		auto surfaceChainedDesc = wgpu::glfw::SetupWindowAndGetSurfaceDescriptor((GLFWwindow*)glfwWindow);
+		WGPUSurfaceDescriptor surfaceDesc{};
+		surfaceDesc.nextInChain = reinterpret_cast<WGPUChainedStruct*>(surfaceChainedDesc.get());
+		WGPUSurface surface = wgpuInstanceCreateSurface(m_data->dawnInstance->Get(), &surfaceDesc);
+		m_data->surface = wgpu::Surface::Acquire(surface);
+	}
 
 	m_data->device = wgpu::Device::Acquire(backendDevice);
-	m_data->surface = wgpu::Surface::Acquire(surface);
 	m_data->queue = m_data->device.GetQueue();
 
 	// print adapter property
@@ -471,12 +661,19 @@ bool Render::Resize(int width, int height)
 //-----------------------------------------------------------------------------
 bool Render::initSwapChain(int width, int height)
 {
+	if (m_headless.enabled)
+	{
+		const wgpu::Extent3D size = { static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1 };
+		m_data->offscreenTexture = CreateRenderTexture(m_data->device, size, m_data->swapChainFormat, wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::CopySrc);
+		return m_data->offscreenTexture != nullptr;
+	}
+
 	wgpu::SwapChainDescriptor swapChainDesc{};
 	swapChainDesc.width = static_cast<uint32_t>(width);
 	swapChainDesc.height = static_cast<uint32_t>(height);
 	swapChainDesc.usage = wgpu::TextureUsage::RenderAttachment;
 	swapChainDesc.format = static_cast<wgpu::TextureFormat>(m_data->swapChainFormat);
-	swapChainDesc.presentMode = wgpu::PresentMode::Fifo; // WGPUPresentMode_Mailbox
+	swapChainDesc.presentMode = m_presentMode;
 	m_data->swapChain = m_data->device.CreateSwapChain(m_data->surface, &swapChainDesc);
 
 	return true;
@@ -485,6 +682,8 @@ bool Render::initSwapChain(int width, int height)
 void Render::terminateSwapChain()
 {
 	m_data->swapChain = nullptr;
+	if (m_data->offscreenTexture) m_data->offscreenTexture.Destroy();
+	m_data->offscreenTexture = nullptr;
 }
 //-----------------------------------------------------------------------------
 bool Render::initDepthBuffer(int width, int height)
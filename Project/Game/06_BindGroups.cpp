@@ -13,8 +13,6 @@
 #include "RenderModel.h"
 #include "Examples.h"
 #include "ExampleMesh.h"
-#include "Texture.h"
-#include "gltf_model.h"
 
 //-----------------------------------------------------------------------------
 // Using Bind Groups
@@ -28,24 +26,44 @@ camera_t Camera;
 struct view_matrices_t {
 	glm::mat4 projection;
 	glm::mat4 view;
-	glm::mat4 model;
 };
 
 struct cube_t {
-	view_matrices_t matrices;
-	BindGroup bind_group;
-	texture_t texture;
-	UniformBuffer uniform_buffer;
+	glm::mat4 model;
+	BindGroup bind_group; // the texture of the cube, also used by the frame packet draw items of its material
+	wgpu::Texture texture;
+	wgpu::TextureView view;
 	glm::vec3 rotation;
 };
 static cube_t cubes[2] = {};
 
-static gltf_model_t* model = NULL;
+// camera matrices, one allocation per frame
+static UniformRingBuffer uniform_buffer;
+static uint32_t view_uniform_offset = 0; // dynamic offset of the current frame
+
+// model matrices of the cubes or of the frame packet draw items, one instanced draw per texture
+static InstanceBatcher instance_batcher;
+static wgpu::Sampler sampler;
+
+// 2x2x2 box: position, normal, uv, tangent, bitangent per vertex, uploaded as PackedVertexAttributes
+static box_mesh_t box_mesh;
+static VertexBuffer vertex_buffer;
+static IndexBuffer index_buffer;
 
 static RenderPipeline pipeline;
 static PipelineLayout pipeline_layout;
 
+// Dawn keeps the compiled shaders and pipelines on disk, the next start skips the backend compilation
+static PipelineBlobCache pipeline_blob_cache;
+static PipelineCache pipeline_cache;
+
+static GpuProfiler gpu_profiler;
+
+// the mip levels of the cube textures are built by a compute shader
+static ComputeMipGenerator mip_generator;
+
 static BindGroupLayout bind_group_layout;
+static BindGroupCache bind_group_cache;
 
 VertexBufferLayout layout;
 
@@ -53,27 +71,112 @@ VertexBufferLayout layout;
 static const char* example_title = "Using Bind Groups";
 static bool prepared = false;
 
-void update_uniform_buffers(wgpu::Queue queue)
+void update_view_uniform(const glm::mat4& projection, const glm::mat4& view)
+{
+	view_matrices_t matrices;
+	matrices.projection = projection;
+	matrices.view = view;
+	uniform_buffer.BeginFrame();
+	view_uniform_offset = uniform_buffer.Push(matrices).offset;
+	uniform_buffer.Flush();
+}
+
+void update_uniform_buffers()
 {
 	static glm::vec3 translations[2] = {
 		{-2.0f, 0.0f, 0.0f}, /* Cube 1 */
 		{ 1.5f, 0.5f, 0.0f}, /* Cube 2 */
 	};
 
-	cube_t* cube = NULL;
+	static const glm::vec3 scales[2] = { glm::vec3(0.25f), glm::vec3(0.25f) };
+
+	// the x, y, z rotations of a cube as one quaternion, the model matrices in one batch
+	glm::quat rotations[2];
+	glm::mat4 models[2];
+	for (uint8_t i = 0; i < 2; ++i)
+	{
+		const glm::vec3 angles = glm::radians(cubes[i].rotation);
+		rotations[i] = glm::angleAxis(angles.x, glm::vec3(1.0f, 0.0f, 0.0f))
+			* glm::angleAxis(angles.y, glm::vec3(0.0f, 1.0f, 0.0f))
+			* glm::angleAxis(angles.z, glm::vec3(0.0f, 0.0f, 1.0f));
+	}
+	ComputeWorldMatrices(2, translations, rotations, scales, nullptr, models);
+
+	update_view_uniform(Camera.matrices.perspective, Camera.matrices.view);
+
+	// the cubes outside the camera frustum are skipped
+	const Frustum frustum = Camera.GetFrustum();
+	instance_batcher.Begin();
 	for (uint8_t i = 0; i < 2/*(uint8_t)ARRAY_SIZE(cubes)*/; ++i)
 	{
-		cube = &cubes[i];
-		cube->matrices.model = glm::translate(glm::mat4(1.0f), translations[i]);
-		cube->matrices.model = glm::rotate(cube->matrices.model, glm::radians(cube->rotation[0]), { 1.0f, 0.0f, 0.0f });
-		cube->matrices.model = glm::rotate(cube->matrices.model, glm::radians(cube->rotation[1]), { 0.0f, 1.0f, 0.0f });
-		cube->matrices.model = glm::rotate(cube->matrices.model, glm::radians(cube->rotation[2]), { 0.0f, 0.0f, 1.0f });
-		cube->matrices.model = glm::scale(cube->matrices.model, { 0.25f, 0.25f, 0.25f });
+		cubes[i].model = models[i];
+		if (TestBox(frustum, box_mesh.bounds.box.Transform(cubes[i].model)) != FrustumTest::Outside)
+			instance_batcher.Add(0, 0, cubes[i].model, i, i);
+	}
+	instance_batcher.End();
+}
 
-		cube->matrices.projection = Camera.matrices.perspective;
-		cube->matrices.view = Camera.matrices.view;
+void update_draw_item_uniform_buffers(const FramePacket& packet)
+{
+	update_view_uniform(packet.projection, packet.view);
 
-		queue.WriteBuffer(cube->uniform_buffer.buffer, 0, &cube->matrices, sizeof(view_matrices_t));
+	// the sample has one mesh (the box), the material selects the texture
+	instance_batcher.Begin();
+	for (const FrameDrawItem& item : packet.drawItems)
+		instance_batcher.Add(0, 0, item.transform, item.material, item.material % 2);
+	instance_batcher.End();
+}
+
+// uniform buffer + instance buffer + texture + sampler, again when the instance buffer has grown
+void create_cube_bind_groups()
+{
+	// the cache only holds the cube bind groups, the ones of the previous instance buffer would never be used again
+	bind_group_cache.ClearBindGroups();
+
+	for (uint8_t i = 0; i < 2/*(uint8_t)ARRAY_SIZE(cubes)*/; ++i)
+	{
+		cube_t* cube = &cubes[i];
+
+		wgpu::BindGroupEntry bindings[4] = {};
+		// Binding 0: Camera matrices uniform buffer
+		bindings[0].binding = 0;
+		bindings[0].buffer = uniform_buffer.GetBuffer();
+		bindings[0].offset = 0;
+		bindings[0].size = sizeof(view_matrices_t);
+
+		// Binding 1: Model matrices of the instances
+		bindings[1].binding = 1;
+		bindings[1].buffer = instance_batcher.GetInstanceBuffer().buffer;
+		bindings[1].offset = 0;
+		bindings[1].size = uint64_t(instance_batcher.GetMaxInstances()) * sizeof(InstanceData);
+
+		// Binding 2: Object texture view
+		bindings[2].binding = 2;
+		bindings[2].textureView = cube->view;
+
+		// Binding 3: Object texture sampler
+		bindings[3].binding = 3;
+		bindings[3].sampler = sampler;
+
+		wgpu::BindGroupDescriptor bindGroupDesc{};
+		bindGroupDesc.layout = bind_group_layout.layout;
+		bindGroupDesc.entryCount = 4;// (uint32_t)ARRAY_SIZE(bind_group_entries);
+		bindGroupDesc.entries = bindings;
+		// cubes with the same texture share the bind group
+		cube->bind_group.bindGroup = bind_group_cache.GetBindGroup(bindGroupDesc);
+	}
+}
+
+// the image of a cube, a white texture when it cannot be loaded
+void load_cube_texture(wgpu::Device& device, cube_t* cube, const char* path)
+{
+	cube->texture = LoadTexture(device, path, &cube->view, &mip_generator);
+	if (!cube->texture)
+	{
+		Warning("Cannot load " + std::string(path) + ", a white texture is used");
+		const uint8_t white[4] = { 255, 255, 255, 255 };
+		cube->texture = CreateTexture(device, { 1, 1, 1 }, wgpu::TextureFormat::RGBA8Unorm, white);
+		cube->view = cube->texture.CreateView();
 	}
 }
 
@@ -89,6 +192,7 @@ struct RenderData
 	wgpu::Surface surface = nullptr;
 	wgpu::TextureFormat swapChainFormat = wgpu::TextureFormat::Undefined;
 	wgpu::SwapChain swapChain = nullptr;
+	wgpu::Texture offscreenTexture = nullptr; // the headless mode renders here instead of the swap chain
 
 	// Depth Buffer
 	wgpu::Texture depthTexture = nullptr;
@@ -103,6 +207,13 @@ bool Render::Create(void* glfwWindow, unsigned frameBufferWidth, unsigned frameB
 	m_frameHeight = frameBufferHeight;
 	if (!createDevice(glfwWindow))
 		return false;
+	if (!m_framePacer.Create(m_data->device, m_pacingInfo))
+		return false;
+	gpu_profiler.Create(m_data->device);
+	if (!mip_generator.Create(m_data->device))
+		return false;
+	// a headless run checks the GPU mip levels against the CPU ones
+	mip_generator.SetValidation(m_headless.enabled);
 	if (!initSwapChain(m_frameWidth, m_frameHeight))
 		return false;
 	if (!initDepthBuffer(m_frameWidth, m_frameHeight))
@@ -117,32 +228,38 @@ bool Render::Create(void* glfwWindow, unsigned frameBufferWidth, unsigned frameB
 
 	// load_assets
 	{
-		const uint32_t gltf_loading_flags
-			= WGPU_GLTF_FileLoadingFlags_PreTransformVertices
-			| WGPU_GLTF_FileLoadingFlags_PreMultiplyVertexColors
-			| WGPU_GLTF_FileLoadingFlags_DontLoadImages;
-
-		wgpu_gltf_model_load_options_t opt{};
-		opt.filename = "../Data/Models/cube.gltf";
-		opt.file_loading_flags = gltf_loading_flags;
-		model = wgpu_gltf_model_load_from_file(&opt);
-		cubes[0].texture = wgpu_create_texture_from_file(m_data->device, "../Data/Textures/crate01_color_height_rgba.ktx", NULL);
-		cubes[1].texture = wgpu_create_texture_from_file(m_data->device, "../Data/Textures/crate02_color_height_rgba.ktx", NULL);
+		box_mesh_create_with_tangents(&box_mesh, 2.0f, 2.0f, 2.0f);
+		const size_t vertexCount = box_mesh.vertex_count / BOX_MESH_F32S_PER_VERTEX;
+		std::vector<PackedVertexAttributes> packedVertices(vertexCount);
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			const float* v = box_mesh.vertex_array + i * BOX_MESH_F32S_PER_VERTEX;
+			VertexAttributes vertex;
+			vertex.position = glm::make_vec3(v);
+			vertex.normal = glm::make_vec3(v + 3);
+			vertex.uv = glm::make_vec2(v + 6);
+			vertex.tangent = glm::make_vec3(v + 8);
+			vertex.bitangent = glm::make_vec3(v + 11);
+			vertex.color = glm::vec3(1.0f);
+			packedVertices[i] = packVertex(vertex);
+		}
+		if (!vertex_buffer.Create(m_data->device, packedVertices.size(), sizeof(PackedVertexAttributes), packedVertices.data())
+			|| !index_buffer.Create(m_data->device, box_mesh.index_count, sizeof(uint32_t), box_mesh.index_array))
+			return false;
+		load_cube_texture(m_data->device, &cubes[0], "../Data/Models/fourareen2K_albedo.jpg");
+		load_cube_texture(m_data->device, &cubes[1], "../Data/Models/cobblestone_floor_08_diff_2k.jpg");
 	}
 
 	// prepare_uniform_buffers
 	{
 		// Vertex shader matrix uniform buffer block
-		for (uint8_t i = 0; i < 2/*(uint8_t)ARRAY_SIZE(cubes)*/; ++i) 
-		{
-			cube_t* cube = &cubes[i];
-			cube->uniform_buffer.Create(m_data->device, sizeof(view_matrices_t), nullptr);
-		}
+		if (!uniform_buffer.Create(m_data->device, sizeof(view_matrices_t)))
+			return false;
+		// grows with the frame packets (Reserve)
+		if (!instance_batcher.Create(m_data->device, 1024))
+			return false;
 	}
 
-	// update_uniform_buffers
-	update_uniform_buffers(m_data->queue);
-
 	// setup_bind_groups
 	{
 		/*
@@ -155,36 +272,35 @@ bool Render::Create(void* glfwWindow, unsigned frameBufferWidth, unsigned frameB
 		*
 		* VS:
 		*    layout (set = 0, binding = 0) uniform UBOMatrices
+		*    layout (set = 0, binding = 1) readonly buffer Instances
 		*
 		* FS:
-		*    layout (set = 0, binding = 1) uniform texture2D ...;
-		*    layout (set = 0, binding = 2) uniform sampler ...;
+		*    layout (set = 0, binding = 2) uniform texture2D ...;
+		*    layout (set = 0, binding = 3) uniform sampler ...;
 		*/
-		wgpu::BindGroupLayoutEntry bind_group_layout_entries[3] = {};
-
-		// Binding 0: Uniform buffers (used to pass matrices)
-		bind_group_layout_entries[0].binding = 0;
-		bind_group_layout_entries[0].visibility = wgpu::ShaderStage::Vertex;
-		bind_group_layout_entries[0].buffer.type = wgpu::BufferBindingType::Uniform;
-		bind_group_layout_entries[0].buffer.hasDynamicOffset = false;
-		bind_group_layout_entries[0].buffer.minBindingSize = sizeof(view_matrices_t);
-
-		// Binding 1: Image view (used to pass per object texture information)
-		bind_group_layout_entries[1].binding = 1;
-		bind_group_layout_entries[1].visibility = wgpu::ShaderStage::Fragment;
-		bind_group_layout_entries[1].texture.sampleType = wgpu::TextureSampleType::Float;
-		bind_group_layout_entries[1].texture.viewDimension = wgpu::TextureViewDimension::e2D;
-		bind_group_layout_entries[1].texture.multisampled = false;
-
-		// Binding 2: Image sampler (used to pass per object texture information)
-		bind_group_layout_entries[2].binding = 2;
-		bind_group_layout_entries[2].visibility = wgpu::ShaderStage::Fragment;
-		bind_group_layout_entries[2].sampler.type = wgpu::SamplerBindingType::Filtering;
-
-		wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc{};
-		bindGroupLayoutDesc.entryCount = 3;
-		bindGroupLayoutDesc.entries = bind_group_layout_entries;
-		bind_group_layout.layout = m_data->device.CreateBindGroupLayout(&bindGroupLayoutDesc);
+		// Binding 0: Uniform buffers (used to pass the camera matrices)
+		bind_group_layout.AddVertexUniform(sizeof(view_matrices_t), true);
+		// Binding 1: Storage buffer (model matrices, indexed by the instance)
+		bind_group_layout.AddStorage(wgpu::ShaderStage::Vertex, true, sizeof(InstanceData));
+		// Binding 2: Image view (used to pass per object texture information)
+		bind_group_layout.AddTexture(wgpu::ShaderStage::Fragment, wgpu::TextureSampleType::Float, wgpu::TextureViewDimension::e2D);
+		// Binding 3: Image sampler (used to pass per object texture information)
+		bind_group_layout.AddSampler(wgpu::ShaderStage::Fragment, wgpu::SamplerBindingType::Filtering);
+		bind_group_layout.Create(bind_group_cache);
+		pipeline_layout.layout = bind_group_layout.CreatePipelineLayout();
+
+		// both textures are sampled the same way - one sampler
+		wgpu::SamplerDescriptor samplerDesc{};
+		samplerDesc.addressModeU = wgpu::AddressMode::Repeat;
+		samplerDesc.addressModeV = wgpu::AddressMode::Repeat;
+		samplerDesc.addressModeW = wgpu::AddressMode::Repeat;
+		samplerDesc.magFilter = wgpu::FilterMode::Linear;
+		samplerDesc.minFilter = wgpu::FilterMode::Linear;
+		samplerDesc.mipmapFilter = wgpu::MipmapFilterMode::Linear;
+		samplerDesc.lodMinClamp = 0.0f;
+		samplerDesc.lodMaxClamp = static_cast<float>(std::max(cubes[0].texture.GetMipLevelCount(), cubes[1].texture.GetMipLevelCount()));
+		samplerDesc.maxAnisotropy = 1;
+		sampler = bind_group_cache.GetSampler(samplerDesc);
 
 		/*
 		 * Bind groups
@@ -194,95 +310,60 @@ bool Render::Create(void* glfwWindow, unsigned frameBufferWidth, unsigned frameB
 		 * Bind groups contain the actual descriptor for the objects (buffers, images)
 		 * used at render time.
 		 */
-		for (uint8_t i = 0; i < 2/*(uint8_t)ARRAY_SIZE(cubes)*/; ++i)
-		{
-			cube_t* cube = &cubes[i];
-
-			wgpu::BindGroupEntry bindings[3] = {};
-			// Binding 0: Object matrices Uniform buffer
-			bindings[0].binding = 0;
-			bindings[0].buffer = cube->uniform_buffer.buffer;
-			bindings[0].offset = 0;
-			bindings[0].size = sizeof(view_matrices_t);
-
-			// Binding 1: Object texture view
-			bindings[1].binding = 1;
-			bindings[1].textureView = cube->texture.view;
-
-			// Binding 2: Object texture sampler
-			bindings[2].binding = 2;
-			bindings[2].sampler = cube->texture.sampler;
-
-			wgpu::BindGroupDescriptor bindGroupDesc{};
-			bindGroupDesc.layout = bind_group_layout.layout;
-			bindGroupDesc.entryCount = 3;// (uint32_t)ARRAY_SIZE(bind_group_entries);
-			bindGroupDesc.entries = bindings;
-			cube->bind_group.bindGroup = m_data->device.CreateBindGroup(&bindGroupDesc);
-		}
+		create_cube_bind_groups();
 	}
 
+	// update_uniform_buffers
+	update_uniform_buffers();
+
 	// prepare_pipelines
 	{
-		//wgpu::PipelineLayoutDescriptor d{};
-		//d.bindGroupLayoutCount = 1;
-		//d.bindGroupLayouts = &bind_group_layout.layout;
-		//wgpu::PipelineLayout layout = m_data->device.CreatePipelineLayout(&d);
-
-		layout.SetVertexSize(sizeof(gltfVertex));
-		// Location 0: Position
-		layout.AddAttrib(wgpu::VertexFormat::Float32x4, offsetof(gltfVertex, position));
-		// Location 1: Vertex normal
-		layout.AddAttrib(wgpu::VertexFormat::Float32x3, offsetof(gltfVertex, normal));
-		// Location 2: Texture coordinates
-		layout.AddAttrib(wgpu::VertexFormat::Float32x3, offsetof(gltfVertex, color));
-		// Location 3: Vertex color
-		layout.AddAttrib(wgpu::VertexFormat::Float32x2, offsetof(gltfVertex, uv));
-
-
-		const char* shaderText = R"(
+		layout = getPackedVertexLayout();
+
+		const std::string shaderText = std::string(PackedVertexShaderCode) + R"(
 struct UBOMatrices {
 	projection : mat4x4<f32>,
 	view : mat4x4<f32>,
+};
+
+struct Instance {
 	model : mat4x4<f32>,
+	material : u32,
 };
 
 @group(0) @binding(0) var<uniform> uboMatrices : UBOMatrices;
+@group(0) @binding(1) var<storage, read> instances : array<Instance>;
 
 struct Output {
 	@builtin(position) position : vec4<f32>,
 	@location(0) normal : vec3<f32>,
-	@location(1) color : vec3<f32>,
-	@location(2) uv : vec2<f32>,
+	@location(1) uv : vec2<f32>,
 };
 
 @vertex
 fn vs_main(
-	@location(0) inPos: vec3<f32>,
-	@location(1) inNormal: vec3<f32>,
-	@location(2) inUV: vec2<f32>,
-	@location(3) inColor: vec3<f32>
+	@builtin(instance_index) instanceIndex : u32,
+	input : PackedVertexInput
 ) -> Output {
 	var output: Output;
-	output.normal = inNormal;
-	output.color = inColor;
-	output.uv = inUV;
-	output.position = uboMatrices.projection * uboMatrices.view * uboMatrices.model * vec4<f32>(inPos.xyz, 1.0);
+	output.normal = octahedralDecode(input.normal);
+	output.uv = input.uv;
+	output.position = uboMatrices.projection * uboMatrices.view * instances[instanceIndex].model * vec4<f32>(input.position.xyz, 1.0);
 	return output;
 }
 
-@group(0) @binding(1) var textureColorMap: texture_2d<f32>;
-@group(0) @binding(2) var samplerColorMap: sampler;
+@group(0) @binding(2) var textureColorMap: texture_2d<f32>;
+@group(0) @binding(3) var samplerColorMap: sampler;
 
 @fragment
 fn fs_main(
 	@location(0) inNormal : vec3<f32>,
-	@location(1) inColor : vec3<f32>,
-	@location(2) inUV : vec2<f32>
+	@location(1) inUV : vec2<f32>
 ) -> @location(0) vec4<f32> {
-	return textureSample(textureColorMap, samplerColorMap, inUV) * vec4<f32>(inColor, 1.0);
+	return textureSample(textureColorMap, samplerColorMap, inUV);
 }
 )";
-		wgpu::ShaderModule shaderModule = CreateShaderModule(m_data->device, shaderText);
+		wgpu::ShaderModule shaderModule = pipeline_cache.GetShaderModule(shaderText);
 
 		wgpu::DepthStencilState depthStencilState{};
 		depthStencilState.depthCompare = wgpu::CompareFunction::LessEqual;
@@ -295,43 +376,78 @@ fn fs_main(
 		pipeline.SetPrimitiveState(wgpu::PrimitiveTopology::TriangleList, wgpu::IndexFormat::Undefined, wgpu::FrontFace::CCW, wgpu::CullMode::None);
 		pipeline.SetBlendState(m_data->swapChainFormat);
 		pipeline.SetDepthStencilState(depthStencilState);
+		pipeline.SetPipelineLayout(pipeline_layout);
 		pipeline.SetVertexBufferLayout(layout);
 		pipeline.SetVertexShaderCode(shaderModule);
 		pipeline.SetFragmentShaderCode(shaderModule);
-		pipeline.Create(m_data->device);
+		// a headless run must draw the cubes from the first frame to give the same image every time
+		if (m_headless.enabled)
+			pipeline.Create(pipeline_cache);
+		else
+			pipeline.CreateAsync(pipeline_cache);
 	}
 
+	// the uploads of the assets are not work of the first frame
+	TakeRenderStats();
 	return true;
 }
 //-----------------------------------------------------------------------------
 void Render::Destroy()
 {
+	m_framePacer.Destroy();
+	gpu_profiler.Destroy();
+	mip_generator.Destroy();
+	pipeline_cache.Destroy();
+	bind_group_cache.Destroy();
+	uniform_buffer.Destroy();
+	instance_batcher.Destroy();
+	sampler = nullptr;
+	index_buffer.buffer = nullptr;
+	vertex_buffer.buffer = nullptr;
+	cubes[0] = {};
+	cubes[1] = {};
 	terminateDepthBuffer();
 	terminateSwapChain();
 	m_data->dawnInstance.reset();
 	delete m_data;
 }
 //-----------------------------------------------------------------------------
-void Render::Frame()
+void Render::Frame(const FramePacket& packet)
 {
-	// update_transformation_matrix
+	PROFILE_SCOPE("Render Frame");
+	// no-op when the engine has already waited before reading the input
+	m_framePacer.BeginFrame();
+	gpu_profiler.BeginFrame();
+	m_frameArena.Reset();
+
+	if (!packet.drawItems.empty())
+	{
+		// the bind groups of the previous instance buffer are replaced when it has to grow
+		if (instance_batcher.Reserve(static_cast<uint32_t>(packet.drawItems.size())))
+			create_cube_bind_groups();
+		update_draw_item_uniform_buffers(packet);
+	}
+	else // update_transformation_matrix
 	{
 		if (animate)
 		{
-			cubes[0].rotation[0] += 2.5f * glfwGetTime();
+			cubes[0].rotation[0] += 2.5f * packet.time;
 			if (cubes[0].rotation[0] > 360.0f) 
 			{
 				cubes[0].rotation[0] -= 360.0f;
 			}
-			cubes[1].rotation[1] += 2.0f * glfwGetTime();
+			cubes[1].rotation[1] += 2.0f * packet.time;
 			if (cubes[1].rotation[1] > 360.0f) {
 				cubes[1].rotation[1] -= 360.0f;
 			}
-			update_uniform_buffers(m_data->queue);
 		}
+		// the ring moves to the next region every frame
+		update_uniform_buffers();
 	}
 
-	wgpu::TextureView backbufferView = m_data->swapChain.GetCurrentTextureView();
+	wgpu::TextureView backbufferView = m_headless.enabled
+		? m_data->offscreenTexture.CreateView()
+		: m_data->swapChain.GetCurrentTextureView();
 	if (!backbufferView)
 	{
 		Fatal("Cannot acquire next swap chain texture");
@@ -340,28 +456,51 @@ void Render::Frame()
 
 	RenderPass renderPass;
 	renderPass.SetTextureView(backbufferView, m_data->depthTextureView);
+	renderPass.timestampWrites = gpu_profiler.AddPass("Main Pass");
 
 	wgpu::CommandEncoder encoder = m_data->device.CreateCommandEncoder();
 	{
 		renderPass.Start(encoder);
 		renderPass.SetViewport(0.0f, 0.0f, m_frameWidth, m_frameHeight, 0.0f, 1.0f);
 		renderPass.SetScissorRect(0, 0, m_frameWidth, m_frameHeight);
-		renderPass.SetPipeline(pipeline);
-		for (uint64_t i = 0; i < 2; ++i)
+		// the cubes appear when the pipeline has been compiled
+		if (pipeline.IsReady())
 		{
-			renderPass.SetBindGroup(0, cubes[i].bind_group);
-			wgpu_gltf_model_draw(model,{});
+			renderPass.SetPipeline(pipeline);
+			renderPass.SetVertexBuffer(0, vertex_buffer);
+			renderPass.SetIndexBuffer(index_buffer, wgpu::IndexFormat::Uint32);
+			// one instanced draw per texture, the shader reads the model matrices by instance_index
+			for (const InstanceBatch& batch : instance_batcher.GetBatches())
+			{
+				renderPass.SetBindGroup(0, cubes[batch.bindGroup].bind_group, 1, &view_uniform_offset);
+				renderPass.DrawIndexed(static_cast<uint32_t>(box_mesh.index_count), batch.instanceCount, 0, 0, batch.firstInstance);
+			}
 		}
 		renderPass.End();
 	}
 
+	gpu_profiler.Resolve(encoder);
 	wgpu::CommandBuffer commands = encoder.Finish();
 	m_data->queue.Submit(1, &commands);
+	m_framePacer.EndFrame();
+	gpu_profiler.EndFrame();
+	m_stats = TakeRenderStats();
 
-	m_data->swapChain.Present();
+	if (!m_headless.enabled)
+		m_data->swapChain.Present();
 	m_data->device.Tick(); // ???   Dawn?
 }
 //-----------------------------------------------------------------------------
+bool Render::ReadFrame(CapturedImage& image)
+{
+	if (!m_data->offscreenTexture)
+	{
+		Error("ReadFrame is only available in the headless mode");
+		return false;
+	}
+	return ReadTexture(m_data->device, m_data->offscreenTexture, image);
+}
+//-----------------------------------------------------------------------------
 bool Render::createDevice(void* glfwWindow)
 {
 #ifdef WEBGPU_BACKEND_WGPU
@@ -372,6 +511,12 @@ bool Render::createDevice(void* glfwWindow)
 
 	WGPUInstanceDescriptor instanceDescriptor{};
 	instanceDescriptor.features.timedWaitAnyEnable = true;
+	dawn::native::DawnInstanceDescriptor dawnInstanceDescriptor{};
+	if (pipeline_blob_cache.Open("Cache/Pipelines"))
+	{
+		dawnInstanceDescriptor.platform = pipeline_blob_cache.GetPlatform();
+		instanceDescriptor.nextInChain = reinterpret_cast<WGPUChainedStruct*>(&dawnInstanceDescriptor);
+	}
 	m_data->dawnInstance = std::make_unique<dawn::native::Instance>(&instanceDescriptor);
 	if (!m_data->dawnInstance)
 	{
@@ -379,12 +524,25 @@ bool Render::createDevice(void* glfwWindow)
 		return false;
 	}
 
-	std::vector<dawn::native::Adapter> adapters = m_data->dawnInstance->EnumerateAdapters();
+	// the headless mode may ask for the software rasterizer or the Null backend
+	wgpu::RequestAdapterOptions adapterOptions{};
+	if (m_headless.enabled && m_headless.adapter == HeadlessAdapter::Cpu)
+		adapterOptions.forceFallbackAdapter = true;
+	else if (m_headless.enabled && m_headless.adapter == HeadlessAdapter::Null)
+		adapterOptions.backendType = wgpu::BackendType::Null;
+	std::vector<dawn::native::Adapter> adapters = m_data->dawnInstance->EnumerateAdapters(&adapterOptions);
+	if (adapters.empty())
+	{
+		Error("No WebGPU adapter found!");
+		return false;
+	}
 	dawn::native::Adapter* preferredAdapter = nullptr;
 	wgpu::AdapterProperties properties;
+	if (m_headless.enabled && m_headless.adapter != HeadlessAdapter::Default)
+		preferredAdapter = &adapters[0];
 
 	// find DiscreteGPU
-	for (size_t i = 0; i < adapters.size(); i++)
+	for (size_t i = 0; !preferredAdapter && i < adapters.size(); i++)
 	{
 		adapters[i].GetProperties(&properties);
 		if (properties.adapterType == wgpu::AdapterType::DiscreteGPU)
@@ -414,7 +572,15 @@ bool Render::createDevice(void* glfwWindow)
 		preferredAdapter->GetProperties(&properties);
 	}
 
-	WGPUDevice backendDevice = preferredAdapter->CreateDevice();
+	// timestamp queries for the GPU profiler
+	wgpu::DeviceDescriptor deviceDesc{};
+	const wgpu::FeatureName timestampFeature = wgpu::FeatureName::TimestampQuery;
+	if (wgpu::Adapter(preferredAdapter->Get()).HasFeature(timestampFeature))
+	{
+		deviceDesc.requiredFeatureCount = 1;
+		deviceDesc.requiredFeatures = &timestampFeature;
+	}
+	WGPUDevice backendDevice = preferredAdapter->CreateDevice(&deviceDesc);
 	DawnProcTable backendProcs = dawn::native::GetProcs();
 
 	dawnProcSetProcs(&backendProcs);
@@ -422,14 +588,19 @@ bool Render::createDevice(void* glfwWindow)
 	backendProcs.deviceSetDeviceLostCallback(backendDevice, wgpuDeviceLostCallback, nullptr);
 	backendProcs.deviceSetLoggingCallback(backendDevice, wgpuDeviceLogCallback, nullptr);
 
-	auto surfaceChainedDesc = wgpu::glfw::SetupWindowAndGetSurfaceDescriptor((GLFWwindow*)glfwWindow);
-	WGPUSurfaceDescriptor surfaceDesc{};
-	surfaceDesc.nextInChain = reinterpret_cast<WGPUChainedStruct*>(surfaceChainedDesc.get());
-	WGPUSurface surface = wgpuInstanceCreateSurface(m_data->dawnInstance->Get(), &surfaceDesc);
+	if (!m_headless.enabled)
+	{
+		auto surfaceChainedDesc = wgpu::glfw::SetupWindowAndGetSurfaceDescriptor((GLFWwindow*)glfwWindow);
+		WGPUSurfaceDescriptor surfaceDesc{};
+		surfaceDesc.nextInChain = reinterpret_cast<WGPUChainedStruct*>(surfaceChainedDesc.get());
+		WGPUSurface surface = wgpuInstanceCreateSurface(m_data->dawnInstance->Get(), &surfaceDesc);
+		m_data->surface = wgpu::Surface::Acquire(surface);
+	}
 
 	m_data->device = wgpu::Device::Acquire(backendDevice);
-	m_data->surface = wgpu::Surface::Acquire(surface);
 	m_data->queue = m_data->device.GetQueue();
+	pipeline_cache.Create(m_data->device);
+	bind_group_cache.Create(m_data->device);
 
 	// print adapter property
 	{
@@ -506,12 +677,19 @@ bool Render::Resize(int width, int height)
 //-----------------------------------------------------------------------------
 bool Render::initSwapChain(int width, int height)
 {
+	if (m_headless.enabled)
+	{
+		const wgpu::Extent3D size = { static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1 };
+		m_data->offscreenTexture = CreateRenderTexture(m_data->device, size, m_data->swapChainFormat, wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::CopySrc);
+		return m_data->offscreenTexture != nullptr;
+	}
+
 	wgpu::SwapChainDescriptor swapChainDesc{};
 	swapChainDesc.width = static_cast<uint32_t>(width);
 	swapChainDesc.height = static_cast<uint32_t>(height);
 	swapChainDesc.usage = wgpu::TextureUsage::RenderAttachment;
 	swapChainDesc.format = static_cast<wgpu::TextureFormat>(m_data->swapChainFormat);
-	swapChainDesc.presentMode = wgpu::PresentMode::Fifo; // WGPUPresentMode_Mailbox
+	swapChainDesc.presentMode = m_presentMode;
 	m_data->swapChain = m_data->device.CreateSwapChain(m_data->surface, &swapChainDesc);
 
 	return true;
@@ -520,6 +698,8 @@ bool Render::initSwapChain(int width, int height)
 void Render::terminateSwapChain()
 {
 	m_data->swapChain = nullptr;
+	if (m_data->offscreenTexture) m_data->offscreenTexture.Destroy();
+	m_data->offscreenTexture = nullptr;
 }
 //-----------------------------------------------------------------------------
 bool Render::initDepthBuffer(int width, int height)
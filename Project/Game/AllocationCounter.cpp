@@ -0,0 +1,118 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+//-----------------------------------------------------------------------------
+namespace
+{
+	std::atomic<uint64_t> AllocationCount{ 0 };
+	std::atomic<uint64_t> AllocatedBytes{ 0 };
+	std::atomic<AllocationHook> Hook{ nullptr };
+	thread_local uint64_t ThreadAllocationCount = 0;
+	thread_local uint64_t ThreadAllocatedBytes = 0;
+
+	void countAlloc(size_t size)
+	{
+		AllocationCount.fetch_add(1, std::memory_order_relaxed);
+		AllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+		ThreadAllocationCount++;
+		ThreadAllocatedBytes += size;
+		if (AllocationHook hook = Hook.load(std::memory_order_relaxed))
+			hook(size);
+	}
+
+	void* countedAlloc(size_t size)
+	{
+		countAlloc(size);
+		return std::malloc(size ? size : 1);
+	}
+
+	void* countedAlignedAlloc(size_t size, std::align_val_t alignment)
+	{
+		countAlloc(size);
+		const size_t align = static_cast<size_t>(alignment);
+#if defined(_MSC_VER)
+		return _aligned_malloc(size ? size : 1, align);
+#else
+		return std::aligned_alloc(align, (size + align - 1) / align * align);
+#endif
+	}
+
+	void alignedFree(void* memory)
+	{
+#if defined(_MSC_VER)
+		_aligned_free(memory);
+#else
+		std::free(memory);
+#endif
+	}
+}
+//-----------------------------------------------------------------------------
+AllocationCounters GetAllocationCounters()
+{
+	AllocationCounters counters;
+	counters.allocations = AllocationCount.load(std::memory_order_relaxed);
+	counters.bytes = AllocatedBytes.load(std::memory_order_relaxed);
+	return counters;
+}
+//-----------------------------------------------------------------------------
+AllocationCounters GetThreadAllocationCounters()
+{
+	AllocationCounters counters;
+	counters.allocations = ThreadAllocationCount;
+	counters.bytes = ThreadAllocatedBytes;
+	return counters;
+}
+//-----------------------------------------------------------------------------
+void SetAllocationHook(AllocationHook hook)
+{
+	Hook.store(hook, std::memory_order_relaxed);
+}
+//-----------------------------------------------------------------------------
+void* operator new(size_t size)
+{
+	if (void* memory = countedAlloc(size)) return memory;
+	throw std::bad_alloc();
+}
+//-----------------------------------------------------------------------------
+void* operator new[](size_t size)
+{
+	if (void* memory = countedAlloc(size)) return memory;
+	throw std::bad_alloc();
+}
+//-----------------------------------------------------------------------------
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return countedAlloc(size);
+}
+//-----------------------------------------------------------------------------
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return countedAlloc(size);
+}
+//-----------------------------------------------------------------------------
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	if (void* memory = countedAlignedAlloc(size, alignment)) return memory;
+	throw std::bad_alloc();
+}
+//-----------------------------------------------------------------------------
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	if (void* memory = countedAlignedAlloc(size, alignment)) return memory;
+	throw std::bad_alloc();
+}
+//-----------------------------------------------------------------------------
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { alignedFree(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { alignedFree(memory); }
+void operator delete(void* memory, size_t, std::align_val_t) noexcept { alignedFree(memory); }
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept { alignedFree(memory); }
+//-----------------------------------------------------------------------------
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Heap allocations of the whole process (the global operator new is replaced in AllocationCounter.cpp).
+// The counters only grow, compare two snapshots to get the allocations of a frame.
+struct AllocationCounters
+{
+	uint64_t allocations = 0;
+	uint64_t bytes = 0;
+};
+
+AllocationCounters GetAllocationCounters();
+// Allocations made by the calling thread (steady-state checks of one thread are not disturbed by the others)
+AllocationCounters GetThreadAllocationCounters();
+
+// Called on every heap allocation of any thread, nullptr - no hook. The hook must not allocate itself.
+// A debugger breakpoint in a hook finds the allocations of a frame that should have none.
+using AllocationHook = void(*)(size_t size);
+void SetAllocationHook(AllocationHook hook);
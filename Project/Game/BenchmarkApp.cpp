@@ -0,0 +1,276 @@
+#include "BenchmarkApp.h"
+
+#include <cstdio>
+#include <fstream>
+
+//-----------------------------------------------------------------------------
+namespace
+{
+	bool parseObjectCounts(const char* text, std::vector<uint32_t>& counts)
+	{
+		counts.clear();
+		while (*text)
+		{
+			char* end = nullptr;
+			const unsigned long value = strtoul(text, &end, 10);
+			if (end == text || value == 0) return false;
+			counts.push_back(static_cast<uint32_t>(value));
+			text = (*end == ',') ? end + 1 : end;
+			if (*end != ',' && *end != '\0') return false;
+		}
+		return !counts.empty();
+	}
+
+	// the objects spin about the vertical axis, each with its own phase
+	struct SpinComponent
+	{
+		float phase = 0.0f;
+	};
+
+	// nearest rank of a sorted array
+	float percentile(const std::vector<float>& sorted, float p)
+	{
+		if (sorted.empty()) return 0.0f;
+		const size_t rank = static_cast<size_t>(std::ceil(p * static_cast<float>(sorted.size())));
+		return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+	}
+}
+//-----------------------------------------------------------------------------
+bool ParseBenchmarkArgs(int argc, char* argv[], BenchmarkSettings& settings)
+{
+	bool benchmark = false;
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+		const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+		if (arg == "--benchmark")
+		{
+			benchmark = true;
+			continue;
+		}
+		if (!value)
+		{
+			Warning("Missing value of the argument " + arg);
+			break;
+		}
+		i++;
+		if (arg == "--frames")
+			settings.frames = std::max(1u, static_cast<uint32_t>(strtoul(value, nullptr, 10)));
+		else if (arg == "--warmup")
+			settings.warmupFrames = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+		else if (arg == "--objects")
+		{
+			if (!parseObjectCounts(value, settings.objectCounts))
+			{
+				Warning("Invalid --objects list, the default is used");
+				settings.objectCounts = BenchmarkSettings().objectCounts;
+			}
+		}
+		else if (arg == "--adapter")
+		{
+			const std::string adapter = value;
+			if (adapter == "gpu") settings.adapter = HeadlessAdapter::Default;
+			else if (adapter == "cpu") settings.adapter = HeadlessAdapter::Cpu;
+			else if (adapter == "null") settings.adapter = HeadlessAdapter::Null;
+			else Warning("Unknown adapter " + adapter + ", use gpu, cpu or null");
+		}
+		else if (arg == "--size")
+		{
+			unsigned width = 0, height = 0;
+			if (sscanf(value, "%ux%u", &width, &height) == 2 && width > 0 && height > 0)
+			{
+				settings.width = width;
+				settings.height = height;
+			}
+			else
+				Warning("Invalid --size, use WIDTHxHEIGHT");
+		}
+		else if (arg == "--report")
+			settings.reportFile = value;
+		else
+		{
+			Warning("Unknown argument " + arg);
+			i--;
+		}
+	}
+	return benchmark;
+}
+//-----------------------------------------------------------------------------
+AppCreateInfo BenchmarkApp::GetCreateInfo()
+{
+	AppCreateInfo info;
+	info.headless.enabled = true;
+	info.headless.width = m_settings.width;
+	info.headless.height = m_settings.height;
+	info.headless.adapter = m_settings.adapter;
+	// the render stats are read between the frames
+	info.renderThreadMode = RenderThreadMode::SingleThread;
+	return info;
+}
+//-----------------------------------------------------------------------------
+bool BenchmarkApp::Init()
+{
+	Print("Benchmark: " + std::to_string(m_settings.objectCounts.size()) + " scenarios, "
+		+ std::to_string(m_settings.warmupFrames) + " warmup + " + std::to_string(m_settings.frames) + " frames");
+	m_frameTimes.reserve(m_settings.frames);
+	beginScenario(0.0);
+	return true;
+}
+//-----------------------------------------------------------------------------
+void BenchmarkApp::Close()
+{
+}
+//-----------------------------------------------------------------------------
+void BenchmarkApp::Update()
+{
+}
+//-----------------------------------------------------------------------------
+void BenchmarkApp::Frame()
+{
+	FramePacket& packet = GetFramePacket();
+
+	// the time since the previous Frame covers the whole engine frame (single thread mode)
+	const auto now = std::chrono::steady_clock::now();
+	const AllocationCounters allocations = GetAllocationCounters();
+	if (m_frame > m_settings.warmupFrames)
+	{
+		m_frameTimes.push_back(std::chrono::duration<float, std::milli>(now - m_lastFrame).count());
+		const RenderStats& stats = GetRenderStats();
+		m_drawCalls += stats.drawCalls;
+		m_uploads += stats.bufferUploads + stats.textureUploads;
+		m_uploadBytes += stats.uploadBytes;
+		m_allocations += allocations.allocations - m_lastAllocations.allocations;
+	}
+	m_lastFrame = now;
+	m_lastAllocations = allocations;
+
+	if (m_frame == m_settings.warmupFrames + m_settings.frames)
+	{
+		endScenario();
+		if (++m_scenario == m_settings.objectCounts.size())
+		{
+			report();
+			Exit();
+			return;
+		}
+		beginScenario(packet.time);
+	}
+	m_frame++;
+
+	// camera orbits the grid, one turn per 20 seconds of the deterministic clock
+	const float time = static_cast<float>(packet.time - m_scenarioStart);
+	const float gridSize = std::cbrt(static_cast<float>(m_settings.objectCounts[m_scenario]));
+	const float radius = gridSize * 1.5f + 4.0f;
+	const float angle = time * glm::two_pi<float>() / 20.0f;
+	const glm::vec3 eye = { radius * std::cos(angle), radius * 0.4f * std::sin(angle * 0.5f), radius * std::sin(angle) };
+	packet.view = glm::lookAt(eye, glm::vec3(0.0f), { 0.0f, 1.0f, 0.0f });
+	packet.projection = glm::perspective(glm::radians(60.0f), static_cast<float>(m_settings.width) / static_cast<float>(m_settings.height), 0.1f, radius * 4.0f);
+
+	m_world.ParallelEach<SpinComponent, RotationComponent, TransformDirtyComponent>(GetJobSystem(), 0,
+		[time](Entity, const SpinComponent& spin, RotationComponent& rotation, TransformDirtyComponent& dirty)
+		{
+			rotation.value = glm::angleAxis(time + spin.phase, glm::vec3(0.0f, 1.0f, 0.0f));
+			dirty.value = true;
+		});
+	UpdateWorldMatrices(m_world, GetJobSystem());
+	const Frustum frustum = ExtractFrustum(packet.projection * packet.view);
+	CollectDrawItems(m_world, packet, &frustum);
+
+	// the static nodes are computed by the first Update of the scenario only
+	m_sceneGraph.Update();
+	m_sceneGraph.QueryVisible(frustum, m_visibleNodes);
+	for (SceneNodeId node : m_visibleNodes)
+	{
+		FrameDrawItem& item = packet.drawItems.emplace_back();
+		item.transform = m_sceneGraph.GetWorldMatrix(node);
+		item.material = m_nodeMaterials[node];
+	}
+}
+//-----------------------------------------------------------------------------
+void BenchmarkApp::beginScenario(double time)
+{
+	// objects on a cube-shaped grid centered at the origin, one unit apart: the even ones spin, the odd ones are static
+	const uint32_t count = m_settings.objectCounts[m_scenario];
+	const uint32_t side = static_cast<uint32_t>(std::ceil(std::cbrt(static_cast<double>(count))));
+	const float offset = static_cast<float>(side - 1) * 0.5f;
+	const glm::vec3 scale = glm::vec3(0.25f);
+	BoundingBox bounds; // the 2x2x2 box of the Render sample
+	bounds.min = glm::vec3(-1.0f);
+	bounds.max = glm::vec3(1.0f);
+	m_world.Clear();
+	m_sceneGraph = SceneGraph();
+	m_nodeMaterials.clear();
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const uint32_t x = i % side;
+		const uint32_t y = (i / side) % side;
+		const uint32_t z = i / (side * side);
+		const glm::vec3 position = { static_cast<float>(x) - offset, static_cast<float>(y) - offset, static_cast<float>(z) - offset };
+		if (i % 2)
+		{
+			const SceneNodeId node = m_sceneGraph.CreateNode();
+			m_sceneGraph.SetLocalTransform(node, position, glm::identity<glm::quat>(), scale);
+			m_sceneGraph.SetLocalBounds(node, bounds);
+			m_nodeMaterials.resize(node + 1);
+			m_nodeMaterials[node] = i;
+			continue;
+		}
+		RenderComponent render;
+		render.material = i;
+		render.bounds = bounds;
+		m_world.Create(PositionComponent{ position }, RotationComponent(), ScaleComponent{ scale }, TransformDirtyComponent(), WorldMatrixComponent(), render, SpinComponent{ static_cast<float>(i) });
+	}
+
+	m_scenarioStart = time;
+	m_frame = 0;
+	m_frameTimes.clear();
+	m_drawCalls = m_uploads = m_uploadBytes = m_allocations = 0;
+}
+//-----------------------------------------------------------------------------
+void BenchmarkApp::endScenario()
+{
+	std::sort(m_frameTimes.begin(), m_frameTimes.end());
+	const double frames = static_cast<double>(std::max<size_t>(m_frameTimes.size(), 1));
+
+	ScenarioResult result;
+	result.objectCount = m_settings.objectCounts[m_scenario];
+	result.frames = static_cast<uint32_t>(m_frameTimes.size());
+	result.p50 = percentile(m_frameTimes, 0.50f);
+	result.p90 = percentile(m_frameTimes, 0.90f);
+	result.p99 = percentile(m_frameTimes, 0.99f);
+	result.max = m_frameTimes.empty() ? 0.0f : m_frameTimes.back();
+	result.drawCalls = static_cast<double>(m_drawCalls) / frames;
+	result.uploads = static_cast<double>(m_uploads) / frames;
+	result.uploadBytes = static_cast<double>(m_uploadBytes) / frames;
+	result.allocations = static_cast<double>(m_allocations) / frames;
+	m_results.push_back(result);
+}
+//-----------------------------------------------------------------------------
+void BenchmarkApp::report() const
+{
+	char line[256];
+	Print("objects  frames   p50 ms   p90 ms   p99 ms   max ms    draws  uploads  upload KB   allocs");
+	for (const ScenarioResult& r : m_results)
+	{
+		snprintf(line, sizeof(line), "%7u  %6u  %7.3f  %7.3f  %7.3f  %7.3f  %7.1f  %7.1f  %9.1f  %7.1f",
+			r.objectCount, r.frames, r.p50, r.p90, r.p99, r.max, r.drawCalls, r.uploads, r.uploadBytes / 1024.0, r.allocations);
+		Print(line);
+	}
+
+	if (m_settings.reportFile.empty()) return;
+	std::ofstream file(m_settings.reportFile, std::ios::trunc);
+	if (!file)
+	{
+		Error("Could not create file: " + m_settings.reportFile.string());
+		return;
+	}
+	file << "objects,frames,p50_ms,p90_ms,p99_ms,max_ms,draw_calls,uploads,upload_bytes,allocations\n";
+	for (const ScenarioResult& r : m_results)
+	{
+		snprintf(line, sizeof(line), "%u,%u,%.4f,%.4f,%.4f,%.4f,%.2f,%.2f,%.1f,%.2f\n",
+			r.objectCount, r.frames, r.p50, r.p90, r.p99, r.max, r.drawCalls, r.uploads, r.uploadBytes, r.allocations);
+		file << line;
+	}
+	Print("Benchmark report saved: " + m_settings.reportFile.string());
+}
+//-----------------------------------------------------------------------------
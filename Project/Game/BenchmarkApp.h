@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Engine.h"
+#include "AllocationCounter.h"
+
+#include <chrono>
+
+// Command line of the benchmark mode:
+// Game --benchmark [--frames N] [--warmup N] [--objects 100,1000,10000] [--adapter gpu|cpu|null] [--size 1280x720] [--report file.csv]
+struct BenchmarkSettings
+{
+	std::vector<uint32_t> objectCounts = { 100, 1000, 10000 };
+	uint32_t warmupFrames = 30;
+	uint32_t frames = 300;
+	HeadlessAdapter adapter = HeadlessAdapter::Cpu;
+	uint32_t width = 1280;
+	uint32_t height = 720;
+	std::filesystem::path reportFile; // CSV, one row per scenario
+};
+
+// false when the command line has no --benchmark
+bool ParseBenchmarkArgs(int argc, char* argv[], BenchmarkSettings& settings);
+
+// Runs the scene of the built Render sample headless, once per object count, with a fixed camera path and the
+// deterministic headless clock - two runs of the same build draw the same frames. Half of the objects spin (ECS entities),
+// the other half is static (SceneGraph nodes, culled by its BVH). Reports the CPU frame time percentiles and the draw calls,
+// uploads (buffer and texture writes) and heap allocations per frame.
+class BenchmarkApp final : public IApp
+{
+public:
+	BenchmarkApp(Engine& engine, const BenchmarkSettings& settings) : IApp(engine), m_settings(settings) {}
+	AppCreateInfo GetCreateInfo() final;
+
+	bool Init() final;
+	void Close() final;
+	void Update() final;
+	void Frame() final;
+
+private:
+	struct ScenarioResult
+	{
+		uint32_t objectCount = 0;
+		uint32_t frames = 0;
+		float p50 = 0.0f; // ms
+		float p90 = 0.0f;
+		float p99 = 0.0f;
+		float max = 0.0f;
+		double drawCalls = 0.0;   // per frame
+		double uploads = 0.0;     // buffer and texture writes
+		double uploadBytes = 0.0;
+		double allocations = 0.0;
+	};
+
+	void beginScenario(double time);
+	void endScenario();
+	void report() const;
+
+	BenchmarkSettings m_settings;
+	std::vector<ScenarioResult> m_results;
+
+	size_t m_scenario = 0;
+	uint32_t m_frame = 0; // of the scenario, warmup included
+	double m_scenarioStart = 0.0;
+	World m_world; // the spinning objects
+	SceneGraph m_sceneGraph; // the static objects
+	std::vector<uint32_t> m_nodeMaterials; // by scene node id
+	std::vector<SceneNodeId> m_visibleNodes;
+
+	std::chrono::steady_clock::time_point m_lastFrame;
+	AllocationCounters m_lastAllocations;
+	std::vector<float> m_frameTimes;
+	uint64_t m_drawCalls = 0;
+	uint64_t m_uploads = 0;
+	uint64_t m_uploadBytes = 0;
+	uint64_t m_allocations = 0;
+};
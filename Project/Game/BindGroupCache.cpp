@@ -0,0 +1,135 @@
+#include "Engine.h"
+
+#include <cassert>
+
+//-----------------------------------------------------------------------------
+void BindGroupCache::Create(const wgpu::Device& device)
+{
+	m_device = device;
+}
+//-----------------------------------------------------------------------------
+void BindGroupCache::Destroy()
+{
+	m_bindGroups.clear();
+	m_bindGroupLayouts.clear();
+	m_samplers.clear();
+	m_device = nullptr;
+}
+//-----------------------------------------------------------------------------
+wgpu::Sampler BindGroupCache::GetSampler(const wgpu::SamplerDescriptor& descriptor)
+{
+	return getObject(m_samplers, descriptor, [this](const wgpu::SamplerDescriptor& desc) { return m_device.CreateSampler(&desc); });
+}
+//-----------------------------------------------------------------------------
+wgpu::BindGroupLayout BindGroupCache::GetBindGroupLayout(const wgpu::BindGroupLayoutDescriptor& descriptor)
+{
+	return getObject(m_bindGroupLayouts, descriptor, [this](const wgpu::BindGroupLayoutDescriptor& desc) { return m_device.CreateBindGroupLayout(&desc); });
+}
+//-----------------------------------------------------------------------------
+wgpu::BindGroup BindGroupCache::GetBindGroup(const wgpu::BindGroupDescriptor& descriptor)
+{
+	return getObject(m_bindGroups, descriptor, [this](const wgpu::BindGroupDescriptor& desc) { return m_device.CreateBindGroup(&desc); });
+}
+//-----------------------------------------------------------------------------
+template<typename T, typename Descriptor, typename CreateFunction>
+T BindGroupCache::getObject(std::unordered_map<uint64_t, Entry<T>>& entries, const Descriptor& descriptor, CreateFunction create)
+{
+	std::string key;
+	DescriptorHasher hasher;
+	hasher.key = &key;
+	hashDescriptor(descriptor, hasher);
+	if (hasher.chained)
+	{
+		Error("Bind group cache: the descriptor has chained structs, the object is not cached");
+		m_missCount++;
+		return create(descriptor);
+	}
+
+	Entry<T>& entry = entries[hasher.hash];
+	if (entry.object)
+	{
+		if (entry.key == key)
+		{
+			m_hitCount++;
+			return entry.object;
+		}
+		Error("Bind group cache: hash collision of two different descriptors");
+		assert(!"bind group cache descriptor hash collision");
+		m_missCount++;
+		return create(descriptor);
+	}
+	m_missCount++;
+	entry.object = create(descriptor);
+	entry.key = std::move(key);
+	return entry.object;
+}
+//-----------------------------------------------------------------------------
+void BindGroupCache::ClearBindGroups()
+{
+	m_bindGroups.clear();
+}
+//-----------------------------------------------------------------------------
+void BindGroupCache::hashDescriptor(const wgpu::SamplerDescriptor& descriptor, DescriptorHasher& hasher)
+{
+	// the C++ structures have the layout of the C ones
+	const WGPUSamplerDescriptor& desc = reinterpret_cast<const WGPUSamplerDescriptor&>(descriptor);
+	hasher.AddChain(desc.nextInChain);
+	hasher.Add(desc.addressModeU);
+	hasher.Add(desc.addressModeV);
+	hasher.Add(desc.addressModeW);
+	hasher.Add(desc.magFilter);
+	hasher.Add(desc.minFilter);
+	hasher.Add(desc.mipmapFilter);
+	hasher.Add(desc.lodMinClamp);
+	hasher.Add(desc.lodMaxClamp);
+	hasher.Add(desc.compare);
+	hasher.Add(desc.maxAnisotropy);
+}
+//-----------------------------------------------------------------------------
+void BindGroupCache::hashDescriptor(const wgpu::BindGroupLayoutDescriptor& descriptor, DescriptorHasher& hasher)
+{
+	const WGPUBindGroupLayoutDescriptor& desc = reinterpret_cast<const WGPUBindGroupLayoutDescriptor&>(descriptor);
+	hasher.AddChain(desc.nextInChain);
+	hasher.Add(desc.entryCount);
+	for (size_t i = 0; i < desc.entryCount; i++)
+	{
+		const WGPUBindGroupLayoutEntry& entry = desc.entries[i];
+		hasher.AddChain(entry.nextInChain);
+		hasher.AddChain(entry.buffer.nextInChain);
+		hasher.AddChain(entry.sampler.nextInChain);
+		hasher.AddChain(entry.texture.nextInChain);
+		hasher.AddChain(entry.storageTexture.nextInChain);
+		hasher.Add(entry.binding);
+		hasher.Add(entry.visibility);
+		hasher.Add(entry.buffer.type);
+		hasher.Add(entry.buffer.hasDynamicOffset);
+		hasher.Add(entry.buffer.minBindingSize);
+		hasher.Add(entry.sampler.type);
+		hasher.Add(entry.texture.sampleType);
+		hasher.Add(entry.texture.viewDimension);
+		hasher.Add(entry.texture.multisampled);
+		hasher.Add(entry.storageTexture.access);
+		hasher.Add(entry.storageTexture.format);
+		hasher.Add(entry.storageTexture.viewDimension);
+	}
+}
+//-----------------------------------------------------------------------------
+void BindGroupCache::hashDescriptor(const wgpu::BindGroupDescriptor& descriptor, DescriptorHasher& hasher)
+{
+	const WGPUBindGroupDescriptor& desc = reinterpret_cast<const WGPUBindGroupDescriptor&>(descriptor);
+	hasher.AddChain(desc.nextInChain);
+	hasher.Add(reinterpret_cast<uintptr_t>(desc.layout));
+	hasher.Add(desc.entryCount);
+	for (size_t i = 0; i < desc.entryCount; i++)
+	{
+		const WGPUBindGroupEntry& entry = desc.entries[i];
+		hasher.AddChain(entry.nextInChain);
+		hasher.Add(entry.binding);
+		hasher.Add(reinterpret_cast<uintptr_t>(entry.buffer));
+		hasher.Add(entry.offset);
+		hasher.Add(entry.size);
+		hasher.Add(reinterpret_cast<uintptr_t>(entry.sampler));
+		hasher.Add(reinterpret_cast<uintptr_t>(entry.textureView));
+	}
+}
+//-----------------------------------------------------------------------------
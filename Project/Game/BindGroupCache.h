@@ -0,0 +1,57 @@
+#pragma once
+
+#include "PipelineCache.h"
+
+// Samplers, bind group layouts and bind groups shared by all users of the cache.
+// Every object is identified by the hash of its descriptor - a bind group by its layout and the handles, offsets and sizes
+// of its resources. A cached object keeps its resources alive, so their handles can't be reused while it is in the cache.
+// An entry also keeps the hashed bytes of its descriptor: a collision of the hashes is an Error (an assert in debug builds)
+// and gives an object that isn't cached. A descriptor with chained structs (nextInChain) is not cached either.
+class BindGroupCache
+{
+public:
+	void Create(const wgpu::Device& device);
+	void Destroy();
+
+	wgpu::Sampler GetSampler(const wgpu::SamplerDescriptor& descriptor);
+	wgpu::BindGroupLayout GetBindGroupLayout(const wgpu::BindGroupLayoutDescriptor& descriptor);
+	wgpu::BindGroup GetBindGroup(const wgpu::BindGroupDescriptor& descriptor);
+
+	// Drops the bind groups, e.g. after the resources of a level were released (the bind groups hold them)
+	void ClearBindGroups();
+
+	const wgpu::Device& GetDevice() const { return m_device; }
+	uint32_t GetHitCount() const { return m_hitCount; }
+	uint32_t GetMissCount() const { return m_missCount; }
+
+	template<typename Descriptor>
+	static uint64_t HashDescriptor(const Descriptor& descriptor)
+	{
+		DescriptorHasher hasher;
+		hashDescriptor(descriptor, hasher);
+		return hasher.hash;
+	}
+
+private:
+	template<typename T>
+	struct Entry
+	{
+		T object = nullptr;
+		std::string key; // the hashed bytes of the descriptor
+	};
+
+	static void hashDescriptor(const wgpu::SamplerDescriptor& descriptor, DescriptorHasher& hasher);
+	static void hashDescriptor(const wgpu::BindGroupLayoutDescriptor& descriptor, DescriptorHasher& hasher);
+	static void hashDescriptor(const wgpu::BindGroupDescriptor& descriptor, DescriptorHasher& hasher);
+
+	// Finds the object of the descriptor or creates it with create(descriptor)
+	template<typename T, typename Descriptor, typename CreateFunction>
+	T getObject(std::unordered_map<uint64_t, Entry<T>>& entries, const Descriptor& descriptor, CreateFunction create);
+
+	wgpu::Device m_device = nullptr;
+	std::unordered_map<uint64_t, Entry<wgpu::Sampler>> m_samplers;
+	std::unordered_map<uint64_t, Entry<wgpu::BindGroupLayout>> m_bindGroupLayouts;
+	std::unordered_map<uint64_t, Entry<wgpu::BindGroup>> m_bindGroups;
+	uint32_t m_hitCount = 0;
+	uint32_t m_missCount = 0;
+};
@@ -0,0 +1,319 @@
+#include "Engine.h"
+
+//-----------------------------------------------------------------------------
+namespace
+{
+	constexpr uint32_t kInsideBit = 0x80000000u; // Query stack entry: the node is known to be inside the frustum
+
+	BoundingBox unite(const BoundingBox& a, const BoundingBox& b)
+	{
+		BoundingBox box = a;
+		box.Add(b);
+		return box;
+	}
+
+	// half of the surface area, the cost of a node for the insertion heuristic
+	float area(const BoundingBox& box)
+	{
+		const glm::vec3 size = box.max - box.min;
+		return size.x * size.y + size.y * size.z + size.z * size.x;
+	}
+
+	bool contains(const BoundingBox& outer, const BoundingBox& inner)
+	{
+		return glm::all(glm::lessThanEqual(outer.min, inner.min)) && glm::all(glm::lessThanEqual(inner.max, outer.max));
+	}
+}
+//-----------------------------------------------------------------------------
+Bvh::Bvh(float margin)
+	: m_margin(margin)
+{
+}
+//-----------------------------------------------------------------------------
+uint32_t Bvh::Insert(const BoundingBox& box, uint32_t userData)
+{
+	const uint32_t proxy = allocateNode();
+	Node& node = m_nodes[proxy];
+	node.box.min = box.min - glm::vec3(m_margin);
+	node.box.max = box.max + glm::vec3(m_margin);
+	node.userData = userData;
+	insertLeaf(proxy);
+	m_proxyCount++;
+	return proxy;
+}
+//-----------------------------------------------------------------------------
+void Bvh::Remove(uint32_t proxy)
+{
+	removeLeaf(proxy);
+	freeNode(proxy);
+	m_proxyCount--;
+}
+//-----------------------------------------------------------------------------
+bool Bvh::Move(uint32_t proxy, const BoundingBox& box)
+{
+	if (contains(m_nodes[proxy].box, box))
+		return false;
+
+	removeLeaf(proxy);
+	m_nodes[proxy].box.min = box.min - glm::vec3(m_margin);
+	m_nodes[proxy].box.max = box.max + glm::vec3(m_margin);
+	insertLeaf(proxy);
+	return true;
+}
+//-----------------------------------------------------------------------------
+void Bvh::Clear()
+{
+	m_nodes.clear();
+	m_root = kNullProxy;
+	m_freeList = kNullProxy;
+	m_proxyCount = 0;
+}
+//-----------------------------------------------------------------------------
+void Bvh::Query(const Frustum& frustum, std::vector<uint32_t>& visible) const
+{
+	visible.clear();
+	if (m_root == kNullProxy) return;
+
+	m_stack.clear();
+	m_stack.push_back(m_root);
+	while (!m_stack.empty())
+	{
+		const uint32_t entry = m_stack.back();
+		m_stack.pop_back();
+		const Node& node = m_nodes[entry & ~kInsideBit];
+		uint32_t inside = entry & kInsideBit;
+		if (!inside)
+		{
+			const FrustumTest test = TestBox(frustum, node.box);
+			if (test == FrustumTest::Outside) continue;
+			if (test == FrustumTest::Inside) inside = kInsideBit;
+		}
+
+		if (node.IsLeaf())
+		{
+			visible.push_back(node.userData);
+		}
+		else
+		{
+			m_stack.push_back(node.child1 | inside);
+			m_stack.push_back(node.child2 | inside);
+		}
+	}
+}
+//-----------------------------------------------------------------------------
+uint32_t Bvh::allocateNode()
+{
+	uint32_t node;
+	if (m_freeList != kNullProxy)
+	{
+		node = m_freeList;
+		m_freeList = m_nodes[node].parent;
+		m_nodes[node] = Node();
+	}
+	else
+	{
+		node = static_cast<uint32_t>(m_nodes.size());
+		m_nodes.emplace_back();
+	}
+	return node;
+}
+//-----------------------------------------------------------------------------
+void Bvh::freeNode(uint32_t node)
+{
+	m_nodes[node].parent = m_freeList;
+	m_nodes[node].height = -1;
+	m_freeList = node;
+}
+//-----------------------------------------------------------------------------
+void Bvh::insertLeaf(uint32_t leaf)
+{
+	if (m_root == kNullProxy)
+	{
+		m_root = leaf;
+		m_nodes[leaf].parent = kNullProxy;
+		return;
+	}
+
+	// the sibling with the least cost: the area of the new parent plus the growth of the ancestors
+	const BoundingBox leafBox = m_nodes[leaf].box;
+	uint32_t index = m_root;
+	while (!m_nodes[index].IsLeaf())
+	{
+		const Node& node = m_nodes[index];
+		const float combinedArea = area(unite(node.box, leafBox));
+		const float cost = 2.0f * combinedArea; // a new parent of this node and the leaf
+		const float inheritanceCost = 2.0f * (combinedArea - area(node.box)); // pushed down: the node grows
+
+		auto descendCost = [&](uint32_t child)
+		{
+			const Node& childNode = m_nodes[child];
+			const float childArea = area(unite(childNode.box, leafBox));
+			return (childNode.IsLeaf() ? childArea : childArea - area(childNode.box)) + inheritanceCost;
+		};
+		const float cost1 = descendCost(node.child1);
+		const float cost2 = descendCost(node.child2);
+		if (cost < cost1 && cost < cost2)
+			break;
+		index = cost1 < cost2 ? node.child1 : node.child2;
+	}
+
+	const uint32_t sibling = index;
+	const uint32_t oldParent = m_nodes[sibling].parent;
+	const uint32_t newParent = allocateNode();
+	m_nodes[newParent].parent = oldParent;
+	m_nodes[newParent].box = unite(leafBox, m_nodes[sibling].box);
+	m_nodes[newParent].height = m_nodes[sibling].height + 1;
+	m_nodes[newParent].child1 = sibling;
+	m_nodes[newParent].child2 = leaf;
+	m_nodes[sibling].parent = newParent;
+	m_nodes[leaf].parent = newParent;
+	if (oldParent != kNullProxy)
+	{
+		if (m_nodes[oldParent].child1 == sibling)
+			m_nodes[oldParent].child1 = newParent;
+		else
+			m_nodes[oldParent].child2 = newParent;
+	}
+	else
+	{
+		m_root = newParent;
+	}
+
+	refit(newParent);
+}
+//-----------------------------------------------------------------------------
+void Bvh::removeLeaf(uint32_t leaf)
+{
+	if (leaf == m_root)
+	{
+		m_root = kNullProxy;
+		return;
+	}
+
+	// the sibling takes the place of the parent
+	const uint32_t parent = m_nodes[leaf].parent;
+	const uint32_t grandParent = m_nodes[parent].parent;
+	const uint32_t sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+	m_nodes[sibling].parent = grandParent;
+	freeNode(parent);
+	if (grandParent != kNullProxy)
+	{
+		if (m_nodes[grandParent].child1 == parent)
+			m_nodes[grandParent].child1 = sibling;
+		else
+			m_nodes[grandParent].child2 = sibling;
+		refit(grandParent);
+	}
+	else
+	{
+		m_root = sibling;
+	}
+}
+//-----------------------------------------------------------------------------
+void Bvh::refit(uint32_t node)
+{
+	for (uint32_t index = node; index != kNullProxy; index = m_nodes[index].parent)
+	{
+		index = balance(index);
+		Node& current = m_nodes[index];
+		const Node& child1 = m_nodes[current.child1];
+		const Node& child2 = m_nodes[current.child2];
+		current.height = 1 + std::max(child1.height, child2.height);
+		current.box = unite(child1.box, child2.box);
+	}
+}
+//-----------------------------------------------------------------------------
+uint32_t Bvh::balance(uint32_t indexA)
+{
+	// A with the children B and C: the taller child is rotated up when the heights differ by more than one
+	Node& a = m_nodes[indexA];
+	if (a.IsLeaf() || a.height < 2)
+		return indexA;
+
+	const uint32_t indexB = a.child1;
+	const uint32_t indexC = a.child2;
+	Node& b = m_nodes[indexB];
+	Node& c = m_nodes[indexC];
+	const int32_t difference = c.height - b.height;
+
+	auto replaceInParent = [this, indexA](uint32_t parent, uint32_t index)
+	{
+		if (parent == kNullProxy)
+			m_root = index;
+		else if (m_nodes[parent].child1 == indexA)
+			m_nodes[parent].child1 = index;
+		else
+			m_nodes[parent].child2 = index;
+	};
+
+	if (difference > 1)
+	{
+		// C up, A becomes its child together with the taller child of C
+		const uint32_t indexF = c.child1;
+		const uint32_t indexG = c.child2;
+		Node& f = m_nodes[indexF];
+		Node& g = m_nodes[indexG];
+		c.child1 = indexA;
+		c.parent = a.parent;
+		a.parent = indexC;
+		replaceInParent(c.parent, indexC);
+
+		if (f.height > g.height)
+		{
+			c.child2 = indexF;
+			a.child2 = indexG;
+			g.parent = indexA;
+			a.box = unite(b.box, g.box);
+			c.box = unite(a.box, f.box);
+			a.height = 1 + std::max(b.height, g.height);
+			c.height = 1 + std::max(a.height, f.height);
+		}
+		else
+		{
+			c.child2 = indexG;
+			a.child2 = indexF;
+			f.parent = indexA;
+			a.box = unite(b.box, f.box);
+			c.box = unite(a.box, g.box);
+			a.height = 1 + std::max(b.height, f.height);
+			c.height = 1 + std::max(a.height, g.height);
+		}
+		return indexC;
+	}
+	if (difference < -1)
+	{
+		// B up
+		const uint32_t indexD = b.child1;
+		const uint32_t indexE = b.child2;
+		Node& d = m_nodes[indexD];
+		Node& e = m_nodes[indexE];
+		b.child1 = indexA;
+		b.parent = a.parent;
+		a.parent = indexB;
+		replaceInParent(b.parent, indexB);
+
+		if (d.height > e.height)
+		{
+			b.child2 = indexD;
+			a.child1 = indexE;
+			e.parent = indexA;
+			a.box = unite(c.box, e.box);
+			b.box = unite(a.box, d.box);
+			a.height = 1 + std::max(c.height, e.height);
+			b.height = 1 + std::max(a.height, d.height);
+		}
+		else
+		{
+			b.child2 = indexE;
+			a.child1 = indexD;
+			d.parent = indexA;
+			a.box = unite(c.box, d.box);
+			b.box = unite(a.box, e.box);
+			a.height = 1 + std::max(c.height, d.height);
+			b.height = 1 + std::max(a.height, e.height);
+		}
+		return indexB;
+	}
+	return indexA;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Culling.h"
+
+// Dynamic bounding volume hierarchy (AABB tree) over moving objects. The leaves store boxes enlarged by a margin,
+// an object that moves within its enlarged box doesn't touch the tree. Insertion picks the sibling by the surface
+// area cost and the tree is kept balanced by rotations, a frustum query visits O(log n + visible) nodes.
+// Not thread-safe.
+class Bvh
+{
+public:
+	static constexpr uint32_t kNullProxy = UINT32_MAX;
+
+	explicit Bvh(float margin = 0.1f);
+
+	// Returns the proxy of the object, userData is what Query reports for it
+	uint32_t Insert(const BoundingBox& box, uint32_t userData);
+	void Remove(uint32_t proxy);
+	// Returns true when the leaf was reinserted (the box left the enlarged leaf box)
+	bool Move(uint32_t proxy, const BoundingBox& box);
+	void Clear();
+
+	uint32_t GetUserData(uint32_t proxy) const { return m_nodes[proxy].userData; }
+	// The enlarged box of the leaf
+	const BoundingBox& GetBounds(uint32_t proxy) const { return m_nodes[proxy].box; }
+	uint32_t GetProxyCount() const { return m_proxyCount; }
+	uint32_t GetHeight() const { return m_root != kNullProxy ? static_cast<uint32_t>(m_nodes[m_root].height) : 0; }
+
+	// Replaces visible with the user data of the leaves not outside the frustum. The subtree of a node
+	// inside the frustum is taken without further tests. The capacity of visible is reused from frame to frame.
+	void Query(const Frustum& frustum, std::vector<uint32_t>& visible) const;
+
+private:
+	struct Node
+	{
+		BoundingBox box;
+		uint32_t parent = kNullProxy; // next free node while in the free list
+		uint32_t child1 = kNullProxy;
+		uint32_t child2 = kNullProxy;
+		int32_t height = 0; // leaf - 0, free - -1
+		uint32_t userData = 0;
+
+		bool IsLeaf() const { return child1 == kNullProxy; }
+	};
+
+	uint32_t allocateNode();
+	void freeNode(uint32_t node);
+	void insertLeaf(uint32_t leaf);
+	void removeLeaf(uint32_t leaf);
+	uint32_t balance(uint32_t node);
+	void refit(uint32_t node);
+
+	std::vector<Node> m_nodes;
+	uint32_t m_root = kNullProxy;
+	uint32_t m_freeList = kNullProxy;
+	uint32_t m_proxyCount = 0;
+	float m_margin = 0.1f;
+	mutable std::vector<uint32_t> m_stack; // of Query, kept to not allocate every frame
+};
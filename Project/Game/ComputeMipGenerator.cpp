@@ -0,0 +1,305 @@
+#include "Engine.h"
+
+//-----------------------------------------------------------------------------
+// FORMAT is replaced by the storage format. A 16x16 workgroup reads a 32x32 block of the source level.
+static const char* ComputeMipShader = R"(
+override outputLevelCount : u32 = 4u;
+
+@group(0) @binding(0) var srcLevel : texture_2d<f32>;
+@group(0) @binding(1) var dstLevel1 : texture_storage_2d<FORMAT, write>;
+@group(0) @binding(2) var dstLevel2 : texture_storage_2d<FORMAT, write>;
+@group(0) @binding(3) var dstLevel3 : texture_storage_2d<FORMAT, write>;
+@group(0) @binding(4) var dstLevel4 : texture_storage_2d<FORMAT, write>;
+
+var<workgroup> tile : array<vec4f, 256>;
+
+fn loadSource(coord : vec2u, size : vec2u) -> vec4f
+{
+	return textureLoad(srcLevel, min(coord, size - 1u), 0);
+}
+
+@compute @workgroup_size(16, 16)
+fn main(@builtin(global_invocation_id) id : vec3u, @builtin(local_invocation_id) local : vec3u)
+{
+	let srcSize = textureDimensions(srcLevel);
+	let p = id.xy * 2u;
+	var color = (loadSource(p, srcSize) + loadSource(p + vec2u(1u, 0u), srcSize) + loadSource(p + vec2u(0u, 1u), srcSize) + loadSource(p + vec2u(1u, 1u), srcSize)) * 0.25;
+	if (all(id.xy < textureDimensions(dstLevel1)))
+	{
+		textureStore(dstLevel1, id.xy, color);
+	}
+
+	// every next level is reduced by a quarter of the threads, each one owns the top left texel of its block
+	let index = local.y * 16u + local.x;
+	tile[index] = color;
+	workgroupBarrier();
+
+	if (outputLevelCount > 1u && (local.x & 1u) == 0u && (local.y & 1u) == 0u)
+	{
+		color = (tile[index] + tile[index + 1u] + tile[index + 16u] + tile[index + 17u]) * 0.25;
+		let coord = id.xy / 2u;
+		if (all(coord < textureDimensions(dstLevel2)))
+		{
+			textureStore(dstLevel2, coord, color);
+		}
+		tile[index] = color;
+	}
+	workgroupBarrier();
+
+	if (outputLevelCount > 2u && (local.x & 3u) == 0u && (local.y & 3u) == 0u)
+	{
+		color = (tile[index] + tile[index + 2u] + tile[index + 32u] + tile[index + 34u]) * 0.25;
+		let coord = id.xy / 4u;
+		if (all(coord < textureDimensions(dstLevel3)))
+		{
+			textureStore(dstLevel3, coord, color);
+		}
+		tile[index] = color;
+	}
+	workgroupBarrier();
+
+	if (outputLevelCount > 3u && (local.x & 7u) == 0u && (local.y & 7u) == 0u)
+	{
+		color = (tile[index] + tile[index + 4u] + tile[index + 64u] + tile[index + 68u]) * 0.25;
+		let coord = id.xy / 8u;
+		if (all(coord < textureDimensions(dstLevel4)))
+		{
+			textureStore(dstLevel4, coord, color);
+		}
+	}
+}
+)";
+//-----------------------------------------------------------------------------
+constexpr uint32_t ComputeMipWorkgroupSize = 16;
+//-----------------------------------------------------------------------------
+static const char* getStorageFormatName(wgpu::TextureFormat format)
+{
+	switch (format)
+	{
+	case wgpu::TextureFormat::RGBA8Unorm: return "rgba8unorm";
+	case wgpu::TextureFormat::RGBA16Float: return "rgba16float";
+	case wgpu::TextureFormat::RGBA32Float: return "rgba32float";
+	default: return nullptr;
+	}
+}
+//-----------------------------------------------------------------------------
+bool ComputeMipGenerator::Create(const wgpu::Device& device)
+{
+	m_device = device;
+	m_formats.clear();
+	return m_device != nullptr;
+}
+//-----------------------------------------------------------------------------
+void ComputeMipGenerator::Destroy()
+{
+	m_formats.clear();
+	m_device = nullptr;
+}
+//-----------------------------------------------------------------------------
+bool ComputeMipGenerator::IsSupported(wgpu::TextureFormat format) const
+{
+	return m_enabled && m_device && getStorageFormatName(format) != nullptr;
+}
+//-----------------------------------------------------------------------------
+bool ComputeMipGenerator::Generate(const wgpu::Texture& texture)
+{
+	const wgpu::TextureFormat format = texture.GetFormat();
+	if (!IsSupported(format))
+		return false;
+	if (texture.GetDimension() != wgpu::TextureDimension::e2D)
+	{
+		Error("Generating mipmaps for non-2d textures is currently unsupported!");
+		return false;
+	}
+	if (!(texture.GetUsage() & wgpu::TextureUsage::StorageBinding) || !(texture.GetUsage() & wgpu::TextureUsage::TextureBinding))
+	{
+		Error("ComputeMipGenerator: the texture needs TextureBinding and StorageBinding usage");
+		return false;
+	}
+
+	const uint32_t mipLevelCount = texture.GetMipLevelCount();
+	if (mipLevelCount < 2) return true;
+
+	FormatPipelines* pipelines = getPipelines(format);
+	if (!pipelines) return false;
+
+	auto createLevelView = [&](uint32_t level, uint32_t layer)
+		{
+			wgpu::TextureViewDescriptor viewDesc{};
+			viewDesc.format = format;
+			viewDesc.dimension = wgpu::TextureViewDimension::e2D;
+			viewDesc.baseMipLevel = level;
+			viewDesc.mipLevelCount = 1;
+			viewDesc.baseArrayLayer = layer;
+			viewDesc.arrayLayerCount = 1;
+			return texture.CreateView(&viewDesc);
+		};
+
+	wgpu::CommandEncoder encoder = m_device.CreateCommandEncoder();
+	wgpu::ComputePassEncoder pass = encoder.BeginComputePass();
+	const uint32_t layerCount = texture.GetDepthOrArrayLayers();
+	for (uint32_t layer = 0; layer < layerCount; layer++)
+	{
+		// every dispatch is a separate usage scope, so the next one may read what the previous one wrote
+		for (uint32_t srcLevel = 0; srcLevel + 1 < mipLevelCount; srcLevel += LevelsPerDispatch)
+		{
+			const uint32_t outputLevelCount = std::min(LevelsPerDispatch, mipLevelCount - 1 - srcLevel);
+
+			wgpu::BindGroupEntry entries[1 + LevelsPerDispatch];
+			entries[0].binding = 0;
+			entries[0].textureView = createLevelView(srcLevel, layer);
+			for (uint32_t i = 0; i < LevelsPerDispatch; i++)
+			{
+				entries[1 + i].binding = 1 + i;
+				entries[1 + i].textureView = i < outputLevelCount ? createLevelView(srcLevel + 1 + i, layer) : pipelines->dummyView;
+			}
+
+			wgpu::BindGroupDescriptor bindGroupDesc{};
+			bindGroupDesc.layout = pipelines->bindGroupLayout;
+			bindGroupDesc.entryCount = 1 + LevelsPerDispatch;
+			bindGroupDesc.entries = entries;
+			wgpu::BindGroup bindGroup = m_device.CreateBindGroup(&bindGroupDesc);
+
+			const uint32_t dstWidth = std::max(1u, texture.GetWidth() >> (srcLevel + 1));
+			const uint32_t dstHeight = std::max(1u, texture.GetHeight() >> (srcLevel + 1));
+			pass.SetPipeline(pipelines->pipelines[outputLevelCount - 1]);
+			pass.SetBindGroup(0, bindGroup);
+			pass.DispatchWorkgroups((dstWidth + ComputeMipWorkgroupSize - 1) / ComputeMipWorkgroupSize, (dstHeight + ComputeMipWorkgroupSize - 1) / ComputeMipWorkgroupSize);
+		}
+	}
+	pass.End();
+
+	wgpu::CommandBuffer commands = encoder.Finish();
+	m_device.GetQueue().Submit(1, &commands);
+	return m_validate ? validate(texture) : true;
+}
+//-----------------------------------------------------------------------------
+bool ComputeMipGenerator::validate(const wgpu::Texture& texture) const
+{
+	if (texture.GetFormat() != wgpu::TextureFormat::RGBA8Unorm || !(texture.GetUsage() & wgpu::TextureUsage::CopySrc))
+	{
+		Warning("ComputeMipGenerator: validation needs a rgba8unorm texture with CopySrc usage, skipped");
+		return true;
+	}
+
+	CapturedImage source;
+	if (!ReadTexture(m_device, texture, source))
+		return false;
+
+	// The shader clamps the 2x2 footprint at an odd edge, MipChain averages the 3 last texels:
+	// only the levels made from a source level with even sizes are compared.
+	uint32_t levelCount = 1;
+	for (uint32_t width = source.width, height = source.height; levelCount < texture.GetMipLevelCount() && width % 2 == 0 && height % 2 == 0; levelCount++)
+	{
+		width /= 2;
+		height /= 2;
+	}
+	MipChain mipChain;
+	mipChain.Generate(source.pixels.data(), source.width, source.height, levelCount);
+
+	// the levels of one dispatch are filtered from the unrounded values of the previous one, MipChain rounds every level
+	constexpr uint8_t kTolerance = 2;
+	bool valid = true;
+	for (uint32_t level = 1; level < levelCount; level++)
+	{
+		CapturedImage gpuLevel;
+		if (!ReadTexture(m_device, texture, gpuLevel, level))
+			return false;
+
+		CapturedImage cpuLevel;
+		cpuLevel.width = mipChain.GetLevel(level).width;
+		cpuLevel.height = mipChain.GetLevel(level).height;
+		cpuLevel.pixels.assign(mipChain.GetLevelData(level), mipChain.GetLevelData(level) + mipChain.GetLevelSize(level));
+
+		const ImageCompareResult result = CompareImages(gpuLevel, cpuLevel, kTolerance);
+		if (!result.sizeMatch || result.differentPixels > 0)
+		{
+			Error("ComputeMipGenerator: level " + std::to_string(level) + " differs from the CPU mip chain in "
+				+ std::to_string(result.differentPixels) + " pixels (max difference " + std::to_string(result.maxDifference) + ")");
+			valid = false;
+		}
+	}
+	return valid;
+}
+//-----------------------------------------------------------------------------
+ComputeMipGenerator::FormatPipelines* ComputeMipGenerator::getPipelines(wgpu::TextureFormat format)
+{
+	for (auto& pipelines : m_formats)
+	{
+		if (pipelines.format == format)
+			return &pipelines;
+	}
+
+	FormatPipelines pipelines;
+	pipelines.format = format;
+
+	wgpu::BindGroupLayoutEntry layoutEntries[1 + LevelsPerDispatch];
+	layoutEntries[0].binding = 0;
+	layoutEntries[0].visibility = wgpu::ShaderStage::Compute;
+	layoutEntries[0].texture.sampleType = wgpu::TextureSampleType::UnfilterableFloat;
+	layoutEntries[0].texture.viewDimension = wgpu::TextureViewDimension::e2D;
+	for (uint32_t i = 1; i <= LevelsPerDispatch; i++)
+	{
+		layoutEntries[i].binding = i;
+		layoutEntries[i].visibility = wgpu::ShaderStage::Compute;
+		layoutEntries[i].storageTexture.access = wgpu::StorageTextureAccess::WriteOnly;
+		layoutEntries[i].storageTexture.format = format;
+		layoutEntries[i].storageTexture.viewDimension = wgpu::TextureViewDimension::e2D;
+	}
+	wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc{};
+	bindGroupLayoutDesc.entryCount = 1 + LevelsPerDispatch;
+	bindGroupLayoutDesc.entries = layoutEntries;
+	pipelines.bindGroupLayout = m_device.CreateBindGroupLayout(&bindGroupLayoutDesc);
+
+	wgpu::PipelineLayoutDescriptor pipelineLayoutDesc{};
+	pipelineLayoutDesc.bindGroupLayoutCount = 1;
+	pipelineLayoutDesc.bindGroupLayouts = &pipelines.bindGroupLayout;
+	wgpu::PipelineLayout pipelineLayout = m_device.CreatePipelineLayout(&pipelineLayoutDesc);
+
+	std::string source = ComputeMipShader;
+	const std::string formatName = getStorageFormatName(format);
+	for (size_t pos = source.find("FORMAT"); pos != std::string::npos; pos = source.find("FORMAT", pos))
+		source.replace(pos, 6, formatName);
+
+	wgpu::ShaderModuleWGSLDescriptor wgslDesc{};
+	wgslDesc.code = source.c_str();
+	wgpu::ShaderModuleDescriptor shaderModuleDesc{};
+	shaderModuleDesc.nextInChain = &wgslDesc;
+	wgpu::ShaderModule shaderModule = m_device.CreateShaderModule(&shaderModuleDesc);
+	if (!shaderModule)
+	{
+		Error("ComputeMipGenerator: could not create shader module");
+		return nullptr;
+	}
+
+	for (uint32_t i = 0; i < LevelsPerDispatch; i++)
+	{
+		wgpu::ConstantEntry constant{};
+		constant.key = "outputLevelCount";
+		constant.value = static_cast<double>(i + 1);
+
+		wgpu::ComputePipelineDescriptor pipelineDesc{};
+		pipelineDesc.label = "compute_mip_pipeline";
+		pipelineDesc.layout = pipelineLayout;
+		pipelineDesc.compute.module = shaderModule;
+		pipelineDesc.compute.entryPoint = "main";
+		pipelineDesc.compute.constantCount = 1;
+		pipelineDesc.compute.constants = &constant;
+		pipelines.pipelines[i] = m_device.CreateComputePipeline(&pipelineDesc);
+		if (!pipelines.pipelines[i])
+		{
+			Error("ComputeMipGenerator: could not create compute pipeline");
+			return nullptr;
+		}
+	}
+
+	wgpu::TextureDescriptor dummyDesc{};
+	dummyDesc.usage = wgpu::TextureUsage::StorageBinding;
+	dummyDesc.size = { 1, 1, 1 };
+	dummyDesc.format = format;
+	pipelines.dummyView = m_device.CreateTexture(&dummyDesc).CreateView();
+
+	m_formats.push_back(std::move(pipelines));
+	return &m_formats.back();
+}
+//-----------------------------------------------------------------------------
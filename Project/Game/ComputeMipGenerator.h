@@ -0,0 +1,48 @@
+#pragma once
+
+#include "RenderResources.h"
+
+// Mip generation with a compute shader: one dispatch builds up to 4 levels (2x2 box filter, the intermediate levels stay in workgroup memory).
+// Only formats with write-only storage texture support are handled, everything else has to use the CPU path (MipChain).
+class ComputeMipGenerator
+{
+public:
+	static constexpr uint32_t LevelsPerDispatch = 4;
+
+	bool Create(const wgpu::Device& device);
+	void Destroy();
+
+	// CPU fallback toggle: a disabled generator doesn't support any format
+	void SetEnabled(bool enabled) { m_enabled = enabled; }
+	bool IsEnabled() const { return m_enabled; }
+
+	// Debug check: Generate reads the levels back and compares them with MipChain (CPU) built from level 0.
+	// Only rgba8unorm textures with CopySrc usage are checked. Waits for the GPU, for tests and headless runs.
+	void SetValidation(bool validate) { m_validate = validate; }
+	bool IsValidationEnabled() const { return m_validate; }
+
+	// rgba8unorm, rgba16float, rgba32float
+	bool IsSupported(wgpu::TextureFormat format) const;
+
+	// Fills levels 1..N-1 of every layer of a 2D texture from level 0 and submits the work.
+	// The texture needs TextureBinding and StorageBinding usage.
+	bool Generate(const wgpu::Texture& texture);
+
+private:
+	struct FormatPipelines
+	{
+		wgpu::TextureFormat format = wgpu::TextureFormat::Undefined;
+		wgpu::BindGroupLayout bindGroupLayout = nullptr;
+		// [i] - writes i + 1 levels
+		wgpu::ComputePipeline pipelines[LevelsPerDispatch];
+		// bound to the unused outputs of the last dispatch
+		wgpu::TextureView dummyView = nullptr;
+	};
+	FormatPipelines* getPipelines(wgpu::TextureFormat format);
+	bool validate(const wgpu::Texture& texture) const;
+
+	wgpu::Device m_device = nullptr;
+	std::vector<FormatPipelines> m_formats;
+	bool m_enabled = true;
+	bool m_validate = false;
+};
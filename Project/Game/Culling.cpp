@@ -0,0 +1,168 @@
+#include "Engine.h"
+#include "Simd.h"
+
+#include <bit>
+
+//-----------------------------------------------------------------------------
+namespace
+{
+	// The distance of the box corner farthest along the plane normal (positive vertex) - negative: the box is outside,
+	// and of the nearest corner (negative vertex) - not negative: the box is inside.
+	// n * corner per axis is max(n * min, n * max) for the positive vertex and min(...) for the negative one.
+	FrustumTest testBoxScalar(const Frustum& frustum, const BoundingBox& box)
+	{
+		FrustumTest result = FrustumTest::Inside;
+		for (uint32_t i = 0; i < Frustum::kPlaneCount; i++)
+		{
+			const float x0 = frustum.nx[i] * box.min.x, x1 = frustum.nx[i] * box.max.x;
+			const float y0 = frustum.ny[i] * box.min.y, y1 = frustum.ny[i] * box.max.y;
+			const float z0 = frustum.nz[i] * box.min.z, z1 = frustum.nz[i] * box.max.z;
+			if (std::max(x0, x1) + std::max(y0, y1) + std::max(z0, z1) + frustum.d[i] < 0.0f)
+				return FrustumTest::Outside;
+			if (std::min(x0, x1) + std::min(y0, y1) + std::min(z0, z1) + frustum.d[i] < 0.0f)
+				result = FrustumTest::Intersect;
+		}
+		return result;
+	}
+
+	uint32_t writeVisible(uint32_t mask, uint32_t first, uint32_t* visibleIndices)
+	{
+		uint32_t count = 0;
+		while (mask)
+		{
+			visibleIndices[count++] = first + static_cast<uint32_t>(std::countr_zero(mask));
+			mask &= mask - 1;
+		}
+		return count;
+	}
+}
+//-----------------------------------------------------------------------------
+Frustum ExtractFrustum(const glm::mat4& viewProjection)
+{
+	// Gribb-Hartmann: the clip space conditions -w <= x <= w, -w <= y <= w, 0 <= z <= w as planes in world space
+	const glm::vec4 row0 = glm::row(viewProjection, 0);
+	const glm::vec4 row1 = glm::row(viewProjection, 1);
+	const glm::vec4 row2 = glm::row(viewProjection, 2);
+	const glm::vec4 row3 = glm::row(viewProjection, 3);
+	const glm::vec4 planes[Frustum::kPlaneCount] =
+	{
+		row3 + row0, row3 - row0,
+		row3 + row1, row3 - row1,
+		row2, row3 - row2
+	};
+
+	Frustum frustum;
+	for (uint32_t i = 0; i < Frustum::kPlaneCount; i++)
+	{
+		const float length = glm::length(glm::vec3(planes[i]));
+		const glm::vec4 plane = length > 0.0f ? planes[i] / length : planes[i];
+		frustum.nx[i] = plane.x;
+		frustum.ny[i] = plane.y;
+		frustum.nz[i] = plane.z;
+		frustum.d[i] = plane.w;
+	}
+	for (uint32_t i = Frustum::kPlaneCount; i < 8; i++)
+	{
+		frustum.nx[i] = frustum.ny[i] = frustum.nz[i] = 0.0f;
+		frustum.d[i] = 1.0f;
+	}
+	return frustum;
+}
+//-----------------------------------------------------------------------------
+FrustumTest TestBox(const Frustum& frustum, const BoundingBox& box)
+{
+	if (box.IsEmpty()) return FrustumTest::Outside;
+
+#if defined(SIMD_AVX2)
+	const __m256 nx = _mm256_load_ps(frustum.nx), ny = _mm256_load_ps(frustum.ny), nz = _mm256_load_ps(frustum.nz);
+	const __m256 x0 = _mm256_mul_ps(nx, _mm256_set1_ps(box.min.x)), x1 = _mm256_mul_ps(nx, _mm256_set1_ps(box.max.x));
+	const __m256 y0 = _mm256_mul_ps(ny, _mm256_set1_ps(box.min.y)), y1 = _mm256_mul_ps(ny, _mm256_set1_ps(box.max.y));
+	const __m256 z0 = _mm256_mul_ps(nz, _mm256_set1_ps(box.min.z)), z1 = _mm256_mul_ps(nz, _mm256_set1_ps(box.max.z));
+	const __m256 d = _mm256_load_ps(frustum.d);
+	const __m256 positive = _mm256_add_ps(_mm256_add_ps(_mm256_max_ps(x0, x1), _mm256_max_ps(y0, y1)), _mm256_add_ps(_mm256_max_ps(z0, z1), d));
+	const __m256 negative = _mm256_add_ps(_mm256_add_ps(_mm256_min_ps(x0, x1), _mm256_min_ps(y0, y1)), _mm256_add_ps(_mm256_min_ps(z0, z1), d));
+	const __m256 zero = _mm256_setzero_ps();
+	if (_mm256_movemask_ps(_mm256_cmp_ps(positive, zero, _CMP_LT_OQ)))
+		return FrustumTest::Outside;
+	return _mm256_movemask_ps(_mm256_cmp_ps(negative, zero, _CMP_LT_OQ)) ? FrustumTest::Intersect : FrustumTest::Inside;
+#elif defined(SIMD_SSE2)
+	const __m128 minX = _mm_set1_ps(box.min.x), minY = _mm_set1_ps(box.min.y), minZ = _mm_set1_ps(box.min.z);
+	const __m128 maxX = _mm_set1_ps(box.max.x), maxY = _mm_set1_ps(box.max.y), maxZ = _mm_set1_ps(box.max.z);
+	const __m128 zero = _mm_setzero_ps();
+	int intersect = 0;
+	for (uint32_t i = 0; i < 8; i += 4)
+	{
+		const __m128 nx = _mm_load_ps(frustum.nx + i), ny = _mm_load_ps(frustum.ny + i), nz = _mm_load_ps(frustum.nz + i);
+		const __m128 x0 = _mm_mul_ps(nx, minX), x1 = _mm_mul_ps(nx, maxX);
+		const __m128 y0 = _mm_mul_ps(ny, minY), y1 = _mm_mul_ps(ny, maxY);
+		const __m128 z0 = _mm_mul_ps(nz, minZ), z1 = _mm_mul_ps(nz, maxZ);
+		const __m128 d = _mm_load_ps(frustum.d + i);
+		const __m128 positive = _mm_add_ps(_mm_add_ps(_mm_max_ps(x0, x1), _mm_max_ps(y0, y1)), _mm_add_ps(_mm_max_ps(z0, z1), d));
+		if (_mm_movemask_ps(_mm_cmplt_ps(positive, zero)))
+			return FrustumTest::Outside;
+		const __m128 negative = _mm_add_ps(_mm_add_ps(_mm_min_ps(x0, x1), _mm_min_ps(y0, y1)), _mm_add_ps(_mm_min_ps(z0, z1), d));
+		intersect |= _mm_movemask_ps(_mm_cmplt_ps(negative, zero));
+	}
+	return intersect ? FrustumTest::Intersect : FrustumTest::Inside;
+#else
+	return testBoxScalar(frustum, box);
+#endif
+}
+//-----------------------------------------------------------------------------
+uint32_t CullBoxes(const Frustum& frustum, const BoundingBox* boxes, uint32_t count, uint32_t* visibleIndices)
+{
+	uint32_t visibleCount = 0;
+	uint32_t i = 0;
+#if defined(SIMD_AVX2)
+	// one box per lane, the planes are broadcast
+	for (; i + 8 <= count; i += 8)
+	{
+		const BoundingBox* b = boxes + i;
+		const __m256 minX = _mm256_setr_ps(b[0].min.x, b[1].min.x, b[2].min.x, b[3].min.x, b[4].min.x, b[5].min.x, b[6].min.x, b[7].min.x);
+		const __m256 minY = _mm256_setr_ps(b[0].min.y, b[1].min.y, b[2].min.y, b[3].min.y, b[4].min.y, b[5].min.y, b[6].min.y, b[7].min.y);
+		const __m256 minZ = _mm256_setr_ps(b[0].min.z, b[1].min.z, b[2].min.z, b[3].min.z, b[4].min.z, b[5].min.z, b[6].min.z, b[7].min.z);
+		const __m256 maxX = _mm256_setr_ps(b[0].max.x, b[1].max.x, b[2].max.x, b[3].max.x, b[4].max.x, b[5].max.x, b[6].max.x, b[7].max.x);
+		const __m256 maxY = _mm256_setr_ps(b[0].max.y, b[1].max.y, b[2].max.y, b[3].max.y, b[4].max.y, b[5].max.y, b[6].max.y, b[7].max.y);
+		const __m256 maxZ = _mm256_setr_ps(b[0].max.z, b[1].max.z, b[2].max.z, b[3].max.z, b[4].max.z, b[5].max.z, b[6].max.z, b[7].max.z);
+		__m256 outside = _mm256_cmp_ps(maxX, minX, _CMP_LT_OQ); // empty boxes
+		for (uint32_t p = 0; p < Frustum::kPlaneCount; p++)
+		{
+			const __m256 nx = _mm256_set1_ps(frustum.nx[p]), ny = _mm256_set1_ps(frustum.ny[p]), nz = _mm256_set1_ps(frustum.nz[p]);
+			__m256 distance = _mm256_add_ps(_mm256_max_ps(_mm256_mul_ps(nx, minX), _mm256_mul_ps(nx, maxX)), _mm256_set1_ps(frustum.d[p]));
+			distance = _mm256_add_ps(distance, _mm256_max_ps(_mm256_mul_ps(ny, minY), _mm256_mul_ps(ny, maxY)));
+			distance = _mm256_add_ps(distance, _mm256_max_ps(_mm256_mul_ps(nz, minZ), _mm256_mul_ps(nz, maxZ)));
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_LT_OQ));
+		}
+		visibleCount += writeVisible(~static_cast<uint32_t>(_mm256_movemask_ps(outside)) & 0xFFu, i, visibleIndices + visibleCount);
+	}
+#endif
+#if defined(SIMD_SSE2)
+	for (; i + 4 <= count; i += 4)
+	{
+		const BoundingBox* b = boxes + i;
+		const __m128 minX = _mm_setr_ps(b[0].min.x, b[1].min.x, b[2].min.x, b[3].min.x);
+		const __m128 minY = _mm_setr_ps(b[0].min.y, b[1].min.y, b[2].min.y, b[3].min.y);
+		const __m128 minZ = _mm_setr_ps(b[0].min.z, b[1].min.z, b[2].min.z, b[3].min.z);
+		const __m128 maxX = _mm_setr_ps(b[0].max.x, b[1].max.x, b[2].max.x, b[3].max.x);
+		const __m128 maxY = _mm_setr_ps(b[0].max.y, b[1].max.y, b[2].max.y, b[3].max.y);
+		const __m128 maxZ = _mm_setr_ps(b[0].max.z, b[1].max.z, b[2].max.z, b[3].max.z);
+		__m128 outside = _mm_cmplt_ps(maxX, minX); // empty boxes
+		for (uint32_t p = 0; p < Frustum::kPlaneCount; p++)
+		{
+			const __m128 nx = _mm_set1_ps(frustum.nx[p]), ny = _mm_set1_ps(frustum.ny[p]), nz = _mm_set1_ps(frustum.nz[p]);
+			__m128 distance = _mm_add_ps(_mm_max_ps(_mm_mul_ps(nx, minX), _mm_mul_ps(nx, maxX)), _mm_set1_ps(frustum.d[p]));
+			distance = _mm_add_ps(distance, _mm_max_ps(_mm_mul_ps(ny, minY), _mm_mul_ps(ny, maxY)));
+			distance = _mm_add_ps(distance, _mm_max_ps(_mm_mul_ps(nz, minZ), _mm_mul_ps(nz, maxZ)));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+		}
+		visibleCount += writeVisible(~static_cast<uint32_t>(_mm_movemask_ps(outside)) & 0xFu, i, visibleIndices + visibleCount);
+	}
+#endif
+	for (; i < count; i++)
+	{
+		if (!boxes[i].IsEmpty() && testBoxScalar(frustum, boxes[i]) != FrustumTest::Outside)
+			visibleIndices[visibleCount++] = i;
+	}
+	return visibleCount;
+}
+//-----------------------------------------------------------------------------
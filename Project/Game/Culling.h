@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Geometry.h"
+
+// View frustum as planes pointing inside: a point p is inside a plane when n.p + d >= 0.
+// SoA layout for the SIMD tests, the 6 planes are padded to 8 with planes that contain everything.
+struct Frustum
+{
+	static constexpr uint32_t kPlaneCount = 6; // left, right, bottom, top, near, far
+
+	alignas(32) float nx[8];
+	alignas(32) float ny[8];
+	alignas(32) float nz[8];
+	alignas(32) float d[8];
+};
+
+enum class FrustumTest : uint8_t
+{
+	Outside,
+	Intersect,
+	Inside
+};
+
+// Planes of projection * view (clip space depth 0..1, as glm is configured in glmConfig.h), normalized
+Frustum ExtractFrustum(const glm::mat4& viewProjection);
+
+// Box against all planes at once (SIMD over the planes). An empty box is outside.
+FrustumTest TestBox(const Frustum& frustum, const BoundingBox& box);
+
+// Writes the indices of the boxes not outside the frustum to visibleIndices (room for count), returns their number.
+// SIMD over the boxes: 4 per step with SSE2, 8 with AVX2. An empty box is outside.
+uint32_t CullBoxes(const Frustum& frustum, const BoundingBox* boxes, uint32_t count, uint32_t* visibleIndices);
@@ -0,0 +1,261 @@
+#include "Engine.h"
+
+//-----------------------------------------------------------------------------
+namespace
+{
+	std::array<ComponentTypeInfo, kMaxComponentTypes> ComponentTypes;
+	std::atomic<uint32_t> ComponentTypeCount{ 0 };
+
+	constexpr uint8_t kNoColumn = 0xFF;
+	constexpr size_t kMinColumnAlignment = 16; // SSE loads of the first element
+	constexpr uint32_t kMinArchetypeCapacity = 64;
+}
+//-----------------------------------------------------------------------------
+uint32_t RegisterComponentType(size_t size, size_t alignment)
+{
+	const uint32_t type = ComponentTypeCount.fetch_add(1);
+	if (type >= kMaxComponentTypes)
+		Fatal("Too many ECS component types (max " + std::to_string(kMaxComponentTypes) + ")");
+	ComponentTypes[type].size = size;
+	ComponentTypes[type].alignment = alignment;
+	return type;
+}
+//-----------------------------------------------------------------------------
+const ComponentTypeInfo& GetComponentTypeInfo(uint32_t type)
+{
+	return ComponentTypes[type];
+}
+//-----------------------------------------------------------------------------
+Archetype::Archetype(ComponentMask mask)
+	: m_mask(mask)
+{
+	m_columnIndex.fill(kNoColumn);
+	for (uint32_t type = 0; type < kMaxComponentTypes; type++)
+	{
+		if ((mask & (ComponentMask(1) << type)) == 0) continue;
+
+		const ComponentTypeInfo& info = GetComponentTypeInfo(type);
+		Column column;
+		column.type = type;
+		column.size = info.size;
+		column.alignment = std::max(info.alignment, kMinColumnAlignment);
+		m_columnIndex[type] = static_cast<uint8_t>(m_columns.size());
+		m_columns.push_back(column);
+	}
+}
+//-----------------------------------------------------------------------------
+Archetype::~Archetype()
+{
+	for (Column& column : m_columns)
+		::operator delete(column.data, std::align_val_t(column.alignment));
+}
+//-----------------------------------------------------------------------------
+void* Archetype::GetColumn(uint32_t type)
+{
+	const uint8_t index = m_columnIndex[type];
+	return index == kNoColumn ? nullptr : m_columns[index].data;
+}
+//-----------------------------------------------------------------------------
+uint32_t Archetype::AddRow(Entity entity)
+{
+	if (m_entities.size() == m_capacity)
+		grow();
+	m_entities.push_back(entity);
+	return static_cast<uint32_t>(m_entities.size() - 1);
+}
+//-----------------------------------------------------------------------------
+Entity Archetype::RemoveRow(uint32_t row)
+{
+	const uint32_t last = static_cast<uint32_t>(m_entities.size() - 1);
+	Entity moved;
+	if (row != last)
+	{
+		for (Column& column : m_columns)
+			memcpy(column.data + row * column.size, column.data + last * column.size, column.size);
+		m_entities[row] = m_entities[last];
+		moved = m_entities[row];
+	}
+	m_entities.pop_back();
+	return moved;
+}
+//-----------------------------------------------------------------------------
+void Archetype::CopyRow(uint32_t row, Archetype& destination, uint32_t destinationRow) const
+{
+	for (const Column& column : m_columns)
+	{
+		void* destinationData = destination.GetColumn(column.type);
+		if (destinationData)
+			memcpy(static_cast<uint8_t*>(destinationData) + destinationRow * column.size, column.data + row * column.size, column.size);
+	}
+}
+//-----------------------------------------------------------------------------
+void Archetype::grow()
+{
+	const uint32_t capacity = std::max(m_capacity * 2, kMinArchetypeCapacity);
+	for (Column& column : m_columns)
+	{
+		uint8_t* data = static_cast<uint8_t*>(::operator new(capacity * column.size, std::align_val_t(column.alignment)));
+		if (column.data)
+		{
+			memcpy(data, column.data, m_entities.size() * column.size);
+			::operator delete(column.data, std::align_val_t(column.alignment));
+		}
+		column.data = data;
+	}
+	m_entities.reserve(capacity);
+	m_capacity = capacity;
+}
+//-----------------------------------------------------------------------------
+void World::Destroy(Entity entity)
+{
+	if (!IsAlive(entity)) return;
+
+	EntityRecord& record = m_entities[entity.index];
+	removeRow(record.archetype, record.row);
+	record.generation++;
+	if (record.generation == 0) record.generation = 1; // 0 is the null entity
+	m_freeEntities.push_back(entity.index);
+	m_entityCount--;
+}
+//-----------------------------------------------------------------------------
+void World::Clear()
+{
+	for (auto& archetype : m_archetypes)
+		archetype->Clear();
+	m_freeEntities.clear();
+	for (uint32_t i = 0; i < m_entities.size(); i++)
+	{
+		// the handles of the destroyed entities stay invalid
+		EntityRecord& record = m_entities[i];
+		record.generation++;
+		if (record.generation == 0) record.generation = 1;
+		m_freeEntities.push_back(static_cast<uint32_t>(m_entities.size()) - 1 - i); // the lowest index is reused first
+	}
+	m_entityCount = 0;
+}
+//-----------------------------------------------------------------------------
+bool World::IsAlive(Entity entity) const
+{
+	// the generation of a free record has moved past every handle given out
+	return !entity.IsNull() && entity.index < m_entities.size() && m_entities[entity.index].generation == entity.generation;
+}
+//-----------------------------------------------------------------------------
+Entity World::createEntity(ComponentMask mask)
+{
+	Entity entity;
+	if (!m_freeEntities.empty())
+	{
+		entity.index = m_freeEntities.back();
+		m_freeEntities.pop_back();
+	}
+	else
+	{
+		entity.index = static_cast<uint32_t>(m_entities.size());
+		m_entities.emplace_back();
+	}
+
+	EntityRecord& record = m_entities[entity.index];
+	entity.generation = record.generation;
+	record.archetype = getArchetype(mask);
+	record.row = m_archetypes[record.archetype]->AddRow(entity);
+	m_entityCount++;
+	return entity;
+}
+//-----------------------------------------------------------------------------
+uint32_t World::getArchetype(ComponentMask mask)
+{
+	auto it = m_archetypeIndex.find(mask);
+	if (it != m_archetypeIndex.end())
+		return it->second;
+
+	const uint32_t index = static_cast<uint32_t>(m_archetypes.size());
+	m_archetypes.push_back(std::make_unique<Archetype>(mask));
+	m_archetypeIndex[mask] = index;
+	return index;
+}
+//-----------------------------------------------------------------------------
+void World::changeArchetype(Entity entity, ComponentMask mask)
+{
+	EntityRecord& record = m_entities[entity.index];
+	if (m_archetypes[record.archetype]->GetMask() == mask)
+		return;
+
+	const uint32_t archetype = getArchetype(mask);
+	const uint32_t row = m_archetypes[archetype]->AddRow(entity);
+	m_archetypes[record.archetype]->CopyRow(record.row, *m_archetypes[archetype], row);
+	removeRow(record.archetype, record.row);
+	record.archetype = archetype;
+	record.row = row;
+}
+//-----------------------------------------------------------------------------
+void World::removeRow(uint32_t archetype, uint32_t row)
+{
+	const Entity moved = m_archetypes[archetype]->RemoveRow(row);
+	if (!moved.IsNull())
+		m_entities[moved.index].row = row;
+}
+//-----------------------------------------------------------------------------
+void* World::getComponent(Entity entity, uint32_t type)
+{
+	const EntityRecord& record = m_entities[entity.index];
+	uint8_t* column = static_cast<uint8_t*>(m_archetypes[record.archetype]->GetColumn(type));
+	return column ? column + record.row * GetComponentTypeInfo(type).size : nullptr;
+}
+//-----------------------------------------------------------------------------
+void UpdateWorldMatrices(World& world, JobSystem& jobSystem)
+{
+	static_assert(sizeof(PositionComponent) == sizeof(glm::vec3) && sizeof(RotationComponent) == sizeof(glm::quat)
+		&& sizeof(ScaleComponent) == sizeof(glm::vec3) && sizeof(WorldMatrixComponent) == sizeof(glm::mat4)
+		&& sizeof(TransformDirtyComponent) == sizeof(bool), "the components are passed to the kernel as plain arrays");
+
+	PROFILE_SCOPE("UpdateWorldMatrices");
+	world.ParallelEachChunk<PositionComponent, RotationComponent, ScaleComponent, TransformDirtyComponent, WorldMatrixComponent>(jobSystem, 0,
+		[](uint32_t count, const Entity*, const PositionComponent* positions, const RotationComponent* rotations, const ScaleComponent* scales,
+			TransformDirtyComponent* dirty, WorldMatrixComponent* worlds)
+		{
+			ComputeWorldMatrices(count, &positions->value, &rotations->value, &scales->value, &dirty->value, &worlds->value);
+			for (uint32_t i = 0; i < count; i++)
+				dirty[i].value = false;
+		});
+}
+//-----------------------------------------------------------------------------
+void CollectDrawItems(World& world, FramePacket& packet, const Frustum* frustum)
+{
+	PROFILE_SCOPE("CollectDrawItems");
+	world.EachChunk<WorldMatrixComponent, RenderComponent>(
+		[&packet, frustum](uint32_t count, const Entity*, const WorldMatrixComponent* worlds, const RenderComponent* renders)
+		{
+			const uint32_t* visible = nullptr;
+			uint32_t visibleCount = count;
+			if (frustum)
+			{
+				BoundingBox* boxes = packet.arena.AllocateArray<BoundingBox>(count);
+				for (uint32_t i = 0; i < count; i++)
+				{
+					if (renders[i].bounds.IsEmpty())
+					{
+						// contains the whole frustum
+						boxes[i].min = glm::vec3(-FLT_MAX);
+						boxes[i].max = glm::vec3(FLT_MAX);
+					}
+					else
+						boxes[i] = renders[i].bounds.Transform(worlds[i].value);
+				}
+				uint32_t* indices = packet.arena.AllocateArray<uint32_t>(count);
+				visibleCount = CullBoxes(*frustum, boxes, count, indices);
+				visible = indices;
+			}
+
+			const size_t first = packet.drawItems.size();
+			packet.drawItems.resize(first + visibleCount);
+			for (uint32_t i = 0; i < visibleCount; i++)
+			{
+				const uint32_t index = visible ? visible[i] : i;
+				FrameDrawItem& item = packet.drawItems[first + i];
+				item.transform = worlds[index].value;
+				item.mesh = renders[index].mesh;
+				item.material = renders[index].material;
+			}
+		});
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,263 @@
+#pragma once
+
+#include "JobSystem.h"
+#include "Render.h"
+
+#include <array>
+#include <type_traits>
+#include <unordered_map>
+
+// Archetype entity-component system. Entities with the same set of components share an archetype, every component
+// of an archetype is a contiguous array (SoA) - a system iterates tightly packed arrays of only the components it reads.
+// Components are plain data (trivially copyable), they are moved between archetypes with memcpy.
+// Structural changes (Create, Destroy, Add, Remove, Clear) must not happen during Each/ParallelEach.
+
+// Stable handle: the index is reused after Destroy, the generation tells the old handle from the new entity
+struct Entity
+{
+	uint32_t index = 0;
+	uint32_t generation = 0; // 0 - null entity
+
+	bool IsNull() const { return generation == 0; }
+	bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+	bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+constexpr uint32_t kMaxComponentTypes = 64;
+using ComponentMask = uint64_t; // bit per component type
+
+struct ComponentTypeInfo
+{
+	size_t size = 0;
+	size_t alignment = 0;
+};
+
+// Component type ids are assigned on first use
+uint32_t RegisterComponentType(size_t size, size_t alignment);
+const ComponentTypeInfo& GetComponentTypeInfo(uint32_t type);
+
+template<typename T>
+uint32_t GetComponentType()
+{
+	static_assert(std::is_trivially_copyable_v<T>, "ECS components must be trivially copyable");
+	static const uint32_t type = RegisterComponentType(sizeof(T), alignof(T));
+	return type;
+}
+
+template<typename T>
+ComponentMask GetComponentBit()
+{
+	return ComponentMask(1) << GetComponentType<T>();
+}
+
+// Entities of one component set, a column per component
+class Archetype
+{
+public:
+	explicit Archetype(ComponentMask mask);
+	Archetype(Archetype&&) = delete;
+	Archetype(const Archetype&) = delete;
+	~Archetype();
+	Archetype& operator=(Archetype&&) = delete;
+	Archetype& operator=(const Archetype&) = delete;
+
+	ComponentMask GetMask() const { return m_mask; }
+	uint32_t GetSize() const { return static_cast<uint32_t>(m_entities.size()); }
+	const Entity* GetEntities() const { return m_entities.data(); }
+
+	// nullptr when the archetype has no such component
+	void* GetColumn(uint32_t type);
+	template<typename T>
+	T* GetColumn() { return static_cast<T*>(GetColumn(GetComponentType<T>())); }
+
+	// The components of the new row are uninitialized
+	uint32_t AddRow(Entity entity);
+	// The last row moves into the removed one, returns its entity (null when the removed row was the last)
+	Entity RemoveRow(uint32_t row);
+	// Copies the components present in both archetypes
+	void CopyRow(uint32_t row, Archetype& destination, uint32_t destinationRow) const;
+	void Clear() { m_entities.clear(); }
+
+private:
+	struct Column
+	{
+		uint32_t type = 0;
+		size_t size = 0;
+		size_t alignment = 0;
+		uint8_t* data = nullptr;
+	};
+
+	void grow();
+
+	ComponentMask m_mask = 0;
+	std::vector<Column> m_columns;
+	std::array<uint8_t, kMaxComponentTypes> m_columnIndex; // type -> column, 0xFF - none
+	std::vector<Entity> m_entities;
+	uint32_t m_capacity = 0;
+};
+
+class World
+{
+public:
+	World() = default;
+	World(World&&) = delete;
+	World(const World&) = delete;
+	World& operator=(World&&) = delete;
+	World& operator=(const World&) = delete;
+
+	template<typename... Components>
+	Entity Create(const Components&... components)
+	{
+		const Entity entity = createEntity((ComponentMask(0) | ... | GetComponentBit<Components>()));
+		(new (getComponent(entity, GetComponentType<Components>())) Components(components), ...);
+		return entity;
+	}
+	void Destroy(Entity entity);
+	// Destroys all entities, the archetypes keep their memory
+	void Clear();
+
+	bool IsAlive(Entity entity) const;
+	size_t GetEntityCount() const { return m_entityCount; }
+
+	template<typename T>
+	bool Has(Entity entity) const
+	{
+		return IsAlive(entity) && (m_archetypes[m_entities[entity.index].archetype]->GetMask() & GetComponentBit<T>()) != 0;
+	}
+	// nullptr when the entity is dead or has no such component. Valid until the next structural change.
+	template<typename T>
+	T* Get(Entity entity)
+	{
+		return IsAlive(entity) ? static_cast<T*>(getComponent(entity, GetComponentType<T>())) : nullptr;
+	}
+	// Adds the component or replaces its value
+	template<typename T>
+	void Add(Entity entity, const T& component)
+	{
+		if (!IsAlive(entity)) return;
+		const uint32_t type = GetComponentType<T>();
+		changeArchetype(entity, m_archetypes[m_entities[entity.index].archetype]->GetMask() | (ComponentMask(1) << type));
+		new (getComponent(entity, type)) T(component);
+	}
+	template<typename T>
+	void Remove(Entity entity)
+	{
+		if (!IsAlive(entity)) return;
+		changeArchetype(entity, m_archetypes[m_entities[entity.index].archetype]->GetMask() & ~GetComponentBit<T>());
+	}
+
+	// function(Entity, Components&...) for every entity that has all Components
+	template<typename... Components, typename Function>
+	void Each(Function&& function)
+	{
+		EachChunk<Components...>([&function](uint32_t count, const Entity* entities, Components*... components)
+		{
+			for (uint32_t i = 0; i < count; i++)
+				function(entities[i], components[i]...);
+		});
+	}
+	// function(count, entities, Components*...) per archetype: the component arrays for batch kernels
+	template<typename... Components, typename Function>
+	void EachChunk(Function&& function)
+	{
+		const ComponentMask mask = (ComponentMask(0) | ... | GetComponentBit<Components>());
+		for (const auto& archetype : m_archetypes)
+		{
+			if ((archetype->GetMask() & mask) != mask || archetype->GetSize() == 0) continue;
+			function(archetype->GetSize(), archetype->GetEntities(), archetype->template GetColumn<Components>()...);
+		}
+	}
+	// EachChunk split into batches of batchSize entities over the job system threads, returns when all are done.
+	// The function runs concurrently: it may write only the components of its own entities.
+	template<typename... Components, typename Function>
+	void ParallelEachChunk(JobSystem& jobSystem, uint32_t batchSize, Function&& function)
+	{
+		EachChunk<Components...>([&](uint32_t count, const Entity* entities, Components*... components)
+		{
+			auto batch = [&](uint32_t begin, uint32_t end)
+			{
+				function(end - begin, entities + begin, (components + begin)...);
+			};
+			// a single reference capture fits in the small buffer of std::function - no allocation per call
+			jobSystem.ParallelFor(count, batchSize, [&batch](uint32_t begin, uint32_t end) { batch(begin, end); });
+		});
+	}
+	template<typename... Components, typename Function>
+	void ParallelEach(JobSystem& jobSystem, uint32_t batchSize, Function&& function)
+	{
+		ParallelEachChunk<Components...>(jobSystem, batchSize, [&function](uint32_t count, const Entity* entities, Components*... components)
+		{
+			for (uint32_t i = 0; i < count; i++)
+				function(entities[i], components[i]...);
+		});
+	}
+
+private:
+	struct EntityRecord
+	{
+		uint32_t archetype = 0;
+		uint32_t row = 0;
+		uint32_t generation = 1;
+	};
+
+	Entity createEntity(ComponentMask mask);
+	uint32_t getArchetype(ComponentMask mask);
+	void changeArchetype(Entity entity, ComponentMask mask);
+	void removeRow(uint32_t archetype, uint32_t row);
+	void* getComponent(Entity entity, uint32_t type);
+
+	std::vector<std::unique_ptr<Archetype>> m_archetypes;
+	std::unordered_map<ComponentMask, uint32_t> m_archetypeIndex;
+	std::vector<EntityRecord> m_entities;
+	std::vector<uint32_t> m_freeEntities;
+	size_t m_entityCount = 0;
+};
+
+//=============================================================================
+// Engine components and systems
+//=============================================================================
+
+// Local transform, world = translate(position) * rotate(rotation) * scale(scale). Separate components,
+// so the transform system reads three packed arrays.
+struct PositionComponent
+{
+	glm::vec3 value = glm::vec3(0.0f);
+};
+
+struct RotationComponent
+{
+	glm::quat value = glm::identity<glm::quat>();
+};
+
+struct ScaleComponent
+{
+	glm::vec3 value = glm::vec3(1.0f);
+};
+
+// Set by whoever changes Position, Rotation or Scale. UpdateWorldMatrices recomputes only the flagged
+// world matrices and clears the flags - static objects cost nothing per frame.
+struct TransformDirtyComponent
+{
+	bool value = true;
+};
+
+// Written by UpdateWorldMatrices
+struct WorldMatrixComponent
+{
+	glm::mat4 value = glm::mat4(1.0f);
+};
+
+// Drawn by CollectDrawItems (FrameDrawItem::mesh and material)
+struct RenderComponent
+{
+	uint32_t mesh = 0;
+	uint32_t material = 0;
+	BoundingBox bounds; // of the mesh in its local space (MeshBounds::box), empty - never culled
+};
+
+// WorldMatrixComponent of the entities with Position, Rotation, Scale and TransformDirty (only the dirty ones),
+// SIMD batches on all job system threads
+void UpdateWorldMatrices(World& world, JobSystem& jobSystem);
+// Appends a draw item per entity with WorldMatrix and Render to the packet. With a frustum only the entities
+// whose world bounds are not outside it (SIMD batch test, the scratch arrays come from the packet arena).
+void CollectDrawItems(World& world, FramePacket& packet, const Frustum* frustum = nullptr);
@@ -1,4 +1,5 @@
-#include "Engine.h"
+﻿#include "Engine.h"
+#include "AllocationCounter.h"
 
 #if defined(_MSC_VER)
 #	pragma warning(push, 3)
@@ -56,9 +57,47 @@ void onScroll(GLFWwindow* window, double xoffset, double yoffset) noexcept
 //-----------------------------------------------------------------------------
 struct EngineData
 {
-	GLFWwindow* window = nullptr;
+	GLFWwindow* window = nullptr; // nullptr in the headless mode
+	bool glfwInitialized = false;
+	AppCreateInfo createInfo;
+
+	// Fixed timestep state
+	double accumulator = 0.0;
+	float frameTime = 0.0f;
+	float interpolationAlpha = 0.0f;
+
+	FramePacket* framePacket = nullptr;
+	uint64_t frameIndex = 0;
+	uint64_t frameHeapAllocations = 0; // of the app on the main thread
 };
 //-----------------------------------------------------------------------------
+float IApp::GetDeltaTime() const
+{
+	return m_engine.m_data->createInfo.fixedTimeStep;
+}
+//-----------------------------------------------------------------------------
+float IApp::GetFrameTime() const
+{
+	return m_engine.m_data->frameTime;
+}
+//-----------------------------------------------------------------------------
+float IApp::GetInterpolationAlpha() const
+{
+	return m_engine.m_data->interpolationAlpha;
+}
+//-----------------------------------------------------------------------------
+FramePacket& IApp::GetFramePacket()
+{
+	if (!m_engine.m_data->framePacket)
+		Fatal("GetFramePacket() is only available in IApp::Frame");
+	return *m_engine.m_data->framePacket;
+}
+//-----------------------------------------------------------------------------
+uint64_t IApp::GetFrameHeapAllocations() const
+{
+	return m_engine.m_data->frameHeapAllocations;
+}
+//-----------------------------------------------------------------------------
 int IApp::GetWindowWidth() const
 {
 	return WindowWidth;
@@ -69,6 +108,21 @@ int IApp::GetWindowHeight() const
 	return WindowHeight;
 }
 //-----------------------------------------------------------------------------
+const RenderStats& IApp::GetRenderStats() const
+{
+	return m_engine.m_render.GetStats();
+}
+//-----------------------------------------------------------------------------
+JobSystem& IApp::GetJobSystem()
+{
+	return m_engine.m_jobSystem;
+}
+//-----------------------------------------------------------------------------
+void IApp::ParallelFor(uint32_t count, uint32_t batchSize, const ParallelForFunction& function)
+{
+	m_engine.m_jobSystem.ParallelFor(count, batchSize, function);
+}
+//-----------------------------------------------------------------------------
 void IApp::Exit()
 {
 	m_engine.exit();
@@ -79,75 +133,237 @@ void glfwErrorCallback(int, const char* message) noexcept
 	Fatal(message);
 }
 //-----------------------------------------------------------------------------
-void Engine::run(std::unique_ptr<IApp> app)
+int Engine::run(std::unique_ptr<IApp> app)
 {
 	m_app = std::move(app);
 
+	int exitCode = EXIT_FAILURE;
 	if (init())
 	{
 		if (m_app->Init())
 		{
+			double previousTime = getTime();
 			while (isRun())
 			{
-				m_app->Frame();
-				m_render.Frame();
+				// in the single thread mode the frame pacing delays the input, not only the render
+				if (!m_renderThread.IsMultithreaded())
+					m_render.WaitForNextFrame();
+				GetProfiler().BeginFrame();
+				if (m_data->window)
+					glfwPollEvents();
+
+				const double currentTime = getTime();
+				uint64_t heapAllocations = GetThreadAllocationCounters().allocations;
+				update(currentTime - previousTime);
+				heapAllocations = GetThreadAllocationCounters().allocations - heapAllocations;
+				previousTime = currentTime;
+
+				FramePacket& packet = m_renderThread.BeginFrame();
+				packet.frameIndex = m_data->frameIndex++;
+				packet.time = currentTime;
+				packet.frameTime = m_data->frameTime;
+				packet.interpolationAlpha = m_data->interpolationAlpha;
+				packet.frameBufferWidth = WindowWidth;
+				packet.frameBufferHeight = WindowHeight;
 
-				glfwPollEvents();
-				m_app->Update();
+				m_data->framePacket = &packet;
+				{
+					PROFILE_SCOPE("App Frame");
+					const uint64_t frameAllocations = GetThreadAllocationCounters().allocations;
+					m_app->Frame();
+					heapAllocations += GetThreadAllocationCounters().allocations - frameAllocations;
+				}
+				m_data->framePacket = nullptr;
+				checkHeapAllocations(packet.frameIndex, heapAllocations);
+				m_renderThread.EndFrame();
+				// the jobs of the frame are finished (ParallelFor and Wait return only then)
+				m_jobSystem.ResetThreadArenas();
+				GetProfiler().EndFrame();
 			}
 		}
+		// the queued frames are drawn before the app releases its data
+		m_renderThread.Destroy();
+		if (checkLastFrame())
+			exitCode = EXIT_SUCCESS;
 		m_app->Close();
 	}
 	close();
+	return exitCode;
 }
 //-----------------------------------------------------------------------------
 bool Engine::init()
 {
 	m_data = new EngineData;
+	m_data->createInfo = m_app->GetCreateInfo();
+	if (m_data->createInfo.fixedTimeStep <= 0.0f)
+	{
+		Warning("Invalid fixedTimeStep, 1/60 is used");
+		m_data->createInfo.fixedTimeStep = 1.0f / 60.0f;
+	}
+	if (m_data->createInfo.maxUpdatesPerFrame == 0)
+		m_data->createInfo.maxUpdatesPerFrame = 1;
 
-	glfwSetErrorCallback(glfwErrorCallback);
-	if (!glfwInit())
+	if (!m_jobSystem.Create(m_data->createInfo.workerThreadCount))
 	{
-		Error("Could not initialize GLFW!");
+		Error("Job system not create!");
 		return false;
 	}
-	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-	//glfwWindowHint(GLFW_COCOA_RETINA_FRAMEBUFFER, GLFW_FALSE); // disable high-dpi for macOS
-	m_data->window = glfwCreateWindow(kWidth, kHeight, "Game", nullptr, nullptr);
-	if (!m_data->window)
+
+	const HeadlessInfo& headless = m_data->createInfo.headless;
+	if (headless.enabled)
 	{
-		Error("Could not open window!");
-		return false;
+		if (headless.width == 0 || headless.height == 0)
+		{
+			Error("Invalid headless frame size!");
+			return false;
+		}
+		WindowWidth = static_cast<int>(headless.width);
+		WindowHeight = static_cast<int>(headless.height);
 	}
+	else
+	{
+		glfwSetErrorCallback(glfwErrorCallback);
+		if (!glfwInit())
+		{
+			Error("Could not initialize GLFW!");
+			return false;
+		}
+		m_data->glfwInitialized = true;
+		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+		//glfwWindowHint(GLFW_COCOA_RETINA_FRAMEBUFFER, GLFW_FALSE); // disable high-dpi for macOS
+		m_data->window = glfwCreateWindow(kWidth, kHeight, "Game", nullptr, nullptr);
+		if (!m_data->window)
+		{
+			Error("Could not open window!");
+			return false;
+		}
 
-	glfwSetWindowUserPointer(m_data->window, this);
-	glfwSetFramebufferSizeCallback(m_data->window, onWindowResize);
-	glfwSetCursorPosCallback(m_data->window, onMouseMove);
-	glfwSetMouseButtonCallback(m_data->window, onMouseButton);
-	glfwSetScrollCallback(m_data->window, onScroll);
+		glfwSetWindowUserPointer(m_data->window, this);
+		glfwSetFramebufferSizeCallback(m_data->window, onWindowResize);
+		glfwSetCursorPosCallback(m_data->window, onMouseMove);
+		glfwSetMouseButtonCallback(m_data->window, onMouseButton);
+		glfwSetScrollCallback(m_data->window, onScroll);
 
-	glfwGetFramebufferSize(m_data->window, &WindowWidth, &WindowHeight);
+		glfwGetFramebufferSize(m_data->window, &WindowWidth, &WindowHeight);
+	}
 
+	m_render.SetJobSystem(m_jobSystem);
+	m_render.SetHeadless(headless);
+	FramePacingInfo pacingInfo;
+	pacingInfo.maxFramesInFlight = m_data->createInfo.maxFramesInFlight;
+	pacingInfo.latencyBudget = m_data->createInfo.latencyBudget;
+	m_render.SetPresentInfo(m_data->createInfo.presentMode, pacingInfo);
 	if (!m_render.Create((void*)m_data->window, WindowWidth, WindowHeight))
 	{
 		Error("Render system not create!");
 		return false;
 	}
 
+	if (!m_renderThread.Create(m_render, m_data->createInfo.renderThreadMode))
+	{
+		Error("Render thread not create!");
+		return false;
+	}
+
 	return true;
 }
 //-----------------------------------------------------------------------------
 void Engine::close()
 {
 	m_render.Destroy();
-	glfwDestroyWindow(m_data->window);
-	glfwTerminate();
+	if (m_data->window)
+		glfwDestroyWindow(m_data->window);
+	if (m_data->glfwInitialized)
+		glfwTerminate();
+	m_jobSystem.Destroy();
 	delete m_data;
 }
 //-----------------------------------------------------------------------------
 bool Engine::isRun() const
 {
-	return glfwWindowShouldClose(m_data->window) == GLFW_FALSE && IsEngineClose == false;
+	if (IsEngineClose)
+		return false;
+	if (m_data->createInfo.frameCount > 0 && m_data->frameIndex >= m_data->createInfo.frameCount)
+		return false;
+	return !m_data->window || glfwWindowShouldClose(m_data->window) == GLFW_FALSE;
+}
+//-----------------------------------------------------------------------------
+void Engine::update(double frameTime)
+{
+	const AppCreateInfo& info = m_data->createInfo;
+	const double fixedTimeStep = info.fixedTimeStep;
+
+	frameTime = std::clamp(frameTime, 0.0, static_cast<double>(info.maxFrameTime));
+	m_data->frameTime = static_cast<float>(frameTime);
+	m_data->accumulator += frameTime;
+
+	uint32_t updateCount = 0;
+	while (m_data->accumulator >= fixedTimeStep && updateCount < info.maxUpdatesPerFrame)
+	{
+		PROFILE_SCOPE("App Update");
+		m_app->Update();
+		m_data->accumulator -= fixedTimeStep;
+		updateCount++;
+	}
+
+	// The simulation can't keep up - drop the time it is behind, but keep the phase for interpolation
+	if (m_data->accumulator >= fixedTimeStep)
+		m_data->accumulator = std::fmod(m_data->accumulator, fixedTimeStep);
+
+	m_data->interpolationAlpha = static_cast<float>(m_data->accumulator / fixedTimeStep);
+}
+//-----------------------------------------------------------------------------
+double Engine::getTime() const
+{
+	// headless runs are reproducible: every frame takes exactly one simulation step
+	if (m_data->createInfo.headless.enabled)
+		return static_cast<double>(m_data->frameIndex) * m_data->createInfo.fixedTimeStep;
+	return glfwGetTime();
+}
+//-----------------------------------------------------------------------------
+void Engine::checkHeapAllocations(uint64_t frameIndex, uint64_t heapAllocations)
+{
+	m_data->frameHeapAllocations = heapAllocations;
+	const uint32_t checkFrame = m_data->createInfo.heapAllocationCheckFrame;
+	if (checkFrame > 0 && frameIndex >= checkFrame && heapAllocations > 0)
+		Warning("Frame " + std::to_string(frameIndex) + ": " + std::to_string(heapAllocations) + " heap allocations in IApp::Update/Frame");
+}
+//-----------------------------------------------------------------------------
+bool Engine::checkLastFrame()
+{
+	const AppCreateInfo& info = m_data->createInfo;
+	if (!info.headless.enabled || (info.captureFile.empty() && info.goldenFile.empty()))
+		return true;
+
+	CapturedImage image;
+	if (!m_render.ReadFrame(image))
+	{
+		Error("Could not read back the last frame!");
+		return false;
+	}
+	if (!info.captureFile.empty() && SaveImagePPM(info.captureFile, image))
+		Print("Last frame saved: " + info.captureFile.string());
+	if (info.goldenFile.empty())
+		return true;
+
+	CapturedImage golden;
+	if (!LoadImagePPM(info.goldenFile, golden))
+		return false;
+	const ImageCompareResult result = CompareImages(image, golden, info.goldenTolerance);
+	if (!result.sizeMatch)
+	{
+		Error("Golden image mismatch: " + std::to_string(image.width) + "x" + std::to_string(image.height)
+			+ " frame, " + std::to_string(golden.width) + "x" + std::to_string(golden.height) + " golden image");
+		return false;
+	}
+	if (result.differentPixels > info.goldenMaxPixels)
+	{
+		Error("Golden image mismatch: " + std::to_string(result.differentPixels) + " pixels differ, max difference "
+			+ std::to_string(result.maxDifference));
+		return false;
+	}
+	Print("Golden image match: " + info.goldenFile.string());
+	return true;
 }
 //-----------------------------------------------------------------------------
 void Engine::exit()
@@ -157,10 +373,9 @@ void Engine::exit()
 //-----------------------------------------------------------------------------
 void Engine::OnResize()
 {
+	// the swap chain is resized by the thread that renders the next frame packet with the new size
+	if (!m_data->window) return;
 	glfwGetFramebufferSize(m_data->window, &WindowWidth, &WindowHeight);
-	
-	if (!m_render.Resize(WindowWidth, WindowHeight))
-		Fatal("render resize error");
 }
 //-----------------------------------------------------------------------------
 void Engine::OnMouseMove(double xpos, double ypos)
@@ -170,6 +385,7 @@ void Engine::OnMouseMove(double xpos, double ypos)
 //-----------------------------------------------------------------------------
 void Engine::OnMouseButton(int button, int action, int mods)
 {
+	if (!m_data->window) return;
 	double xpos, ypos;
 	glfwGetCursorPos(m_data->window, &xpos, &ypos);
 	//m_render.OnMouseButton(button, action, mods, xpos, ypos);
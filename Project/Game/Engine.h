@@ -1,4 +1,4 @@
-#pragma once
+﻿#pragma once
 
 //=============================================================================
 // STL and 3rdparty Header
@@ -13,6 +13,7 @@
 #include <vector>
 #include <optional>
 #include <filesystem>
+#include <algorithm>
 
 #if defined(_WIN32)
 #endif // _WIN32
@@ -42,7 +43,15 @@
 // Engine Header
 //=============================================================================
 #include "Core.h"
+#include "JobSystem.h"
 #include "Render.h"
+#include "RenderThread.h"
+#include "Geometry.h"
+#include "TransformBatch.h"
+#include "Culling.h"
+#include "Bvh.h"
+#include "SceneGraph.h"
+#include "Ecs.h"
 
 //=============================================================================
 // App
@@ -52,7 +61,42 @@ class Engine;
 
 struct AppCreateInfo
 {
-
+	// Simulation step of IApp::Update in seconds. Update runs at this rate regardless of the present rate.
+	float fixedTimeStep = 1.0f / 60.0f;
+	// Upper bound of Update calls per frame. When the simulation falls further behind, the remaining time is dropped.
+	uint32_t maxUpdatesPerFrame = 5;
+	// Frame time clamp in seconds (protects against a huge catch-up after a breakpoint or a window drag)
+	float maxFrameTime = 0.25f;
+
+	// Number of job system worker threads. 0 - one per hardware thread except the main one
+	uint32_t workerThreadCount = 0;
+
+	// Where Render::Frame runs. With a render thread the encoding/present of frame N overlaps the simulation of frame N+1
+	RenderThreadMode renderThreadMode = RenderThreadMode::SingleThread;
+
+	// Fifo - vsync, no tearing. Mailbox - vsync, the newest frame replaces the queued one (lower latency, not supported everywhere).
+	// Immediate - no vsync, tearing.
+	wgpu::PresentMode presentMode = wgpu::PresentMode::Fifo;
+	// Frames submitted to the GPU and not finished yet (1..4)
+	uint32_t maxFramesInFlight = 2;
+	// Target input-to-GPU-done time in seconds, the start of a frame is delayed towards it. 0 - no pacing delay.
+	float latencyBudget = 0.0f;
+
+	// No window: the frames are rendered offscreen (automated runs, machines without a display).
+	// The frame time is fixedTimeStep per frame, so a run gives the same frames every time.
+	HeadlessInfo headless;
+	// The engine exits after this number of frames. 0 - no limit
+	uint32_t frameCount = 0;
+	// Headless: the last frame is saved to this PPM file
+	std::filesystem::path captureFile;
+	// Headless: the last frame is compared with this PPM image, a mismatch makes Run return a failure code
+	std::filesystem::path goldenFile;
+	uint8_t goldenTolerance = 2;   // allowed difference per channel
+	uint32_t goldenMaxPixels = 0;  // allowed number of pixels above the tolerance
+
+	// From this frame on a heap allocation in IApp::Update/Frame on the main thread is reported as a warning
+	// (use the frame arenas for transient data). 0 - no check
+	uint32_t heapAllocationCheckFrame = 0;
 };
 
 class IApp
@@ -73,11 +117,30 @@ public:
 	virtual void Update() = 0;
 	virtual void Frame() = 0;
 
+	// Fixed simulation step (use in Update)
 	float GetDeltaTime() const;
+	// Real time of the last frame (use in Frame)
+	float GetFrameTime() const;
+	// Blend factor [0..1) between the previous and the current simulation state (use in Frame)
+	float GetInterpolationAlpha() const;
+
+	// Draw data of the current frame, valid only in Frame
+	FramePacket& GetFramePacket();
+	// Transient memory of the current frame, valid only in Frame. The allocations live until the render has drawn the frame.
+	LinearArena& GetFrameArena() { return GetFramePacket().arena; }
+	// Heap allocations of the last Update calls and Frame on the main thread
+	uint64_t GetFrameHeapAllocations() const;
 
 	int GetWindowWidth() const;
 	int GetWindowHeight() const;
 
+	// Draw calls and uploads of the last rendered frame
+	const RenderStats& GetRenderStats() const;
+
+	JobSystem& GetJobSystem();
+	// Runs function(begin, end) over [0, count) on all job system threads and waits for the result
+	void ParallelFor(uint32_t count, uint32_t batchSize, const ParallelForFunction& function);
+
 	void Exit();
 
 protected:
@@ -93,11 +156,12 @@ class Engine
 {
 	friend class IApp;
 public:
-	template<typename T>
-	static void Run()
+	// Returns the process exit code. args are passed to the constructor of the app after the engine
+	template<typename T, typename... Args>
+	static int Run(Args&&... args)
 	{
 		Engine engine;
-		engine.run(std::make_unique<T>(engine));
+		return engine.run(std::make_unique<T>(engine, std::forward<Args>(args)...));
 	}
 
 	void OnResize();
@@ -107,16 +171,22 @@ public:
 	void OnScroll(double xoffset, double yoffset);
 
 private:
-	void run(std::unique_ptr<IApp> app);
+	int run(std::unique_ptr<IApp> app);
 	bool init();
 	void close();
 	bool isRun() const;
+	void update(double frameTime);
+	double getTime() const;
+	void checkHeapAllocations(uint64_t frameIndex, uint64_t heapAllocations);
+	bool checkLastFrame();
 
 	void exit();
 
 	std::unique_ptr<IApp> m_app;
 	EngineData* m_data = nullptr;
+	JobSystem m_jobSystem;
 	Render m_render;
+	RenderThread m_renderThread;
 };
 
 //=============================================================================
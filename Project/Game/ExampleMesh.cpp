@@ -80,6 +80,9 @@ void plane_mesh_init(plane_mesh_t* plane_mesh,
 	// Generate vertices and indices
 	plane_mesh_generate_vertices(plane_mesh);
 	plane_mesh_generate_indices(plane_mesh);
+
+	// Reorder for the vertex cache, overdraw and vertex fetch
+	plane_mesh->vertex_count = OptimizeMesh(plane_mesh->vertices, plane_mesh->vertex_count, sizeof(plane_vertex_t), plane_mesh->indices, plane_mesh->index_count);
 }
 
 /* -------------------------------------------------------------------------- *
@@ -168,6 +171,13 @@ void box_mesh_create_with_tangents(box_mesh_t* box_mesh, float width, float heig
 		box_mesh->index_array[index_offset++] = face_index * vertices_per_side + 3;
 		box_mesh->index_array[index_offset++] = face_index * vertices_per_side + 1;
 	}
+
+	/* Bounds */
+	const glm::vec3 half_size = { width / 2.0f, height / 2.0f, depth / 2.0f };
+	box_mesh->bounds.box.min = -half_size;
+	box_mesh->bounds.box.max = half_size;
+	box_mesh->bounds.sphere.center = glm::vec3(0.0f);
+	box_mesh->bounds.sphere.radius = glm::length(half_size);
 }
 
 /* -------------------------------------------------------------------------- *
@@ -400,12 +410,27 @@ void sphere_mesh_init(sphere_mesh_t* sphere_mesh, float radius,
 	}
 	free(grid);
 
+	/* Reorder for the vertex cache, overdraw and vertex fetch */
+	{
+		uint32_t* indices32 = (uint32_t*)malloc(ic * sizeof(uint32_t));
+		for (uint32_t i = 0; i < ic; ++i) {
+			indices32[i] = indices[i];
+		}
+		vc = (uint32_t)OptimizeMesh(vertices, vc / 8, 8 * sizeof(float), indices32, ic) * 8;
+		for (uint32_t i = 0; i < ic; ++i) {
+			indices[i] = (uint16_t)indices32[i];
+		}
+		free(indices32);
+	}
+
 	/* Sphere */
-	memset(sphere_mesh, 0, sizeof(*sphere_mesh));
+	*sphere_mesh = {};
 	sphere_mesh->vertices.data = vertices;
 	sphere_mesh->vertices.length = vc;
 	sphere_mesh->indices.data = indices;
 	sphere_mesh->indices.length = ic;
+	/* the randomness moves the vertices off the radius */
+	sphere_mesh->bounds = ComputeMeshBounds(vertices, vc / 8, 8 * sizeof(float));
 }
 
 void sphere_mesh_destroy(sphere_mesh_t* sphere_mesh)
@@ -416,5 +441,5 @@ void sphere_mesh_destroy(sphere_mesh_t* sphere_mesh)
 	if (sphere_mesh->indices.data) {
 		free(sphere_mesh->indices.data);
 	}
-	memset(sphere_mesh, 0, sizeof(*sphere_mesh));
+	*sphere_mesh = {};
 }
\ No newline at end of file
@@ -54,6 +54,7 @@ struct box_mesh_t {
 	float vertex_array[BOX_MESH_VERTICES_COUNT];
 	uint32_t index_array[BOX_MESH_INDICES_COUNT];
 	uint32_t vertex_stride;
+	MeshBounds bounds;
 };
 
 /**
@@ -114,6 +115,7 @@ struct sphere_mesh_t {
 		uint16_t* data;
 		uint64_t length;
 	} indices;
+	MeshBounds bounds;
 };
 
 struct sphere_mesh_layout_t {
@@ -49,6 +49,7 @@ struct camera_t
 	void SetPerspective(float fov, float aspect, float znear, float zfar);
 
 	void UpdateViewMatrix();
+	Frustum GetFrustum() const;
 };
 
 inline void camera_t::SetPosition(const glm::vec3& pos)
@@ -74,6 +75,11 @@ inline void camera_t::SetPerspective(float fov, float aspect, float znear, float
 		matrices.perspective[1][1] *= -1.0f;
 }
 
+inline Frustum camera_t::GetFrustum() const
+{
+	return ExtractFrustum(matrices.perspective * matrices.view);
+}
+
 inline void camera_t::UpdateViewMatrix()
 {
 	glm::mat4 rot_mat = glm::mat4(1.0f);
@@ -0,0 +1,92 @@
+#include "Engine.h"
+
+//-----------------------------------------------------------------------------
+LinearArena::LinearArena(size_t blockSize)
+	: m_blockSize(blockSize > 0 ? blockSize : 1)
+{
+}
+//-----------------------------------------------------------------------------
+LinearArena::LinearArena(LinearArena&& other) noexcept
+{
+	*this = std::move(other);
+}
+//-----------------------------------------------------------------------------
+LinearArena::~LinearArena()
+{
+	release();
+}
+//-----------------------------------------------------------------------------
+LinearArena& LinearArena::operator=(LinearArena&& other) noexcept
+{
+	if (this != &other)
+	{
+		release();
+		m_blocks = std::move(other.m_blocks);
+		m_blockSize = other.m_blockSize;
+		m_current = other.m_current;
+		m_offset = other.m_offset;
+		m_used = other.m_used;
+		m_peak = other.m_peak;
+		other.m_blocks.clear();
+		other.m_current = other.m_offset = other.m_used = other.m_peak = 0;
+	}
+	return *this;
+}
+//-----------------------------------------------------------------------------
+void* LinearArena::Allocate(size_t size, size_t alignment)
+{
+	for (;;)
+	{
+		if (m_current < m_blocks.size())
+		{
+			const Block& block = m_blocks[m_current];
+			const uintptr_t base = reinterpret_cast<uintptr_t>(block.data);
+			const uintptr_t aligned = (base + m_offset + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+			const size_t offset = static_cast<size_t>(aligned - base);
+			if (offset + size <= block.size)
+			{
+				m_used += offset + size - m_offset;
+				m_peak = std::max(m_peak, m_used);
+				m_offset = offset + size;
+				return block.data + offset;
+			}
+
+			// the rest of the block is skipped, the next kept block is tried
+			m_used += block.size - m_offset;
+			m_offset = 0;
+			if (++m_current < m_blocks.size())
+				continue;
+		}
+
+		// the arena grows: only until the first frames have shown the size it needs
+		Block block;
+		block.size = std::max(m_blockSize, size + alignment);
+		block.data = static_cast<uint8_t*>(::operator new(block.size));
+		m_blocks.push_back(block);
+		m_current = m_blocks.size() - 1;
+		m_offset = 0;
+	}
+}
+//-----------------------------------------------------------------------------
+void LinearArena::Reset()
+{
+	m_current = 0;
+	m_offset = 0;
+	m_used = 0;
+}
+//-----------------------------------------------------------------------------
+size_t LinearArena::GetCapacity() const
+{
+	size_t capacity = 0;
+	for (const Block& block : m_blocks)
+		capacity += block.size;
+	return capacity;
+}
+//-----------------------------------------------------------------------------
+void LinearArena::release()
+{
+	for (const Block& block : m_blocks)
+		::operator delete(block.data);
+	m_blocks.clear();
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Linear (bump) allocator of transient data. Reset releases all allocations at once in O(1) and keeps the blocks,
+// so once the arena has grown to the size of a frame it no longer touches the heap.
+// No destructors are called - only trivially destructible objects. Not thread-safe, one arena per thread.
+class LinearArena
+{
+public:
+	explicit LinearArena(size_t blockSize = 256 * 1024);
+	LinearArena(LinearArena&& other) noexcept;
+	LinearArena(const LinearArena&) = delete;
+	~LinearArena();
+	LinearArena& operator=(LinearArena&& other) noexcept;
+	LinearArena& operator=(const LinearArena&) = delete;
+
+	void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+	// Uninitialized array
+	template<typename T>
+	T* AllocateArray(size_t count)
+	{
+		static_assert(std::is_trivially_destructible_v<T>, "LinearArena does not call destructors");
+		return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+	}
+	template<typename T, typename... Args>
+	T* New(Args&&... args)
+	{
+		static_assert(std::is_trivially_destructible_v<T>, "LinearArena does not call destructors");
+		return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+	}
+
+	void Reset();
+
+	size_t GetUsedSize() const { return m_used; } // since Reset, including the alignment padding
+	size_t GetPeakSize() const { return m_peak; }
+	size_t GetCapacity() const;
+
+private:
+	struct Block
+	{
+		uint8_t* data = nullptr;
+		size_t size = 0;
+	};
+
+	void release();
+
+	std::vector<Block> m_blocks;
+	size_t m_blockSize = 0;
+	size_t m_current = 0; // block of the next allocation
+	size_t m_offset = 0;  // in the current block
+	size_t m_used = 0;
+	size_t m_peak = 0;
+};
+
+// Standard allocator over a LinearArena: deallocate does nothing, the memory returns with LinearArena::Reset.
+// The container must be destroyed (or no longer used) before the arena is reset.
+template<typename T>
+class ArenaAllocator
+{
+	template<typename U> friend class ArenaAllocator;
+public:
+	using value_type = T;
+
+	ArenaAllocator(LinearArena& arena) noexcept : m_arena(&arena) {}
+	template<typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) noexcept : m_arena(other.m_arena) {}
+
+	T* allocate(size_t count) { return static_cast<T*>(m_arena->Allocate(sizeof(T) * count, alignof(T))); }
+	void deallocate(T*, size_t) noexcept {}
+
+	template<typename U>
+	bool operator==(const ArenaAllocator<U>& other) const noexcept { return m_arena == other.m_arena; }
+	template<typename U>
+	bool operator!=(const ArenaAllocator<U>& other) const noexcept { return m_arena != other.m_arena; }
+
+private:
+	LinearArena* m_arena;
+};
+
+template<typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
@@ -0,0 +1,120 @@
+#include "Engine.h"
+
+#include <chrono>
+#include <thread>
+
+//-----------------------------------------------------------------------------
+namespace
+{
+	double getPacerTime()
+	{
+		using namespace std::chrono;
+		return duration<double>(steady_clock::now().time_since_epoch()).count();
+	}
+}
+//-----------------------------------------------------------------------------
+bool FramePacer::Create(const wgpu::Device& device, const FramePacingInfo& info)
+{
+	m_device = device;
+	m_queue = device.GetQueue();
+	m_info = info;
+	m_info.maxFramesInFlight = std::clamp(m_info.maxFramesInFlight, 1u, 4u);
+	m_info.latencyBudget = std::max(m_info.latencyBudget, 0.0f);
+	m_slots.assign(m_info.maxFramesInFlight, FrameSlot{ this, 0.0 });
+	m_submittedCount = m_completedCount = 0;
+	m_frameStarted = false;
+	m_latency = m_gpuInterval = m_cpuTime = m_delay = 0.0;
+	return true;
+}
+//-----------------------------------------------------------------------------
+void FramePacer::Destroy()
+{
+	if (m_device)
+		waitForFrames(0);
+	m_slots.clear();
+	m_queue = nullptr;
+	m_device = nullptr;
+}
+//-----------------------------------------------------------------------------
+void FramePacer::BeginFrame()
+{
+	if (m_frameStarted || !m_device) return;
+
+	waitForFrames(m_info.maxFramesInFlight - 1);
+	if (m_delay > 0.0)
+	{
+		// sleep is coarse - the last part is spun
+		const double wakeTime = getPacerTime() + m_delay;
+		if (m_delay > 0.002)
+			std::this_thread::sleep_for(std::chrono::duration<double>(m_delay - 0.002));
+		while (getPacerTime() < wakeTime)
+			std::this_thread::yield();
+	}
+
+	m_frameStartTime = getPacerTime();
+	m_frameStarted = true;
+}
+//-----------------------------------------------------------------------------
+void FramePacer::EndFrame()
+{
+	if (!m_device) return;
+	if (!m_frameStarted) BeginFrame(); // the frame was started without WaitForNextFrame
+
+	const double submitTime = getPacerTime();
+	m_cpuTime = m_cpuTime > 0.0 ? glm::mix(m_cpuTime, submitTime - m_frameStartTime, 0.1) : submitTime - m_frameStartTime;
+
+	FrameSlot& slot = m_slots[m_submittedCount % m_slots.size()];
+	slot.startTime = m_frameStartTime;
+	m_submittedCount++;
+	m_queue.OnSubmittedWorkDone(workDoneCallback, &slot);
+	m_frameStarted = false;
+}
+//-----------------------------------------------------------------------------
+void FramePacer::workDoneCallback(WGPUQueueWorkDoneStatus /*status*/, void* userdata)
+{
+	// also on errors and device loss - the frame is no longer in flight
+	const FrameSlot* slot = static_cast<const FrameSlot*>(userdata);
+	slot->pacer->frameCompleted(*slot);
+}
+//-----------------------------------------------------------------------------
+void FramePacer::frameCompleted(const FrameSlot& slot)
+{
+	const double time = getPacerTime();
+	const double latency = time - slot.startTime;
+	m_latency = m_latency > 0.0 ? glm::mix(m_latency, latency, 0.1) : latency;
+	if (m_lastCompletedTime > 0.0)
+	{
+		const double interval = time - m_lastCompletedTime;
+		m_gpuInterval = m_gpuInterval > 0.0 ? glm::mix(m_gpuInterval, interval, 0.1) : interval;
+	}
+	m_lastCompletedTime = time;
+	m_completedCount++;
+	updateDelay();
+}
+//-----------------------------------------------------------------------------
+void FramePacer::waitForFrames(uint32_t maxFramesInFlight)
+{
+	// the callbacks are called from Tick
+	while (GetFramesInFlight() > maxFramesInFlight)
+	{
+		m_device.Tick();
+		if (GetFramesInFlight() > maxFramesInFlight)
+			std::this_thread::yield();
+	}
+}
+//-----------------------------------------------------------------------------
+void FramePacer::updateDelay()
+{
+	if (m_info.latencyBudget <= 0.0f || m_gpuInterval <= 0.0)
+	{
+		m_delay = 0.0;
+		return;
+	}
+
+	// Integral controller: a frame finishing after the budget has waited in the queue (or for vsync) - start later.
+	// The GPU finishes one frame per interval, so a start later than (interval - CPU time) would leave it idle.
+	const double error = m_latency - static_cast<double>(m_info.latencyBudget);
+	const double maxDelay = std::max(0.0, m_gpuInterval - m_cpuTime - 0.001);
+	m_delay = std::clamp(m_delay + 0.1 * error, 0.0, maxDelay);
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "RenderResources.h"
+
+struct FramePacingInfo
+{
+	// Frames submitted to the GPU and not finished yet. 1 - lowest latency, the CPU and the GPU don't overlap.
+	uint32_t maxFramesInFlight = 2;
+	// Target time from the start of a frame (input is read) to the end of its GPU work, in seconds.
+	// The start of the frame is delayed while the frames finish later than that. 0 - no delay.
+	float latencyBudget = 0.0f;
+};
+
+// Limits the frames in flight with queue.OnSubmittedWorkDone and delays the start of a frame so that it is presented
+// within the latency budget. The delay never exceeds the idle time of the GPU interval, so the GPU is not starved.
+class FramePacer
+{
+public:
+	bool Create(const wgpu::Device& device, const FramePacingInfo& info);
+	// Waits for the frames in flight
+	void Destroy();
+
+	// Blocks while maxFramesInFlight frames are on the GPU, then for the pacing delay.
+	// Called before the input of the frame is read; repeated calls before EndFrame return immediately.
+	void BeginFrame();
+	// Called after the queue.Submit of the frame
+	void EndFrame();
+
+	uint32_t GetFramesInFlight() const { return m_submittedCount - m_completedCount; }
+	// smoothed times in seconds
+	float GetLatency() const { return static_cast<float>(m_latency); }
+	float GetGpuInterval() const { return static_cast<float>(m_gpuInterval); }
+	float GetCpuTime() const { return static_cast<float>(m_cpuTime); }
+	float GetDelay() const { return static_cast<float>(m_delay); }
+
+private:
+	struct FrameSlot
+	{
+		FramePacer* pacer = nullptr;
+		double startTime = 0.0;
+	};
+
+	static void workDoneCallback(WGPUQueueWorkDoneStatus status, void* userdata);
+	void frameCompleted(const FrameSlot& slot);
+	void waitForFrames(uint32_t maxFramesInFlight);
+	void updateDelay();
+
+	wgpu::Device m_device = nullptr;
+	wgpu::Queue m_queue = nullptr;
+	FramePacingInfo m_info;
+	std::vector<FrameSlot> m_slots;
+	uint32_t m_submittedCount = 0;
+	uint32_t m_completedCount = 0;
+	bool m_frameStarted = false;
+	double m_frameStartTime = 0.0;
+	double m_lastCompletedTime = 0.0;
+
+	double m_latency = 0.0;
+	double m_gpuInterval = 0.0;
+	double m_cpuTime = 0.0;
+	double m_delay = 0.0;
+};
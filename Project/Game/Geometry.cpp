@@ -1 +1,46 @@
-#include "Geometry.h"
\ No newline at end of file
+#include "Engine.h"
+
+//-----------------------------------------------------------------------------
+BoundingBox BoundingBox::Transform(const glm::mat4& matrix) const
+{
+	if (IsEmpty()) return *this;
+
+	// the extents in the new space are the sum of the absolute values of the rotated axes (Arvo)
+	const glm::vec3 center = glm::vec3(matrix * glm::vec4(GetCenter(), 1.0f));
+	const glm::vec3 extents = GetExtents();
+	const glm::vec3 newExtents =
+		glm::abs(glm::vec3(matrix[0])) * extents.x +
+		glm::abs(glm::vec3(matrix[1])) * extents.y +
+		glm::abs(glm::vec3(matrix[2])) * extents.z;
+
+	BoundingBox box;
+	box.min = center - newExtents;
+	box.max = center + newExtents;
+	return box;
+}
+//-----------------------------------------------------------------------------
+MeshBounds ComputeMeshBounds(const void* positions, size_t vertexCount, size_t stride)
+{
+	MeshBounds bounds;
+	const uint8_t* bytes = static_cast<const uint8_t*>(positions);
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		glm::vec3 position;
+		memcpy(&position, bytes + i * stride, sizeof(position));
+		bounds.box.Add(position);
+	}
+	if (bounds.box.IsEmpty()) return bounds;
+
+	bounds.sphere.center = bounds.box.GetCenter();
+	float radiusSquared = 0.0f;
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		glm::vec3 position;
+		memcpy(&position, bytes + i * stride, sizeof(position));
+		const glm::vec3 offset = position - bounds.sphere.center;
+		radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+	}
+	bounds.sphere.radius = std::sqrt(radiusSquared);
+	return bounds;
+}
+//-----------------------------------------------------------------------------
@@ -1 +1,38 @@
 #pragma once
+
+#include <cfloat>
+
+// Axis-aligned bounding box, empty (min > max) until something is added
+struct BoundingBox
+{
+	glm::vec3 min = glm::vec3(FLT_MAX);
+	glm::vec3 max = glm::vec3(-FLT_MAX);
+
+	bool IsEmpty() const { return min.x > max.x; }
+	glm::vec3 GetCenter() const { return (min + max) * 0.5f; }
+	glm::vec3 GetExtents() const { return (max - min) * 0.5f; }
+
+	void Add(const glm::vec3& point) { min = glm::min(min, point); max = glm::max(max, point); }
+	void Add(const BoundingBox& box) { min = glm::min(min, box.min); max = glm::max(max, box.max); }
+
+	// Box around the transformed box (an empty box stays empty)
+	BoundingBox Transform(const glm::mat4& matrix) const;
+};
+
+struct BoundingSphere
+{
+	glm::vec3 center = glm::vec3(0.0f);
+	float radius = -1.0f; // < 0 - empty
+
+	bool IsEmpty() const { return radius < 0.0f; }
+};
+
+// Bounds of a mesh in its local space, computed once at load time
+struct MeshBounds
+{
+	BoundingBox box;
+	BoundingSphere sphere; // around the box center (tighter than the box corners for round meshes)
+};
+
+// positions - the first 3 floats of every vertex, stride in bytes
+MeshBounds ComputeMeshBounds(const void* positions, size_t vertexCount, size_t stride);
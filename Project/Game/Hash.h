@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+// FNV-1a 64. Structures with padding must be hashed field by field.
+// With key set the hashed bytes are also appended to it - a cache can keep the key to tell a hash collision from a hit.
+struct Fnv1aHasher
+{
+	void AddBytes(const void* data, size_t size)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		if (key) key->append(static_cast<const char*>(data), size);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 0x100000001b3ull;
+		}
+	}
+	template<typename T>
+	void Add(const T& value)
+	{
+		static_assert(std::is_scalar_v<T>);
+		AddBytes(&value, sizeof(value));
+	}
+	void AddString(const char* text)
+	{
+		const size_t length = text ? strlen(text) : 0;
+		Add(length);
+		AddBytes(text, length);
+	}
+
+	uint64_t hash = 0xcbf29ce484222325ull;
+	std::string* key = nullptr;
+};
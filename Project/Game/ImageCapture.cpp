@@ -0,0 +1,179 @@
+#include "Engine.h"
+
+#include <fstream>
+#include <thread>
+
+//-----------------------------------------------------------------------------
+namespace
+{
+	struct MapRequest
+	{
+		bool done = false;
+		bool success = false;
+	};
+
+	void mapCallback(WGPUBufferMapAsyncStatus status, void* userdata)
+	{
+		MapRequest* request = static_cast<MapRequest*>(userdata);
+		request->success = status == WGPUBufferMapAsyncStatus_Success;
+		request->done = true;
+	}
+}
+//-----------------------------------------------------------------------------
+bool ReadTexture(const wgpu::Device& device, const wgpu::Texture& texture, CapturedImage& image, uint32_t mipLevel)
+{
+	const wgpu::TextureFormat format = texture.GetFormat();
+	const bool bgra = format == wgpu::TextureFormat::BGRA8Unorm || format == wgpu::TextureFormat::BGRA8UnormSrgb;
+	if (!bgra && format != wgpu::TextureFormat::RGBA8Unorm && format != wgpu::TextureFormat::RGBA8UnormSrgb)
+	{
+		Error("ReadTexture: only RGBA8 and BGRA8 textures are supported");
+		return false;
+	}
+
+	if (mipLevel >= texture.GetMipLevelCount())
+	{
+		Error("ReadTexture: the texture has no mip level " + std::to_string(mipLevel));
+		return false;
+	}
+
+	image.width = std::max(1u, texture.GetWidth() >> mipLevel);
+	image.height = std::max(1u, texture.GetHeight() >> mipLevel);
+	// buffer rows of a texture copy are aligned to 256 bytes
+	constexpr uint32_t kBytesPerRowAlignment = 256;
+	const uint32_t rowSize = image.width * 4;
+	const uint32_t bytesPerRow = (rowSize + kBytesPerRowAlignment - 1) & ~(kBytesPerRowAlignment - 1);
+	const uint64_t bufferSize = static_cast<uint64_t>(bytesPerRow) * image.height;
+
+	wgpu::BufferDescriptor bufferDesc{};
+	bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::MapRead;
+	bufferDesc.size = bufferSize;
+	wgpu::Buffer readback = device.CreateBuffer(&bufferDesc);
+
+	wgpu::ImageCopyTexture source{};
+	source.texture = texture;
+	source.mipLevel = mipLevel;
+	wgpu::ImageCopyBuffer destination{};
+	destination.buffer = readback;
+	destination.layout.bytesPerRow = bytesPerRow;
+	destination.layout.rowsPerImage = image.height;
+	const wgpu::Extent3D copySize = { image.width, image.height, 1 };
+
+	wgpu::CommandEncoder encoder = device.CreateCommandEncoder();
+	encoder.CopyTextureToBuffer(&source, &destination, &copySize);
+	wgpu::CommandBuffer commands = encoder.Finish();
+	device.GetQueue().Submit(1, &commands);
+
+	MapRequest request;
+	readback.MapAsync(wgpu::MapMode::Read, 0, bufferSize, mapCallback, &request);
+	while (!request.done)
+	{
+		device.Tick();
+		std::this_thread::yield();
+	}
+	if (!request.success)
+	{
+		Error("ReadTexture: could not map the readback buffer");
+		return false;
+	}
+
+	const uint8_t* data = static_cast<const uint8_t*>(readback.GetConstMappedRange(0, bufferSize));
+	image.pixels.resize(static_cast<size_t>(rowSize) * image.height);
+	for (uint32_t y = 0; y < image.height; y++)
+	{
+		const uint8_t* src = data + static_cast<size_t>(y) * bytesPerRow;
+		uint8_t* dst = image.pixels.data() + static_cast<size_t>(y) * rowSize;
+		memcpy(dst, src, rowSize);
+		if (bgra)
+		{
+			for (uint32_t x = 0; x < rowSize; x += 4)
+				std::swap(dst[x], dst[x + 2]);
+		}
+	}
+	readback.Unmap();
+	return true;
+}
+//-----------------------------------------------------------------------------
+bool SaveImagePPM(const std::filesystem::path& path, const CapturedImage& image)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		Error("Could not create file: " + path.string());
+		return false;
+	}
+
+	file << "P6\n" << image.width << " " << image.height << "\n255\n";
+	std::vector<uint8_t> row(static_cast<size_t>(image.width) * 3);
+	for (uint32_t y = 0; y < image.height; y++)
+	{
+		const uint8_t* src = image.pixels.data() + static_cast<size_t>(y) * image.width * 4;
+		for (uint32_t x = 0; x < image.width; x++)
+		{
+			row[x * 3 + 0] = src[x * 4 + 0];
+			row[x * 3 + 1] = src[x * 4 + 1];
+			row[x * 3 + 2] = src[x * 4 + 2];
+		}
+		file.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size()));
+	}
+	return file.good();
+}
+//-----------------------------------------------------------------------------
+bool LoadImagePPM(const std::filesystem::path& path, CapturedImage& image)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		Error("Could not open file: " + path.string());
+		return false;
+	}
+
+	std::string magic;
+	uint32_t maxValue = 0;
+	file >> magic >> image.width >> image.height >> maxValue;
+	if (!file || magic != "P6" || maxValue != 255)
+	{
+		Error("Unsupported PPM file (only binary 8-bit P6): " + path.string());
+		return false;
+	}
+	file.get(); // the single whitespace after the header
+
+	std::vector<uint8_t> rgb(static_cast<size_t>(image.width) * image.height * 3);
+	if (!file.read(reinterpret_cast<char*>(rgb.data()), static_cast<std::streamsize>(rgb.size())))
+	{
+		Error("Truncated PPM file: " + path.string());
+		return false;
+	}
+
+	image.pixels.resize(static_cast<size_t>(image.width) * image.height * 4);
+	for (size_t i = 0, count = static_cast<size_t>(image.width) * image.height; i < count; i++)
+	{
+		image.pixels[i * 4 + 0] = rgb[i * 3 + 0];
+		image.pixels[i * 4 + 1] = rgb[i * 3 + 1];
+		image.pixels[i * 4 + 2] = rgb[i * 3 + 2];
+		image.pixels[i * 4 + 3] = 255;
+	}
+	return true;
+}
+//-----------------------------------------------------------------------------
+ImageCompareResult CompareImages(const CapturedImage& image, const CapturedImage& golden, uint8_t tolerance)
+{
+	ImageCompareResult result;
+	result.sizeMatch = image.width == golden.width && image.height == golden.height
+		&& image.pixels.size() == golden.pixels.size();
+	if (!result.sizeMatch) return result;
+
+	for (size_t i = 0; i < image.pixels.size(); i += 4)
+	{
+		uint8_t pixelDifference = 0;
+		for (size_t c = 0; c < 3; c++)
+		{
+			const int difference = std::abs(static_cast<int>(image.pixels[i + c]) - static_cast<int>(golden.pixels[i + c]));
+			pixelDifference = std::max(pixelDifference, static_cast<uint8_t>(difference));
+		}
+		result.maxDifference = std::max(result.maxDifference, pixelDifference);
+		if (pixelDifference > tolerance)
+			result.differentPixels++;
+	}
+	return result;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "RenderResources.h"
+
+// Image read back from the GPU, RGBA8 rows without padding
+struct CapturedImage
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	std::vector<uint8_t> pixels;
+};
+
+// Copies a mip level of a RGBA8/BGRA8 texture (with CopySrc usage) to the CPU. Waits for the GPU.
+bool ReadTexture(const wgpu::Device& device, const wgpu::Texture& texture, CapturedImage& image, uint32_t mipLevel = 0);
+
+// Binary PPM (P6), the alpha channel is dropped. Readable without any library, viewable almost everywhere.
+bool SaveImagePPM(const std::filesystem::path& path, const CapturedImage& image);
+bool LoadImagePPM(const std::filesystem::path& path, CapturedImage& image);
+
+struct ImageCompareResult
+{
+	bool sizeMatch = false;
+	uint32_t differentPixels = 0; // pixels with a channel difference above the tolerance
+	uint8_t maxDifference = 0;
+};
+
+// Golden image comparison of the RGB channels, the alpha is ignored (PPM has none)
+ImageCompareResult CompareImages(const CapturedImage& image, const CapturedImage& golden, uint8_t tolerance);
@@ -0,0 +1,102 @@
+#include "Engine.h"
+
+//-----------------------------------------------------------------------------
+bool InstanceBatcher::Create(const wgpu::Device& device, uint32_t maxInstances)
+{
+	m_device = device;
+	m_maxInstances = 0;
+	return Reserve(std::max(maxInstances, 1u)) && m_instanceBuffer.buffer;
+}
+//-----------------------------------------------------------------------------
+bool InstanceBatcher::Reserve(uint32_t count)
+{
+	if (count <= m_maxInstances)
+		return false;
+
+	// at least doubled - a scene that grows a little every frame doesn't recreate the buffer every frame
+	m_maxInstances = std::max(count, m_maxInstances * 2);
+	m_pending.reserve(m_maxInstances);
+	m_instances.reserve(m_maxInstances);
+	// the old buffer stays alive while the submitted frames and the bind groups use it
+	if (!m_instanceBuffer.Create(m_device, uint64_t(m_maxInstances) * sizeof(InstanceData), nullptr, wgpu::BufferUsage::Vertex) || !m_instanceBuffer.buffer)
+	{
+		Error("Could not create instance buffer!");
+		m_maxInstances = 0;
+	}
+	return true;
+}
+//-----------------------------------------------------------------------------
+void InstanceBatcher::Destroy()
+{
+	if (m_instanceBuffer.buffer) m_instanceBuffer.buffer.Destroy();
+	m_instanceBuffer.buffer = nullptr;
+	m_pending.clear();
+	m_instances.clear();
+	m_batches.clear();
+	m_device = nullptr;
+}
+//-----------------------------------------------------------------------------
+void InstanceBatcher::Begin()
+{
+	m_pending.clear();
+	m_overflow = false;
+}
+//-----------------------------------------------------------------------------
+void InstanceBatcher::Add(uint32_t mesh, uint32_t pipeline, const glm::mat4& transform, uint32_t material, uint32_t bindGroup)
+{
+	if (m_pending.size() == m_maxInstances)
+	{
+		if (!m_overflow)
+			Error("Instance batcher: more than " + std::to_string(m_maxInstances) + " instances, the rest is dropped");
+		m_overflow = true;
+		return;
+	}
+
+	PendingInstance& instance = m_pending.emplace_back();
+	instance.pipeline = pipeline;
+	instance.bindGroup = bindGroup;
+	instance.mesh = mesh;
+	instance.data.transform = transform;
+	instance.data.material = material;
+}
+//-----------------------------------------------------------------------------
+void InstanceBatcher::End()
+{
+	// stable - instances keep the submission order inside a batch
+	std::stable_sort(m_pending.begin(), m_pending.end(), [](const PendingInstance& a, const PendingInstance& b)
+		{
+			return std::tie(a.pipeline, a.bindGroup, a.mesh) < std::tie(b.pipeline, b.bindGroup, b.mesh);
+		});
+
+	m_instances.clear();
+	m_batches.clear();
+	for (size_t i = 0; i < m_pending.size(); i++)
+	{
+		const PendingInstance& instance = m_pending[i];
+		if (i == 0 || !instance.SameBatch(m_pending[i - 1]))
+		{
+			InstanceBatch& batch = m_batches.emplace_back();
+			batch.pipeline = instance.pipeline;
+			batch.bindGroup = instance.bindGroup;
+			batch.mesh = instance.mesh;
+			batch.firstInstance = static_cast<uint32_t>(m_instances.size());
+		}
+		m_batches.back().instanceCount++;
+		m_instances.push_back(instance.data);
+	}
+
+	if (!m_instances.empty())
+		WriteBuffer(m_device.GetQueue(), m_instanceBuffer.buffer, 0, m_instances.data(), m_instances.size() * sizeof(InstanceData));
+}
+//-----------------------------------------------------------------------------
+VertexBufferLayout InstanceBatcher::GetInstanceLayout(uint32_t firstLocation)
+{
+	VertexBufferLayout layout;
+	layout.SetVertexSize(sizeof(InstanceData));
+	layout.SetStepMode(wgpu::VertexStepMode::Instance);
+	for (uint32_t column = 0; column < 4; column++)
+		layout.AddAttrib(firstLocation + column, wgpu::VertexFormat::Float32x4, offsetof(InstanceData, transform) + column * sizeof(glm::vec4));
+	layout.AddAttrib(firstLocation + 4, wgpu::VertexFormat::Uint32, offsetof(InstanceData, material));
+	return layout;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "RenderResources.h"
+
+// Per-instance data in the instance buffer (WGSL: struct Instance { model: mat4x4f, material: u32 } - 80 bytes stride)
+struct InstanceData
+{
+	glm::mat4 transform = glm::mat4(1.0f);
+	uint32_t material = 0;
+	uint32_t padding[3] = {};
+};
+static_assert(sizeof(InstanceData) == 80);
+
+// Instances of one pipeline+bind group+mesh: DrawIndexed(indexCount, instanceCount, 0, 0, firstInstance)
+struct InstanceBatch
+{
+	uint32_t pipeline = 0;
+	uint32_t bindGroup = 0; // material resources (textures, samplers) that differ between batches
+	uint32_t mesh = 0;
+	uint32_t firstInstance = 0;
+	uint32_t instanceCount = 0;
+};
+
+// Collects the draws of a frame, groups identical pipeline+bind group+mesh triples and uploads all instances with one WriteBuffer.
+// The instance buffer is readable as a storage buffer (index with @builtin(instance_index))
+// or as an instance-rate vertex buffer (GetInstanceLayout).
+class InstanceBatcher
+{
+public:
+	bool Create(const wgpu::Device& device, uint32_t maxInstances);
+	void Destroy();
+
+	// Grows the instance buffer to at least count instances. Returns true when the buffer was recreated:
+	// the bind groups of GetInstanceBuffer() have to be created again.
+	bool Reserve(uint32_t count);
+
+	void Begin();
+	// The instances beyond GetMaxInstances() are dropped (Reserve before Begin to draw them all)
+	void Add(uint32_t mesh, uint32_t pipeline, const glm::mat4& transform, uint32_t material = 0, uint32_t bindGroup = 0);
+	// Sorts the instances into batches (ordered by pipeline, bind group, then mesh) and uploads them
+	void End();
+
+	const std::vector<InstanceBatch>& GetBatches() const { return m_batches; }
+	const StorageBuffer& GetInstanceBuffer() const { return m_instanceBuffer; }
+	uint32_t GetInstanceCount() const { return static_cast<uint32_t>(m_instances.size()); }
+	uint32_t GetMaxInstances() const { return m_maxInstances; }
+
+	// transform columns at firstLocation..firstLocation+3 (Float32x4), material at firstLocation+4 (Uint32)
+	static VertexBufferLayout GetInstanceLayout(uint32_t firstLocation);
+
+private:
+	struct PendingInstance
+	{
+		uint32_t pipeline;
+		uint32_t bindGroup;
+		uint32_t mesh;
+		InstanceData data;
+
+		bool SameBatch(const PendingInstance& other) const { return pipeline == other.pipeline && bindGroup == other.bindGroup && mesh == other.mesh; }
+	};
+
+	wgpu::Device m_device = nullptr;
+	StorageBuffer m_instanceBuffer;
+	uint32_t m_maxInstances = 0;
+	std::vector<PendingInstance> m_pending;
+	std::vector<InstanceData> m_instances;
+	std::vector<InstanceBatch> m_batches;
+	bool m_overflow = false; // reported once per frame
+};
@@ -0,0 +1,229 @@
+#include "Engine.h"
+
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+//-----------------------------------------------------------------------------
+thread_local uint32_t JobThreadIndex = 0;
+//-----------------------------------------------------------------------------
+struct JobQueue
+{
+	std::mutex mutex;
+	std::deque<Job> jobs;
+};
+//-----------------------------------------------------------------------------
+struct JobSystemData
+{
+	std::vector<std::unique_ptr<JobQueue>> queues; // [0] - main thread
+	std::vector<std::thread> workers;
+	std::vector<LinearArena> arenas; // one per thread, same index as queues
+
+	std::atomic<uint32_t> pendingJobs = 0;
+	std::atomic<bool> isRun = false;
+	std::mutex wakeMutex;
+	std::condition_variable wakeCondition;
+};
+//-----------------------------------------------------------------------------
+bool JobSystem::Create(uint32_t workerCount)
+{
+	if (workerCount == 0)
+	{
+		const uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	m_data = new JobSystemData;
+	m_data->queues.resize(workerCount + 1);
+	for (auto& queue : m_data->queues)
+		queue = std::make_unique<JobQueue>();
+	m_data->arenas.resize(workerCount + 1);
+
+	JobThreadIndex = 0;
+	m_data->isRun = true;
+	m_data->workers.reserve(workerCount);
+	for (uint32_t i = 0; i < workerCount; i++)
+		m_data->workers.emplace_back(&JobSystem::workerThread, this, i + 1);
+
+	Print("Job system: " + std::to_string(workerCount) + " worker threads");
+	return true;
+}
+//-----------------------------------------------------------------------------
+void JobSystem::Destroy()
+{
+	if (!m_data) return;
+
+	// finish the jobs already scheduled
+	while (tryExecuteJob(JobThreadIndex)) {}
+
+	{
+		std::lock_guard<std::mutex> lock(m_data->wakeMutex);
+		m_data->isRun = false;
+	}
+	m_data->wakeCondition.notify_all();
+	for (auto& worker : m_data->workers)
+		worker.join();
+
+	delete m_data;
+	m_data = nullptr;
+}
+//-----------------------------------------------------------------------------
+void JobSystem::Run(JobFunction function, JobCounter* counter, JobCounter* dependency)
+{
+	if (counter) counter->m_value.fetch_add(1, std::memory_order_relaxed);
+
+	Job job{ .function = std::move(function), .counter = counter };
+
+	if (dependency)
+	{
+		// the last job of the dependency flushes m_waitingJobs under the same lock (see finishJob)
+		std::lock_guard<std::mutex> lock(dependency->m_mutex);
+		if (!dependency->IsDone())
+		{
+			dependency->m_waitingJobs.push_back(std::move(job));
+			return;
+		}
+	}
+
+	push(JobThreadIndex, std::move(job));
+}
+//-----------------------------------------------------------------------------
+void JobSystem::Wait(const JobCounter& counter)
+{
+	while (!counter.IsDone())
+	{
+		if (!tryExecuteJob(JobThreadIndex))
+			std::this_thread::yield();
+	}
+	// the finishing thread may still hold the lock after the last decrement
+	std::lock_guard<std::mutex> lock(counter.m_mutex);
+}
+//-----------------------------------------------------------------------------
+void JobSystem::ParallelFor(uint32_t count, uint32_t batchSize, const ParallelForFunction& function)
+{
+	if (count == 0) return;
+
+	if (batchSize == 0)
+		batchSize = std::max(1u, count / (GetThreadCount() * 4));
+
+	if (count <= batchSize)
+	{
+		function(0, count);
+		return;
+	}
+
+	JobCounter counter;
+	// the first batch is executed by the calling thread
+	for (uint32_t begin = batchSize; begin < count; begin += batchSize)
+	{
+		const uint32_t end = std::min(begin + batchSize, count);
+		Run([&function, begin, end]() { function(begin, end); }, &counter);
+	}
+	function(0, batchSize);
+	Wait(counter);
+}
+//-----------------------------------------------------------------------------
+uint32_t JobSystem::GetThreadCount() const
+{
+	return static_cast<uint32_t>(m_data->queues.size());
+}
+//-----------------------------------------------------------------------------
+uint32_t JobSystem::GetThreadIndex()
+{
+	return JobThreadIndex;
+}
+//-----------------------------------------------------------------------------
+LinearArena& JobSystem::GetThreadArena()
+{
+	return m_data->arenas[JobThreadIndex];
+}
+//-----------------------------------------------------------------------------
+void JobSystem::ResetThreadArenas()
+{
+	for (LinearArena& arena : m_data->arenas)
+		arena.Reset();
+}
+//-----------------------------------------------------------------------------
+void JobSystem::workerThread(uint32_t threadIndex)
+{
+	JobThreadIndex = threadIndex;
+
+	while (m_data->isRun)
+	{
+		if (tryExecuteJob(threadIndex))
+			continue;
+
+		std::unique_lock<std::mutex> lock(m_data->wakeMutex);
+		m_data->wakeCondition.wait(lock, [this]() { return m_data->pendingJobs > 0 || !m_data->isRun; });
+	}
+}
+//-----------------------------------------------------------------------------
+void JobSystem::push(uint32_t queueIndex, Job&& job)
+{
+	JobQueue& queue = *m_data->queues[queueIndex];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(std::move(job));
+	}
+	m_data->pendingJobs.fetch_add(1, std::memory_order_release);
+
+	// an empty critical section orders the notify after a worker's predicate check
+	{ std::lock_guard<std::mutex> lock(m_data->wakeMutex); }
+	m_data->wakeCondition.notify_one();
+}
+//-----------------------------------------------------------------------------
+bool JobSystem::tryExecuteJob(uint32_t threadIndex)
+{
+	if (m_data->pendingJobs.load(std::memory_order_acquire) == 0)
+		return false;
+
+	Job job;
+	bool found = false;
+
+	// own queue - newest job first (hot in cache)
+	{
+		JobQueue& queue = *m_data->queues[threadIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty())
+		{
+			job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+			found = true;
+		}
+	}
+	// steal the oldest job from the other queues
+	const uint32_t queueCount = static_cast<uint32_t>(m_data->queues.size());
+	for (uint32_t i = 1; i < queueCount && !found; i++)
+	{
+		JobQueue& queue = *m_data->queues[(threadIndex + i) % queueCount];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty())
+		{
+			job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+			found = true;
+		}
+	}
+	if (!found) return false;
+
+	m_data->pendingJobs.fetch_sub(1, std::memory_order_relaxed);
+	job.function();
+	finishJob(job.counter);
+	return true;
+}
+//-----------------------------------------------------------------------------
+void JobSystem::finishJob(JobCounter* counter)
+{
+	if (!counter) return;
+
+	std::vector<Job> waitingJobs;
+	{
+		std::lock_guard<std::mutex> lock(counter->m_mutex);
+		if (counter->m_value.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			waitingJobs.swap(counter->m_waitingJobs);
+	}
+	// the counter may already be destroyed by a waiting thread from here on
+	for (auto& job : waitingJobs)
+		push(JobThreadIndex, std::move(job));
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "FrameAllocator.h"
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+using JobFunction = std::function<void()>;
+using ParallelForFunction = std::function<void(uint32_t begin, uint32_t end)>;
+
+struct Job
+{
+	JobFunction function;
+	class JobCounter* counter = nullptr;
+};
+
+// Number of unfinished jobs of a group. Jobs scheduled with a dependency on the counter start when it reaches zero.
+class JobCounter
+{
+	friend class JobSystem;
+public:
+	JobCounter() = default;
+	JobCounter(JobCounter&&) = delete;
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator=(JobCounter&&) = delete;
+	JobCounter& operator=(const JobCounter&) = delete;
+
+	bool IsDone() const { return m_value.load(std::memory_order_acquire) == 0; }
+
+private:
+	std::atomic<uint32_t> m_value = 0;
+	mutable std::mutex m_mutex;
+	std::vector<Job> m_waitingJobs; // jobs that depend on this counter
+};
+
+struct JobSystemData;
+
+// Work-stealing scheduler: every thread owns a deque, pops its own jobs LIFO and steals from the others FIFO.
+// Thread index 0 is the thread that created the system (main thread), workers are 1..N.
+class JobSystem
+{
+public:
+	// workerCount = 0 - one worker per hardware thread except the main one
+	bool Create(uint32_t workerCount = 0);
+	void Destroy();
+
+	// counter (optional) is incremented now and decremented when the job is finished.
+	// The job is not started until dependency (optional) is done.
+	void Run(JobFunction function, JobCounter* counter = nullptr, JobCounter* dependency = nullptr);
+
+	// Blocks until counter is done. The calling thread executes pending jobs meanwhile.
+	// A counter must not be destroyed before Wait on it has returned.
+	void Wait(const JobCounter& counter);
+
+	// Calls function(begin, end) for [0, count) split into batches of batchSize on all threads and waits for the result.
+	// batchSize = 0 - chosen from count and the number of threads.
+	void ParallelFor(uint32_t count, uint32_t batchSize, const ParallelForFunction& function);
+
+	// Workers + main thread
+	uint32_t GetThreadCount() const;
+	// Index of the calling thread (0 for the main thread and for threads not owned by the job system)
+	static uint32_t GetThreadIndex();
+
+	// Transient memory of the calling thread (jobs, the main thread), released by ResetThreadArenas at the frame end.
+	// Only for threads of the job system (the render thread has its own frame arena) and only for jobs that end in the frame.
+	LinearArena& GetThreadArena();
+	// Called by Engine when the jobs of the frame are finished
+	void ResetThreadArenas();
+
+private:
+	void workerThread(uint32_t threadIndex);
+	void push(uint32_t queueIndex, Job&& job);
+	bool tryExecuteJob(uint32_t threadIndex);
+	void finishJob(JobCounter* counter);
+
+	JobSystemData* m_data = nullptr;
+};
@@ -0,0 +1,297 @@
+#include "Engine.h"
+#include "Hash.h"
+
+#include <cfloat>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+
+#if defined(_WIN32)
+#	define WIN32_LEAN_AND_MEAN
+#	define NOMINMAX
+#	include <Windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// Read-only memory mapping of a whole file
+struct MappedFile
+{
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile() { Close(); }
+
+	bool Open(const std::filesystem::path& path);
+	void Close();
+
+	const uint8_t* data = nullptr;
+	uint64_t size = 0;
+private:
+#if defined(_WIN32)
+	HANDLE m_file = INVALID_HANDLE_VALUE;
+	HANDLE m_mapping = nullptr;
+#else
+	int m_file = -1;
+#endif
+};
+//-----------------------------------------------------------------------------
+bool MappedFile::Open(const std::filesystem::path& path)
+{
+	Close();
+#if defined(_WIN32)
+	m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER fileSize{};
+	if (!GetFileSizeEx(m_file, &fileSize)) { Close(); return false; }
+	size = static_cast<uint64_t>(fileSize.QuadPart);
+	if (size == 0) return true; // an empty file can't be mapped
+
+	m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_mapping) { Close(); return false; }
+	data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+	m_file = open(path.c_str(), O_RDONLY);
+	if (m_file < 0) return false;
+
+	struct stat fileStat{};
+	if (fstat(m_file, &fileStat) != 0) { Close(); return false; }
+	size = static_cast<uint64_t>(fileStat.st_size);
+	if (size == 0) return true; // an empty file can't be mapped
+
+	void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, m_file, 0);
+	data = mapping != MAP_FAILED ? static_cast<const uint8_t*>(mapping) : nullptr;
+#endif
+	if (!data) { Close(); return false; }
+	return true;
+}
+//-----------------------------------------------------------------------------
+void MappedFile::Close()
+{
+#if defined(_WIN32)
+	if (data) UnmapViewOfFile(data);
+	if (m_mapping) CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+	m_mapping = nullptr;
+	m_file = INVALID_HANDLE_VALUE;
+#else
+	if (data) munmap(const_cast<uint8_t*>(data), size);
+	if (m_file >= 0) close(m_file);
+	m_file = -1;
+#endif
+	data = nullptr;
+	size = 0;
+}
+//-----------------------------------------------------------------------------
+struct MeshCacheData
+{
+	MappedFile file;
+	std::vector<uint8_t> memory; // Build could not write the cache file
+};
+//-----------------------------------------------------------------------------
+namespace
+{
+	uint64_t hashBytes(const uint8_t* data, uint64_t size)
+	{
+		Fnv1aHasher hasher;
+		hasher.AddBytes(data, size);
+		return hasher.hash;
+	}
+
+	int64_t getSourceTime(const std::filesystem::path& path)
+	{
+		std::error_code error;
+		const auto time = std::filesystem::last_write_time(path, error);
+		return error ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+	}
+
+	// in place, the file must not be mapped (Windows doesn't share the mapped file for writing)
+	bool writeSourceTime(const std::filesystem::path& cachePath, int64_t sourceTime)
+	{
+		std::fstream file(cachePath, std::ios::binary | std::ios::in | std::ios::out);
+		file.seekp(offsetof(MeshCacheHeader, sourceTime));
+		file.write(reinterpret_cast<const char*>(&sourceTime), sizeof(sourceTime));
+		return file.good();
+	}
+}
+//-----------------------------------------------------------------------------
+MeshCache::~MeshCache()
+{
+	Close();
+}
+//-----------------------------------------------------------------------------
+bool MeshCache::Open(const std::filesystem::path& cachePath, const std::filesystem::path& sourcePath, uint32_t vertexStride)
+{
+	Close();
+	m_data = new MeshCacheData;
+	if (!m_data->file.Open(cachePath) || m_data->file.size < sizeof(MeshCacheHeader))
+	{
+		Close();
+		return false;
+	}
+
+	const MeshCacheHeader* header = reinterpret_cast<const MeshCacheHeader*>(m_data->file.data);
+	if (header->magic != MeshCacheMagic || header->version != MeshCacheVersion || header->vertexStride != vertexStride
+		|| (header->indexStride != sizeof(uint16_t) && header->indexStride != sizeof(uint32_t))
+		|| m_data->file.size != sizeof(MeshCacheHeader) + uint64_t(header->vertexCount) * header->vertexStride + getIndexDataSize(header->indexCount, header->indexStride))
+	{
+		Close();
+		return false;
+	}
+
+	// without the source the cache is used as is
+	std::error_code error;
+	const uint64_t sourceSize = std::filesystem::file_size(sourcePath, error);
+	if (!error)
+	{
+		if (sourceSize != header->sourceSize)
+		{
+			Close();
+			return false;
+		}
+		// the file was touched - only a changed content invalidates the cache
+		const int64_t sourceTime = getSourceTime(sourcePath);
+		if (sourceTime != header->sourceTime)
+		{
+			MappedFile source;
+			if (!source.Open(sourcePath) || hashBytes(source.data, source.size) != header->sourceHash)
+			{
+				Close();
+				return false;
+			}
+
+			// the same content: the new time is stored, so the next Open doesn't hash the source again
+			Close();
+			if (!writeSourceTime(cachePath, sourceTime))
+			{
+				Warning("Could not update mesh cache: " + cachePath.string());
+				return false;
+			}
+			return Open(cachePath, sourcePath, vertexStride);
+		}
+	}
+
+	m_header = header;
+	return true;
+}
+//-----------------------------------------------------------------------------
+bool MeshCache::Build(const std::filesystem::path& cachePath, const std::filesystem::path& sourcePath,
+	uint32_t vertexStride, const void* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount,
+	const MeshBounds* bounds)
+{
+	Close();
+	if (vertexStride < 3 * sizeof(float) || vertexStride % sizeof(float) != 0)
+	{
+		Error("Mesh cache: invalid vertex stride " + std::to_string(vertexStride));
+		return false;
+	}
+
+	MeshCacheHeader header;
+	header.vertexStride = vertexStride;
+	header.vertexCount = vertexCount;
+	header.indexCount = indexCount;
+	header.indexStride = vertexCount <= 0x10000 ? sizeof(uint16_t) : sizeof(uint32_t);
+	{
+		MappedFile source;
+		if (source.Open(sourcePath))
+		{
+			header.sourceSize = source.size;
+			header.sourceHash = hashBytes(source.data, source.size);
+		}
+		header.sourceTime = getSourceTime(sourcePath);
+	}
+
+	// an empty mesh has zero bounds
+	MeshBounds meshBounds = { { glm::vec3(0.0f), glm::vec3(0.0f) }, { glm::vec3(0.0f), 0.0f } };
+	if (bounds)
+		meshBounds = *bounds;
+	else if (vertexCount > 0)
+		meshBounds = ComputeMeshBounds(vertices, vertexCount, vertexStride);
+	memcpy(header.boundsMin, &meshBounds.box.min, sizeof(header.boundsMin));
+	memcpy(header.boundsMax, &meshBounds.box.max, sizeof(header.boundsMax));
+	memcpy(header.boundsSphere, &meshBounds.sphere.center, sizeof(float) * 3);
+	header.boundsSphere[3] = meshBounds.sphere.radius;
+
+	const uint64_t vertexDataSize = uint64_t(vertexCount) * vertexStride;
+	const uint64_t indexDataSize = getIndexDataSize(indexCount, header.indexStride);
+	std::vector<uint8_t> indexData(indexDataSize, 0);
+	if (header.indexStride == sizeof(uint16_t))
+	{
+		uint16_t* indices16 = reinterpret_cast<uint16_t*>(indexData.data());
+		for (uint32_t i = 0; i < indexCount; i++)
+			indices16[i] = static_cast<uint16_t>(indices[i]);
+	}
+	else if (indexCount > 0)
+		memcpy(indexData.data(), indices, uint64_t(indexCount) * sizeof(uint32_t));
+	{
+		std::ofstream file(cachePath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(static_cast<const char*>(vertices), static_cast<std::streamsize>(vertexDataSize));
+		file.write(reinterpret_cast<const char*>(indexData.data()), static_cast<std::streamsize>(indexDataSize));
+		if (file.good())
+		{
+			file.close();
+			if (Open(cachePath, sourcePath, vertexStride))
+				return true;
+		}
+	}
+
+	Warning("Could not write mesh cache: " + cachePath.string());
+	Close();
+	m_data = new MeshCacheData;
+	m_data->memory.resize(sizeof(header) + vertexDataSize + indexDataSize);
+	memcpy(m_data->memory.data(), &header, sizeof(header));
+	memcpy(m_data->memory.data() + sizeof(header), vertices, vertexDataSize);
+	memcpy(m_data->memory.data() + sizeof(header) + vertexDataSize, indexData.data(), indexDataSize);
+	m_header = reinterpret_cast<const MeshCacheHeader*>(m_data->memory.data());
+	return true;
+}
+//-----------------------------------------------------------------------------
+void MeshCache::Close()
+{
+	delete m_data;
+	m_data = nullptr;
+	m_header = nullptr;
+}
+//-----------------------------------------------------------------------------
+bool MeshCache::CreateBuffers(const wgpu::Device& device, VertexBuffer& vertexBuffer, IndexBuffer& indexBuffer) const
+{
+	if (!IsOpen() || m_header->vertexCount == 0 || m_header->indexCount == 0)
+		return false;
+
+	return vertexBuffer.Create(device, GetVertexDataSize(), GetVertexData())
+		&& indexBuffer.Create(device, GetIndexDataSize(), GetIndexData());
+}
+//-----------------------------------------------------------------------------
+MeshBounds MeshCache::GetBounds() const
+{
+	MeshBounds bounds;
+	memcpy(&bounds.box.min, m_header->boundsMin, sizeof(m_header->boundsMin));
+	memcpy(&bounds.box.max, m_header->boundsMax, sizeof(m_header->boundsMax));
+	memcpy(&bounds.sphere.center, m_header->boundsSphere, sizeof(float) * 3);
+	bounds.sphere.radius = m_header->boundsSphere[3];
+	return bounds;
+}
+//-----------------------------------------------------------------------------
+const void* MeshCache::GetVertexData() const
+{
+	return reinterpret_cast<const uint8_t*>(m_header) + sizeof(MeshCacheHeader);
+}
+//-----------------------------------------------------------------------------
+const void* MeshCache::GetIndexData() const
+{
+	return reinterpret_cast<const uint8_t*>(m_header) + sizeof(MeshCacheHeader) + GetVertexDataSize();
+}
+//-----------------------------------------------------------------------------
+std::filesystem::path MeshCache::GetCachePath(const std::filesystem::path& sourcePath)
+{
+	std::filesystem::path cachePath = sourcePath;
+	cachePath += ".mesh";
+	return cachePath;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "RenderResources.h"
+#include "Geometry.h"
+
+constexpr uint32_t MeshCacheMagic = 0x4853454D; // "MESH"
+constexpr uint32_t MeshCacheVersion = 4; // also bumped when the mesh processing changes
+
+// File layout: header, vertexCount * vertexStride bytes of interleaved vertices, indexCount indices of indexStride bytes
+// (16-bit when the mesh has at most 65536 vertices, the stream is padded to 4 bytes)
+struct MeshCacheHeader
+{
+	uint32_t magic = MeshCacheMagic;
+	uint32_t version = MeshCacheVersion;
+	uint32_t vertexStride = 0;
+	uint32_t vertexCount = 0;
+	uint32_t indexCount = 0;
+	uint32_t indexStride = sizeof(uint32_t); // 2 or 4
+
+	// source file the cache was built from
+	uint64_t sourceSize = 0;
+	int64_t sourceTime = 0; // last write time
+	uint64_t sourceHash = 0; // FNV-1a of the content
+
+	float boundsMin[3] = {};
+	float boundsMax[3] = {};
+	float boundsSphere[4] = {}; // center, radius
+};
+
+struct MeshCacheData;
+
+// Binary mesh cache. The file is memory-mapped and the vertex/index streams are uploaded to the GPU as they are stored,
+// so a cached model costs no parsing and no per-vertex work on load.
+class MeshCache
+{
+public:
+	MeshCache() = default;
+	MeshCache(MeshCache&&) = delete;
+	MeshCache(const MeshCache&) = delete;
+	~MeshCache();
+	MeshCache& operator=(MeshCache&&) = delete;
+	MeshCache& operator=(const MeshCache&) = delete;
+
+	// Maps the cache. Fails when the file is missing or invalid, has another version or vertexStride,
+	// or was built from another content of sourcePath.
+	bool Open(const std::filesystem::path& cachePath, const std::filesystem::path& sourcePath, uint32_t vertexStride);
+
+	// Stores the mesh built from sourcePath into cachePath and serves it from there.
+	// Without bounds the position must be the first 3 floats of a vertex, the bounds are computed from it
+	// (pass them for the quantized vertices). Indices are stored as 16-bit when they fit.
+	// If the file can't be written, the data is kept in memory.
+	bool Build(const std::filesystem::path& cachePath, const std::filesystem::path& sourcePath,
+		uint32_t vertexStride, const void* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount,
+		const MeshBounds* bounds = nullptr);
+
+	void Close();
+
+	bool CreateBuffers(const wgpu::Device& device, VertexBuffer& vertexBuffer, IndexBuffer& indexBuffer) const;
+
+	bool IsOpen() const { return m_header != nullptr; }
+	const MeshCacheHeader& GetHeader() const { return *m_header; }
+	MeshBounds GetBounds() const;
+	uint32_t GetVertexCount() const { return m_header->vertexCount; }
+	uint32_t GetIndexCount() const { return m_header->indexCount; }
+	const void* GetVertexData() const;
+	const void* GetIndexData() const;
+	wgpu::IndexFormat GetIndexFormat() const { return m_header->indexStride == sizeof(uint16_t) ? wgpu::IndexFormat::Uint16 : wgpu::IndexFormat::Uint32; }
+	uint64_t GetVertexDataSize() const { return uint64_t(m_header->vertexCount) * m_header->vertexStride; }
+	uint64_t GetIndexDataSize() const { return getIndexDataSize(m_header->indexCount, m_header->indexStride); }
+
+	// "model.obj" -> "model.obj.mesh"
+	static std::filesystem::path GetCachePath(const std::filesystem::path& sourcePath);
+
+private:
+	static uint64_t getIndexDataSize(uint32_t indexCount, uint32_t indexStride) { return (uint64_t(indexCount) * indexStride + 3) & ~uint64_t(3); }
+
+	MeshCacheData* m_data = nullptr;
+	const MeshCacheHeader* m_header = nullptr;
+};
@@ -0,0 +1,375 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+std::string VertexCacheStats::ToString() const
+{
+	char text[64];
+	snprintf(text, sizeof(text), "ACMR %.3f ATVR %.3f", acmr, atvr);
+	return text;
+}
+//-----------------------------------------------------------------------------
+VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+{
+	VertexCacheStats stats;
+	if (indexCount < 3 || vertexCount == 0) return stats;
+
+	// FIFO: a vertex is in the cache while fewer than cacheSize misses happened after its own
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	uint32_t time = cacheSize + 1;
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		const uint32_t index = indices[i];
+		if (time - timestamps[index] > cacheSize)
+		{
+			timestamps[index] = time++;
+			stats.vertexTransforms++;
+		}
+	}
+
+	stats.acmr = float(stats.vertexTransforms) / float(indexCount / 3);
+	stats.atvr = float(stats.vertexTransforms) / float(vertexCount);
+	return stats;
+}
+//-----------------------------------------------------------------------------
+// Forsyth scoring constants (see "Linear-Speed Vertex Cache Optimisation")
+constexpr uint32_t ForsythCacheSize = 32;
+constexpr uint32_t ForsythMaxValence = 32;
+constexpr float ForsythCacheDecayPower = 1.5f;
+constexpr float ForsythLastTriangleScore = 0.75f;
+constexpr float ForsythValenceBoostScale = 2.0f;
+constexpr float ForsythValenceBoostPower = 0.5f;
+
+struct ForsythScoreTable
+{
+	ForsythScoreTable()
+	{
+		for (uint32_t i = 0; i < ForsythCacheSize; i++)
+		{
+			// the 3 vertices of the last triangle get a fixed score, otherwise a repeated triangle would be preferred
+			cache[i] = i < 3 ? ForsythLastTriangleScore : std::pow(1.0f - float(i - 3) / float(ForsythCacheSize - 3), ForsythCacheDecayPower);
+		}
+		valence[0] = 0.0f;
+		for (uint32_t i = 1; i <= ForsythMaxValence; i++)
+			valence[i] = ForsythValenceBoostScale * std::pow(float(i), -ForsythValenceBoostPower);
+	}
+
+	float Get(int cachePosition, uint32_t liveTriangles) const
+	{
+		if (liveTriangles == 0) return -1.0f;
+		const float cacheScore = cachePosition >= 0 ? cache[cachePosition] : 0.0f;
+		return cacheScore + valence[std::min(liveTriangles, ForsythMaxValence)];
+	}
+
+	float cache[ForsythCacheSize];
+	float valence[ForsythMaxValence + 1];
+};
+//-----------------------------------------------------------------------------
+void OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount)
+{
+	static const ForsythScoreTable scoreTable;
+	constexpr uint32_t InvalidTriangle = ~0u;
+
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0 || vertexCount == 0) return;
+
+	const std::vector<uint32_t> source(indices, indices + triangleCount * 3);
+
+	// vertex -> triangles, the live (not yet emitted) triangles are kept at the front of each list
+	std::vector<uint32_t> liveTriangles(vertexCount, 0);
+	for (uint32_t index : source)
+		liveTriangles[index]++;
+
+	std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+	std::partial_sum(liveTriangles.begin(), liveTriangles.end(), adjacencyOffset.begin() + 1);
+	std::vector<uint32_t> adjacency(source.size());
+	{
+		std::vector<uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+		for (size_t i = 0; i < source.size(); i++)
+			adjacency[fill[source[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+		vertexScore[v] = scoreTable.Get(-1, liveTriangles[v]);
+
+	std::vector<float> triangleScore(triangleCount);
+	std::vector<bool> emitted(triangleCount, false);
+	uint32_t bestTriangle = 0;
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		triangleScore[t] = vertexScore[source[3 * t + 0]] + vertexScore[source[3 * t + 1]] + vertexScore[source[3 * t + 2]];
+		if (triangleScore[t] > triangleScore[bestTriangle])
+			bestTriangle = static_cast<uint32_t>(t);
+	}
+
+	uint32_t cache[ForsythCacheSize + 3];
+	uint32_t cacheCount = 0;
+	size_t nextUnemitted = 0;
+
+	for (size_t output = 0; output < triangleCount; output++)
+	{
+		if (bestTriangle == InvalidTriangle)
+		{
+			// nothing in the cache has live triangles - continue with the next unemitted one in the input order
+			while (emitted[nextUnemitted]) nextUnemitted++;
+			bestTriangle = static_cast<uint32_t>(nextUnemitted);
+		}
+
+		const uint32_t* triangle = &source[3 * size_t(bestTriangle)];
+		memcpy(destination + 3 * output, triangle, 3 * sizeof(uint32_t));
+		emitted[bestTriangle] = true;
+
+		// remove the triangle from the live lists of its vertices
+		for (uint32_t k = 0; k < 3; k++)
+		{
+			const uint32_t v = triangle[k];
+			uint32_t* list = &adjacency[adjacencyOffset[v]];
+			const uint32_t count = liveTriangles[v];
+			for (uint32_t i = 0; i < count; i++)
+			{
+				if (list[i] == bestTriangle)
+				{
+					std::swap(list[i], list[count - 1]);
+					break;
+				}
+			}
+			liveTriangles[v]--;
+		}
+
+		// LRU: the triangle vertices move to the front
+		uint32_t newCache[ForsythCacheSize + 3];
+		uint32_t newCacheCount = 0;
+		for (uint32_t k = 0; k < 3; k++)
+			newCache[newCacheCount++] = triangle[k];
+		for (uint32_t i = 0; i < cacheCount; i++)
+		{
+			const uint32_t v = cache[i];
+			if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+				newCache[newCacheCount++] = v;
+		}
+
+		// rescore the vertices whose cache position changed (including the ones pushed out) and their live triangles
+		for (uint32_t i = 0; i < newCacheCount; i++)
+		{
+			const uint32_t v = newCache[i];
+			cachePosition[v] = i < ForsythCacheSize ? int(i) : -1;
+
+			const float score = scoreTable.Get(cachePosition[v], liveTriangles[v]);
+			const float delta = score - vertexScore[v];
+			vertexScore[v] = score;
+
+			const uint32_t* list = &adjacency[adjacencyOffset[v]];
+			for (uint32_t j = 0; j < liveTriangles[v]; j++)
+				triangleScore[list[j]] += delta;
+		}
+
+		cacheCount = std::min(newCacheCount, ForsythCacheSize);
+		memcpy(cache, newCache, cacheCount * sizeof(uint32_t));
+
+		// the next triangle is the best one that uses a cached vertex
+		bestTriangle = InvalidTriangle;
+		float bestScore = -1.0f;
+		for (uint32_t i = 0; i < cacheCount; i++)
+		{
+			const uint32_t v = cache[i];
+			const uint32_t* list = &adjacency[adjacencyOffset[v]];
+			for (uint32_t j = 0; j < liveTriangles[v]; j++)
+			{
+				if (triangleScore[list[j]] > bestScore)
+				{
+					bestScore = triangleScore[list[j]];
+					bestTriangle = list[j];
+				}
+			}
+		}
+	}
+}
+//-----------------------------------------------------------------------------
+void OptimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+	const void* positions, size_t vertexCount, size_t positionStride, float threshold)
+{
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0 || vertexCount == 0) return;
+
+	const std::vector<uint32_t> source(indices, indices + triangleCount * 3);
+	const uint8_t* positionBytes = static_cast<const uint8_t*>(positions);
+	auto getPosition = [&](uint32_t index, float out[3]) { memcpy(out, positionBytes + index * positionStride, 3 * sizeof(float)); };
+
+	// cache misses of a triangle with the FIFO cache state of the order so far
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	uint32_t time = DefaultVertexCacheSize + 1;
+	auto simulateTriangle = [&](size_t t)
+	{
+		uint32_t misses = 0;
+		for (uint32_t k = 0; k < 3; k++)
+		{
+			const uint32_t index = source[3 * t + k];
+			if (time - timestamps[index] > DefaultVertexCacheSize)
+			{
+				timestamps[index] = time++;
+				misses++;
+			}
+		}
+		return misses;
+	};
+	auto resetCache = [&]() { time += DefaultVertexCacheSize + 1; };
+
+	// hard boundaries: a triangle that misses all 3 vertices starts a new cluster anyway
+	std::vector<size_t> hardClusters;
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		if (simulateTriangle(t) == 3)
+			hardClusters.push_back(t);
+	}
+	if (hardClusters.empty() || hardClusters[0] != 0) hardClusters.insert(hardClusters.begin(), 0);
+	hardClusters.push_back(triangleCount);
+
+	// soft boundaries: split a cluster as soon as its prefix (with a cold cache) is within threshold of the cluster miss ratio
+	std::vector<size_t> clusters;
+	for (size_t c = 0; c + 1 < hardClusters.size(); c++)
+	{
+		const size_t begin = hardClusters[c];
+		const size_t end = hardClusters[c + 1];
+
+		resetCache();
+		uint32_t clusterMisses = 0;
+		for (size_t t = begin; t < end; t++)
+			clusterMisses += simulateTriangle(t);
+		const float clusterThreshold = threshold * float(clusterMisses) / float(end - begin);
+
+		size_t start = begin;
+		while (start < end)
+		{
+			clusters.push_back(start);
+			resetCache();
+			uint32_t misses = 0;
+			size_t t = start;
+			for (; t < end; t++)
+			{
+				misses += simulateTriangle(t);
+				if (float(misses) <= clusterThreshold * float(t - start + 1))
+				{
+					t++;
+					break;
+				}
+			}
+			start = t;
+		}
+	}
+	clusters.push_back(triangleCount);
+
+	// sort key of a cluster: how much its area-weighted normal points away from the mesh centroid
+	const size_t clusterCount = clusters.size() - 1;
+	std::vector<float> clusterCentroid(3 * clusterCount, 0.0f);
+	std::vector<float> clusterNormal(3 * clusterCount, 0.0f);
+	std::vector<float> clusterArea(clusterCount, 0.0f);
+	float meshCentroid[3] = { 0.0f, 0.0f, 0.0f };
+	float meshArea = 0.0f;
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		for (size_t t = clusters[c]; t < clusters[c + 1]; t++)
+		{
+			float p0[3], p1[3], p2[3];
+			getPosition(source[3 * t + 0], p0);
+			getPosition(source[3 * t + 1], p1);
+			getPosition(source[3 * t + 2], p2);
+
+			const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			const float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			const float area = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				clusterCentroid[3 * c + k] += (p0[k] + p1[k] + p2[k]) * (area / 3.0f);
+				clusterNormal[3 * c + k] += n[k];
+			}
+			clusterArea[c] += area;
+		}
+
+		for (uint32_t k = 0; k < 3; k++)
+			meshCentroid[k] += clusterCentroid[3 * c + k];
+		meshArea += clusterArea[c];
+
+		const float inverseArea = clusterArea[c] > 0.0f ? 1.0f / clusterArea[c] : 0.0f;
+		for (uint32_t k = 0; k < 3; k++)
+			clusterCentroid[3 * c + k] *= inverseArea;
+	}
+	for (uint32_t k = 0; k < 3; k++)
+		meshCentroid[k] *= meshArea > 0.0f ? 1.0f / meshArea : 0.0f;
+
+	std::vector<float> sortKey(clusterCount);
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		const float* n = &clusterNormal[3 * c];
+		const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		float dot = 0.0f;
+		for (uint32_t k = 0; k < 3; k++)
+			dot += (clusterCentroid[3 * c + k] - meshCentroid[k]) * n[k];
+		sortKey[c] = length > 0.0f ? dot / length : 0.0f;
+	}
+
+	std::vector<uint32_t> clusterOrder(clusterCount);
+	std::iota(clusterOrder.begin(), clusterOrder.end(), 0u);
+	std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&](uint32_t a, uint32_t b) { return sortKey[a] > sortKey[b]; });
+
+	size_t output = 0;
+	for (uint32_t c : clusterOrder)
+	{
+		const size_t count = 3 * (clusters[c + 1] - clusters[c]);
+		memcpy(destination + output, &source[3 * clusters[c]], count * sizeof(uint32_t));
+		output += count;
+	}
+}
+//-----------------------------------------------------------------------------
+size_t OptimizeVertexFetch(void* vertices, uint32_t* indices, size_t indexCount, size_t vertexCount, size_t vertexSize)
+{
+	constexpr uint32_t Unused = ~0u;
+	std::vector<uint32_t> remap(vertexCount, Unused);
+	uint32_t nextVertex = 0;
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		uint32_t& newIndex = remap[indices[i]];
+		if (newIndex == Unused)
+			newIndex = nextVertex++;
+		indices[i] = newIndex;
+	}
+
+	uint8_t* vertexBytes = static_cast<uint8_t*>(vertices);
+	const std::vector<uint8_t> source(vertexBytes, vertexBytes + vertexCount * vertexSize);
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		if (remap[v] != Unused)
+			memcpy(vertexBytes + remap[v] * vertexSize, &source[v * vertexSize], vertexSize);
+	}
+	return nextVertex;
+}
+//-----------------------------------------------------------------------------
+size_t OptimizeMesh(void* vertices, size_t vertexCount, size_t vertexSize, uint32_t* indices, size_t indexCount, MeshOptimizationStats* stats)
+{
+	if (stats)
+	{
+		stats->before = AnalyzeVertexCache(indices, indexCount, vertexCount);
+		stats->vertexCountBefore = vertexCount;
+	}
+
+	OptimizeVertexCache(indices, indices, indexCount, vertexCount);
+	OptimizeOverdraw(indices, indices, indexCount, vertices, vertexCount, vertexSize);
+	vertexCount = OptimizeVertexFetch(vertices, indices, indexCount, vertexCount, vertexSize);
+
+	if (stats)
+	{
+		stats->after = AnalyzeVertexCache(indices, indexCount, vertexCount);
+		stats->vertexCountAfter = vertexCount;
+	}
+	return vertexCount;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Post-transform vertex cache efficiency of a triangle list (FIFO cache simulation)
+struct VertexCacheStats
+{
+	std::string ToString() const;
+
+	uint32_t vertexTransforms = 0; // cache misses
+	float acmr = 0.0f; // average cache miss ratio: transforms per triangle (0.5 - ideal grid, 3 - no reuse)
+	float atvr = 0.0f; // average transform to vertex ratio: transforms per vertex (1 - ideal)
+};
+
+constexpr uint32_t DefaultVertexCacheSize = 16;
+
+VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = DefaultVertexCacheSize);
+
+// Reorders triangles for the post-transform vertex cache (Tom Forsyth's linear-speed algorithm).
+// destination may be the same array as indices.
+void OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+// Reorders clusters of a cache-optimized triangle list so that outward-facing parts are drawn first
+// (Sander et al. "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw").
+// Clusters are split where the cache miss ratio stays within threshold of the original order.
+// positions - float3 at the start of every vertex, positionStride in bytes. destination may be the same array as indices.
+void OptimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+	const void* positions, size_t vertexCount, size_t positionStride, float threshold = 1.05f);
+
+// Reorders vertices in the order of first use by the indices and remaps the indices.
+// Unreferenced vertices are dropped, returns the new number of vertices.
+size_t OptimizeVertexFetch(void* vertices, uint32_t* indices, size_t indexCount, size_t vertexCount, size_t vertexSize);
+
+struct MeshOptimizationStats
+{
+	VertexCacheStats before;
+	VertexCacheStats after;
+	size_t vertexCountBefore = 0;
+	size_t vertexCountAfter = 0;
+};
+
+// Vertex cache, overdraw and vertex fetch optimization of an indexed triangle list.
+// The position must be the first 3 floats of a vertex. Returns the new number of vertices.
+size_t OptimizeMesh(void* vertices, size_t vertexCount, size_t vertexSize, uint32_t* indices, size_t indexCount, MeshOptimizationStats* stats = nullptr);
@@ -0,0 +1,207 @@
+#include "MipGenerator.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+//-----------------------------------------------------------------------------
+uint32_t GetMipLevelCount(uint32_t width, uint32_t height)
+{
+	return static_cast<uint32_t>(std::bit_width(std::max({ width, height, 1u })));
+}
+//-----------------------------------------------------------------------------
+// Any destination pixel: 1..3 source columns x 1..3 source rows (borders of odd and 1 pixel wide images)
+static void filterPixel(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint32_t x, uint32_t y, uint8_t* out)
+{
+	const uint32_t dstWidth = GetMipLevelSize(srcWidth);
+	const uint32_t dstHeight = GetMipLevelSize(srcHeight);
+
+	const uint32_t columnBegin = srcWidth == 1 ? 0 : 2 * x;
+	const uint32_t columnEnd = srcWidth == 1 ? 1 : ((srcWidth & 1) && x == dstWidth - 1 ? srcWidth : 2 * x + 2);
+	const uint32_t rowBegin = srcHeight == 1 ? 0 : 2 * y;
+	const uint32_t rowEnd = srcHeight == 1 ? 1 : ((srcHeight & 1) && y == dstHeight - 1 ? srcHeight : 2 * y + 2);
+
+	uint32_t sum[4] = { 0, 0, 0, 0 };
+	for (uint32_t row = rowBegin; row < rowEnd; row++)
+	{
+		const uint8_t* p = src + 4 * (size_t(row) * srcWidth + columnBegin);
+		for (uint32_t column = columnBegin; column < columnEnd; column++, p += 4)
+		{
+			sum[0] += p[0];
+			sum[1] += p[1];
+			sum[2] += p[2];
+			sum[3] += p[3];
+		}
+	}
+
+	const uint32_t count = (columnEnd - columnBegin) * (rowEnd - rowBegin);
+	for (uint32_t c = 0; c < 4; c++)
+		out[c] = static_cast<uint8_t>((sum[c] + count / 2) / count);
+}
+//-----------------------------------------------------------------------------
+// Destination pixels [begin, end) of a row, every one is an exact 2x2 block of row0/row1
+static void downsampleRowScalar(const uint8_t* row0, const uint8_t* row1, uint8_t* dst, uint32_t begin, uint32_t end)
+{
+	for (uint32_t x = begin; x < end; x++)
+	{
+		const uint8_t* a = row0 + 8 * x;
+		const uint8_t* b = row1 + 8 * x;
+		uint8_t* out = dst + 4 * x;
+		for (uint32_t c = 0; c < 4; c++)
+			out[c] = static_cast<uint8_t>((a[c] + a[c + 4] + b[c] + b[c + 4] + 2) >> 2);
+	}
+}
+//-----------------------------------------------------------------------------
+#if defined(SIMD_SSE2)
+// 8 source pixels of both rows -> 4 destination pixels
+static inline __m128i downsample4SSE2(const uint8_t* row0, const uint8_t* row1)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i two = _mm_set1_epi16(2);
+
+	const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0));
+	const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 16));
+	const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1));
+	const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 16));
+
+	// vertical sums in 16 bit: p0 p1 | p2 p3 | p4 p5 | p6 p7
+	const __m128i s01 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+	const __m128i s23 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+	const __m128i s45 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+	const __m128i s67 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+	// horizontal pairs: even pixels + odd pixels
+	const __m128i d01 = _mm_add_epi16(_mm_unpacklo_epi64(s01, s23), _mm_unpackhi_epi64(s01, s23));
+	const __m128i d23 = _mm_add_epi16(_mm_unpacklo_epi64(s45, s67), _mm_unpackhi_epi64(s45, s67));
+
+	return _mm_packus_epi16(_mm_srli_epi16(_mm_add_epi16(d01, two), 2), _mm_srli_epi16(_mm_add_epi16(d23, two), 2));
+}
+#endif
+//-----------------------------------------------------------------------------
+#if defined(SIMD_AVX2)
+// 16 source pixels of both rows -> 8 destination pixels
+static inline __m256i downsample8AVX2(const uint8_t* row0, const uint8_t* row1)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i two = _mm256_set1_epi16(2);
+
+	const __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0));
+	const __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0 + 32));
+	const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1));
+	const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1 + 32));
+
+	// unpack works inside 128 bit lanes: lo = p0 p1 | p4 p5, hi = p2 p3 | p6 p7
+	const __m256i sLo0 = _mm256_add_epi16(_mm256_unpacklo_epi8(a0, zero), _mm256_unpacklo_epi8(b0, zero));
+	const __m256i sHi0 = _mm256_add_epi16(_mm256_unpackhi_epi8(a0, zero), _mm256_unpackhi_epi8(b0, zero));
+	const __m256i sLo1 = _mm256_add_epi16(_mm256_unpacklo_epi8(a1, zero), _mm256_unpacklo_epi8(b1, zero));
+	const __m256i sHi1 = _mm256_add_epi16(_mm256_unpackhi_epi8(a1, zero), _mm256_unpackhi_epi8(b1, zero));
+
+	// d0 d1 | d2 d3 and d4 d5 | d6 d7
+	const __m256i d0 = _mm256_add_epi16(_mm256_unpacklo_epi64(sLo0, sHi0), _mm256_unpackhi_epi64(sLo0, sHi0));
+	const __m256i d1 = _mm256_add_epi16(_mm256_unpacklo_epi64(sLo1, sHi1), _mm256_unpackhi_epi64(sLo1, sHi1));
+
+	// pack is per lane too: d0 d1 d4 d5 | d2 d3 d6 d7 -> restore the order
+	const __m256i packed = _mm256_packus_epi16(_mm256_srli_epi16(_mm256_add_epi16(d0, two), 2), _mm256_srli_epi16(_mm256_add_epi16(d1, two), 2));
+	return _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+}
+#endif
+//-----------------------------------------------------------------------------
+#if defined(SIMD_NEON)
+// 8 source pixels of both rows -> 4 destination pixels
+static inline uint8x16_t downsample4NEON(const uint8_t* row0, const uint8_t* row1)
+{
+	const uint8x16_t a0 = vld1q_u8(row0);
+	const uint8x16_t a1 = vld1q_u8(row0 + 16);
+	const uint8x16_t b0 = vld1q_u8(row1);
+	const uint8x16_t b1 = vld1q_u8(row1 + 16);
+
+	// vertical sums: p0 p1 | p2 p3 | p4 p5 | p6 p7
+	const uint16x8_t s01 = vaddl_u8(vget_low_u8(a0), vget_low_u8(b0));
+	const uint16x8_t s23 = vaddl_u8(vget_high_u8(a0), vget_high_u8(b0));
+	const uint16x8_t s45 = vaddl_u8(vget_low_u8(a1), vget_low_u8(b1));
+	const uint16x8_t s67 = vaddl_u8(vget_high_u8(a1), vget_high_u8(b1));
+
+	const uint16x8_t d01 = vcombine_u16(vadd_u16(vget_low_u16(s01), vget_high_u16(s01)), vadd_u16(vget_low_u16(s23), vget_high_u16(s23)));
+	const uint16x8_t d23 = vcombine_u16(vadd_u16(vget_low_u16(s45), vget_high_u16(s45)), vadd_u16(vget_low_u16(s67), vget_high_u16(s67)));
+
+	// rounding shift: (sum + 2) >> 2
+	return vcombine_u8(vrshrn_n_u16(d01, 2), vrshrn_n_u16(d23, 2));
+}
+#endif
+//-----------------------------------------------------------------------------
+void DownsampleRGBA8(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst)
+{
+	const uint32_t dstWidth = GetMipLevelSize(srcWidth);
+	const uint32_t dstHeight = GetMipLevelSize(srcHeight);
+
+	// destination pixels made of exact 2x2 blocks, the rest is the odd border
+	const uint32_t blockWidth = srcWidth == 1 ? 0 : dstWidth - (srcWidth & 1);
+	const uint32_t blockHeight = (srcHeight > 1 && (srcHeight & 1)) ? dstHeight - 1 : dstHeight;
+
+	for (uint32_t y = 0; y < blockHeight; y++)
+	{
+		// a single row is averaged with itself, the rounding stays (a + b + 1) / 2
+		const uint8_t* row0 = src + 4 * size_t(srcHeight == 1 ? 0 : 2 * y) * srcWidth;
+		const uint8_t* row1 = srcHeight == 1 ? row0 : row0 + 4 * size_t(srcWidth);
+		uint8_t* dstRow = dst + 4 * size_t(y) * dstWidth;
+
+		uint32_t x = 0;
+#if defined(SIMD_AVX2)
+		for (; x + 8 <= blockWidth; x += 8)
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dstRow + 4 * x), downsample8AVX2(row0 + 8 * x, row1 + 8 * x));
+#endif
+#if defined(SIMD_SSE2)
+		for (; x + 4 <= blockWidth; x += 4)
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dstRow + 4 * x), downsample4SSE2(row0 + 8 * x, row1 + 8 * x));
+#elif defined(SIMD_NEON)
+		for (; x + 4 <= blockWidth; x += 4)
+			vst1q_u8(dstRow + 4 * x, downsample4NEON(row0 + 8 * x, row1 + 8 * x));
+#endif
+		downsampleRowScalar(row0, row1, dstRow, x, blockWidth);
+
+		for (x = blockWidth; x < dstWidth; x++)
+			filterPixel(src, srcWidth, srcHeight, x, y, dstRow + 4 * x);
+	}
+
+	for (uint32_t y = blockHeight; y < dstHeight; y++)
+	{
+		uint8_t* dstRow = dst + 4 * size_t(y) * dstWidth;
+		for (uint32_t x = 0; x < dstWidth; x++)
+			filterPixel(src, srcWidth, srcHeight, x, y, dstRow + 4 * x);
+	}
+}
+//-----------------------------------------------------------------------------
+void MipChain::Generate(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t levelCount)
+{
+	const uint32_t maxLevelCount = GetMipLevelCount(width, height);
+	if (levelCount == 0 || levelCount > maxLevelCount)
+		levelCount = maxLevelCount;
+
+	// layout of all levels, then a single allocation (reused by the next Generate)
+	size_t size = 0;
+	m_levels.resize(levelCount);
+	for (auto& level : m_levels)
+	{
+		level = { .offset = size, .width = width, .height = height };
+		size += 4 * size_t(width) * height;
+		width = GetMipLevelSize(width);
+		height = GetMipLevelSize(height);
+	}
+	m_data.resize(size);
+
+	memcpy(m_data.data(), pixels, GetLevelSize(0));
+	for (uint32_t i = 1; i < levelCount; i++)
+	{
+		const MipLevel& src = m_levels[i - 1];
+		DownsampleRGBA8(m_data.data() + src.offset, src.width, src.height, m_data.data() + m_levels[i].offset);
+	}
+}
+//-----------------------------------------------------------------------------
+void MipChain::Clear()
+{
+	m_data.clear();
+	m_data.shrink_to_fit();
+	m_levels.clear();
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Number of levels of a full mip chain (down to 1x1)
+uint32_t GetMipLevelCount(uint32_t width, uint32_t height);
+
+// Size of the next mip level: max(1, size / 2)
+inline uint32_t GetMipLevelSize(uint32_t size) { return size > 1 ? size / 2 : 1; }
+
+// 2x2 box filter of an RGBA8 image into dst (GetMipLevelSize(srcWidth) x GetMipLevelSize(srcHeight)).
+// For an odd dimension the last destination column/row averages the 3 remaining source columns/rows.
+void DownsampleRGBA8(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst);
+
+struct MipLevel
+{
+	size_t offset = 0; // in bytes from the start of the chain
+	uint32_t width = 0;
+	uint32_t height = 0;
+};
+
+// RGBA8 mip chain stored in one allocation, level 0 first.
+class MipChain
+{
+public:
+	// Copies pixels as level 0 and builds the rest. levelCount = 0 - full chain
+	void Generate(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t levelCount = 0);
+	void Clear();
+
+	uint32_t GetLevelCount() const { return static_cast<uint32_t>(m_levels.size()); }
+	const MipLevel& GetLevel(uint32_t level) const { return m_levels[level]; }
+	const uint8_t* GetLevelData(uint32_t level) const { return m_data.data() + m_levels[level].offset; }
+	size_t GetLevelSize(uint32_t level) const { return 4 * size_t(m_levels[level].width) * m_levels[level].height; }
+	size_t GetSize() const { return m_data.size(); }
+
+private:
+	std::vector<uint8_t> m_data;
+	std::vector<MipLevel> m_levels;
+};
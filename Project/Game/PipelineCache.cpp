@@ -0,0 +1,328 @@
+#include "Engine.h"
+
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+
+//-----------------------------------------------------------------------------
+PipelineBlobCache::PipelineBlobCache()
+{
+	m_platform.cache = this;
+}
+//-----------------------------------------------------------------------------
+bool PipelineBlobCache::Open(const std::filesystem::path& directory)
+{
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	if (error || !std::filesystem::is_directory(directory))
+	{
+		Warning("Could not create pipeline cache directory: " + directory.string());
+		return false;
+	}
+	m_directory = directory;
+	return true;
+}
+//-----------------------------------------------------------------------------
+size_t PipelineBlobCache::LoadData(const void* key, size_t keySize, void* valueOut, size_t valueSize)
+{
+	if (m_directory.empty()) return 0;
+
+	// Entry file: uint64 key size, key, value
+	std::lock_guard<std::mutex> lock(m_mutex);
+	std::ifstream file(getEntryPath(key, keySize), std::ios::binary | std::ios::ate);
+	if (!file) return 0;
+
+	const uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+	uint64_t storedKeySize = 0;
+	file.seekg(0);
+	if (fileSize < sizeof(storedKeySize) || !file.read(reinterpret_cast<char*>(&storedKeySize), sizeof(storedKeySize))
+		|| storedKeySize != keySize || fileSize < sizeof(storedKeySize) + keySize)
+		return 0;
+
+	std::vector<char> storedKey(keySize);
+	if (!file.read(storedKey.data(), static_cast<std::streamsize>(keySize)) || memcmp(storedKey.data(), key, keySize) != 0)
+		return 0; // another key with the same hash
+
+	const size_t storedValueSize = static_cast<size_t>(fileSize - sizeof(storedKeySize) - keySize);
+	if (valueOut == nullptr)
+		return storedValueSize; // the query mode
+	if (valueSize < storedValueSize || !file.read(static_cast<char*>(valueOut), static_cast<std::streamsize>(storedValueSize)))
+		return 0;
+	return storedValueSize;
+}
+//-----------------------------------------------------------------------------
+void PipelineBlobCache::StoreData(const void* key, size_t keySize, const void* value, size_t valueSize)
+{
+	if (m_directory.empty()) return;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const std::filesystem::path path = getEntryPath(key, keySize);
+	std::filesystem::path temporaryPath = path;
+	temporaryPath += ".tmp";
+	{
+		// written next to the entry and renamed, so a crash never leaves a truncated entry
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		const uint64_t storedKeySize = keySize;
+		file.write(reinterpret_cast<const char*>(&storedKeySize), sizeof(storedKeySize));
+		file.write(static_cast<const char*>(key), static_cast<std::streamsize>(keySize));
+		file.write(static_cast<const char*>(value), static_cast<std::streamsize>(valueSize));
+		if (!file.good())
+		{
+			file.close();
+			std::error_code error;
+			std::filesystem::remove(temporaryPath, error);
+			return;
+		}
+	}
+	std::error_code error;
+	std::filesystem::rename(temporaryPath, path, error);
+}
+//-----------------------------------------------------------------------------
+std::filesystem::path PipelineBlobCache::getEntryPath(const void* key, size_t keySize) const
+{
+	DescriptorHasher hasher;
+	hasher.AddBytes(key, keySize);
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(hasher.hash));
+	return m_directory / name;
+}
+//-----------------------------------------------------------------------------
+void PipelineCache::Create(const wgpu::Device& device)
+{
+	m_device = device;
+}
+//-----------------------------------------------------------------------------
+void PipelineCache::Destroy()
+{
+	// the callbacks of pending pipelines only free their requests
+	for (AsyncRequest* request : m_asyncRequests)
+		request->cache = nullptr;
+	m_asyncRequests.clear();
+
+	m_pipelines.clear();
+	m_shaderModules.clear();
+	m_device = nullptr;
+}
+//-----------------------------------------------------------------------------
+wgpu::ShaderModule PipelineCache::GetShaderModule(const char* source)
+{
+	auto it = m_shaderModules.find(source);
+	if (it != m_shaderModules.end())
+	{
+		m_hitCount++;
+		return it->second;
+	}
+
+	m_missCount++;
+	wgpu::ShaderModuleWGSLDescriptor shaderCodeDesc{};
+	shaderCodeDesc.code = source;
+	wgpu::ShaderModuleDescriptor shaderModuleDesc{};
+	shaderModuleDesc.nextInChain = &shaderCodeDesc;
+	wgpu::ShaderModule shaderModule = m_device.CreateShaderModule(&shaderModuleDesc);
+	m_shaderModules.emplace(source, shaderModule);
+	return shaderModule;
+}
+//-----------------------------------------------------------------------------
+wgpu::RenderPipeline PipelineCache::GetRenderPipeline(const wgpu::RenderPipelineDescriptor& descriptor)
+{
+	uint64_t key;
+	PipelineEntry* entry = findEntry(descriptor, key);
+	if (!entry)
+	{
+		m_missCount++;
+		return m_device.CreateRenderPipeline(&descriptor);
+	}
+	if (entry->pipeline)
+	{
+		m_hitCount++;
+		return entry->pipeline;
+	}
+
+	// also when the async creation is still pending - the pipeline is needed now
+	m_missCount++;
+	entry->pipeline = m_device.CreateRenderPipeline(&descriptor);
+	return entry->pipeline;
+}
+//-----------------------------------------------------------------------------
+uint64_t PipelineCache::RequestRenderPipelineAsync(const wgpu::RenderPipelineDescriptor& descriptor)
+{
+	uint64_t key;
+	PipelineEntry* entry = findEntry(descriptor, key);
+	if (!entry)
+	{
+		// not shared, under a key of its own (as unlikely to collide as the descriptor hashes)
+		DescriptorHasher hasher;
+		hasher.Add(key);
+		hasher.Add(++m_uncachedCount);
+		key = hasher.hash;
+		entry = &m_pipelines[key];
+	}
+	else if (entry->pipeline || entry->pending)
+	{
+		m_hitCount++;
+		return key;
+	}
+
+	m_missCount++;
+	entry->pending = true;
+	AsyncRequest* request = new AsyncRequest{ this, key };
+	m_asyncRequests.push_back(request);
+	m_device.CreateRenderPipelineAsync(&descriptor, createRenderPipelineAsyncCallback, request);
+	return key;
+}
+//-----------------------------------------------------------------------------
+wgpu::RenderPipeline PipelineCache::FindRenderPipeline(uint64_t key) const
+{
+	auto it = m_pipelines.find(key);
+	return it != m_pipelines.end() ? it->second.pipeline : nullptr;
+}
+//-----------------------------------------------------------------------------
+PipelineCache::PipelineEntry* PipelineCache::findEntry(const wgpu::RenderPipelineDescriptor& descriptor, uint64_t& hash)
+{
+	std::string key;
+	DescriptorHasher hasher;
+	hasher.key = &key;
+	hashDescriptor(descriptor, hasher);
+	hash = hasher.hash;
+	if (hasher.chained)
+	{
+		Error("Render pipeline cache: the descriptor has chained structs, the pipeline is not cached");
+		return nullptr;
+	}
+
+	PipelineEntry& entry = m_pipelines[hash];
+	if (entry.pipeline || entry.pending)
+	{
+		if (entry.key == key)
+			return &entry;
+		Error("Render pipeline cache: hash collision of two different descriptors");
+		assert(!"render pipeline descriptor hash collision");
+		return nullptr;
+	}
+
+	entry.key = std::move(key);
+	entry.layout = descriptor.layout;
+	entry.vertexModule = descriptor.vertex.module;
+	entry.fragmentModule = descriptor.fragment ? descriptor.fragment->module : nullptr;
+	return &entry;
+}
+//-----------------------------------------------------------------------------
+void PipelineCache::createRenderPipelineAsyncCallback(WGPUCreatePipelineAsyncStatus status, WGPURenderPipeline pipeline, const char* message, void* userdata)
+{
+	AsyncRequest* request = static_cast<AsyncRequest*>(userdata);
+	wgpu::RenderPipeline renderPipeline = wgpu::RenderPipeline::Acquire(pipeline);
+	PipelineCache* cache = request->cache;
+	if (cache)
+	{
+		std::erase(cache->m_asyncRequests, request);
+		auto it = cache->m_pipelines.find(request->key);
+		if (it != cache->m_pipelines.end())
+		{
+			it->second.pending = false;
+			if (status == WGPUCreatePipelineAsyncStatus_Success)
+			{
+				if (!it->second.pipeline) // GetRenderPipeline may have created it in the meantime
+					it->second.pipeline = renderPipeline;
+			}
+			else
+				Error("Could not create render pipeline: " + std::string(message ? message : ""));
+		}
+	}
+	delete request;
+}
+//-----------------------------------------------------------------------------
+uint64_t PipelineCache::HashDescriptor(const wgpu::RenderPipelineDescriptor& descriptor)
+{
+	DescriptorHasher hasher;
+	hashDescriptor(descriptor, hasher);
+	return hasher.hash;
+}
+//-----------------------------------------------------------------------------
+void PipelineCache::hashDescriptor(const wgpu::RenderPipelineDescriptor& descriptor, DescriptorHasher& hasher)
+{
+	// the C++ structures have the layout of the C ones
+	const WGPURenderPipelineDescriptor& desc = reinterpret_cast<const WGPURenderPipelineDescriptor&>(descriptor);
+	hasher.AddChain(desc.nextInChain);
+	hasher.Add(reinterpret_cast<uintptr_t>(desc.layout)); // nullptr - the auto layout, derived from the shaders
+
+	hasher.AddChain(desc.vertex.nextInChain);
+	hasher.Add(reinterpret_cast<uintptr_t>(desc.vertex.module));
+	hasher.AddString(desc.vertex.entryPoint);
+	hasher.AddConstants(desc.vertex.constantCount, desc.vertex.constants);
+	hasher.Add(desc.vertex.bufferCount);
+	for (size_t i = 0; i < desc.vertex.bufferCount; i++)
+	{
+		const WGPUVertexBufferLayout& buffer = desc.vertex.buffers[i];
+		hasher.Add(buffer.arrayStride);
+		hasher.Add(buffer.stepMode);
+		hasher.Add(buffer.attributeCount);
+		for (size_t j = 0; j < buffer.attributeCount; j++)
+		{
+			hasher.Add(buffer.attributes[j].format);
+			hasher.Add(buffer.attributes[j].offset);
+			hasher.Add(buffer.attributes[j].shaderLocation);
+		}
+	}
+
+	hasher.AddChain(desc.primitive.nextInChain);
+	hasher.Add(desc.primitive.topology);
+	hasher.Add(desc.primitive.stripIndexFormat);
+	hasher.Add(desc.primitive.frontFace);
+	hasher.Add(desc.primitive.cullMode);
+
+	hasher.Add(desc.depthStencil != nullptr);
+	if (desc.depthStencil)
+	{
+		const WGPUDepthStencilState& depthStencil = *desc.depthStencil;
+		hasher.AddChain(depthStencil.nextInChain);
+		hasher.Add(depthStencil.format);
+		hasher.Add(depthStencil.depthWriteEnabled);
+		hasher.Add(depthStencil.depthCompare);
+		for (const WGPUStencilFaceState& face : { depthStencil.stencilFront, depthStencil.stencilBack })
+		{
+			hasher.Add(face.compare);
+			hasher.Add(face.failOp);
+			hasher.Add(face.depthFailOp);
+			hasher.Add(face.passOp);
+		}
+		hasher.Add(depthStencil.stencilReadMask);
+		hasher.Add(depthStencil.stencilWriteMask);
+		hasher.Add(depthStencil.depthBias);
+		hasher.Add(depthStencil.depthBiasSlopeScale);
+		hasher.Add(depthStencil.depthBiasClamp);
+	}
+
+	hasher.AddChain(desc.multisample.nextInChain);
+	hasher.Add(desc.multisample.count);
+	hasher.Add(desc.multisample.mask);
+	hasher.Add(desc.multisample.alphaToCoverageEnabled);
+
+	hasher.Add(desc.fragment != nullptr);
+	if (desc.fragment)
+	{
+		const WGPUFragmentState& fragment = *desc.fragment;
+		hasher.AddChain(fragment.nextInChain);
+		hasher.Add(reinterpret_cast<uintptr_t>(fragment.module));
+		hasher.AddString(fragment.entryPoint);
+		hasher.AddConstants(fragment.constantCount, fragment.constants);
+		hasher.Add(fragment.targetCount);
+		for (size_t i = 0; i < fragment.targetCount; i++)
+		{
+			const WGPUColorTargetState& target = fragment.targets[i];
+			hasher.AddChain(target.nextInChain);
+			hasher.Add(target.format);
+			hasher.Add(target.writeMask);
+			hasher.Add(target.blend != nullptr);
+			if (target.blend)
+			{
+				for (const WGPUBlendComponent& component : { target.blend->color, target.blend->alpha })
+				{
+					hasher.Add(component.operation);
+					hasher.Add(component.srcFactor);
+					hasher.Add(component.dstFactor);
+				}
+			}
+		}
+	}
+}
+//-----------------------------------------------------------------------------
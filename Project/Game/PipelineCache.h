@@ -0,0 +1,117 @@
+#pragma once
+
+#include "RenderResources.h"
+#include "Hash.h"
+#include <Dawn/platform/DawnPlatform.h>
+
+#include <mutex>
+#include <string>
+
+// The WebGPU descriptor parts of the hash (Hash.h), the descriptors are hashed field by field.
+// The chained structs are not hashed, chained tells that the descriptor has some and can't be identified by the hash.
+struct DescriptorHasher : Fnv1aHasher
+{
+	void AddChain(const WGPUChainedStruct* next)
+	{
+		chained |= next != nullptr;
+	}
+	void AddConstants(size_t count, const WGPUConstantEntry* constants)
+	{
+		Add(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			AddString(constants[i].key);
+			Add(constants[i].value);
+		}
+	}
+
+	bool chained = false;
+};
+
+// Persistent storage of the Dawn blob cache (the backend shaders and pipelines compiled from WGSL), one file per entry.
+// Set GetPlatform() in dawn::native::DawnInstanceDescriptor::platform. The cache must outlive the devices of the instance.
+class PipelineBlobCache final : public dawn::platform::CachingInterface
+{
+public:
+	PipelineBlobCache();
+
+	// Creates the directory when it is missing
+	bool Open(const std::filesystem::path& directory);
+
+	size_t LoadData(const void* key, size_t keySize, void* valueOut, size_t valueSize) final;
+	void StoreData(const void* key, size_t keySize, const void* value, size_t valueSize) final;
+
+	dawn::platform::Platform* GetPlatform() { return &m_platform; }
+
+private:
+	class Platform final : public dawn::platform::Platform
+	{
+	public:
+		dawn::platform::CachingInterface* GetCachingInterface() final { return cache; }
+		dawn::platform::CachingInterface* cache = nullptr;
+	};
+
+	std::filesystem::path getEntryPath(const void* key, size_t keySize) const;
+
+	Platform m_platform;
+	std::filesystem::path m_directory;
+	std::mutex m_mutex; // Dawn calls the cache from its worker threads
+};
+
+// Shader modules and render pipelines shared by all users of the cache.
+// A shader module is identified by its WGSL source, a pipeline by the hash of its complete descriptor.
+// The shader modules and the pipeline layout are hashed by handle - take the modules from GetShaderModule,
+// so that the same source gives the same handle. An entry holds its modules and layout, so their handles can't be reused
+// by other objects while it is in the cache. A descriptor with chained structs (nextInChain) is not cached, and
+// a collision of the hashes is an Error (an assert in debug builds): GetRenderPipeline then creates a pipeline
+// that isn't cached, RequestRenderPipelineAsync gives the pipeline an entry of its own.
+class PipelineCache
+{
+public:
+	void Create(const wgpu::Device& device);
+	void Destroy();
+
+	wgpu::ShaderModule GetShaderModule(const char* source);
+	wgpu::ShaderModule GetShaderModule(const std::string& source) { return GetShaderModule(source.c_str()); }
+
+	wgpu::RenderPipeline GetRenderPipeline(const wgpu::RenderPipelineDescriptor& descriptor);
+	// Starts CreateRenderPipelineAsync (or finds the pipeline), returns the key for FindRenderPipeline
+	uint64_t RequestRenderPipelineAsync(const wgpu::RenderPipelineDescriptor& descriptor);
+	// nullptr while the pipeline is compiling or when the creation has failed
+	wgpu::RenderPipeline FindRenderPipeline(uint64_t key) const;
+
+	static uint64_t HashDescriptor(const wgpu::RenderPipelineDescriptor& descriptor);
+
+	uint32_t GetHitCount() const { return m_hitCount; }
+	uint32_t GetMissCount() const { return m_missCount; }
+
+private:
+	struct PipelineEntry
+	{
+		wgpu::RenderPipeline pipeline = nullptr;
+		bool pending = false;
+		std::string key; // the hashed bytes of the descriptor
+		// the hashed handles, kept so that their addresses aren't reused while the entry exists
+		wgpu::PipelineLayout layout = nullptr;
+		wgpu::ShaderModule vertexModule = nullptr;
+		wgpu::ShaderModule fragmentModule = nullptr;
+	};
+	struct AsyncRequest
+	{
+		PipelineCache* cache; // nullptr when the cache was destroyed before the callback
+		uint64_t key;
+	};
+
+	// Finds or adds the entry of the descriptor, nullptr when it has chained structs or on a hash collision with another descriptor
+	PipelineEntry* findEntry(const wgpu::RenderPipelineDescriptor& descriptor, uint64_t& hash);
+	static void hashDescriptor(const wgpu::RenderPipelineDescriptor& descriptor, DescriptorHasher& hasher);
+	static void createRenderPipelineAsyncCallback(WGPUCreatePipelineAsyncStatus status, WGPURenderPipeline pipeline, const char* message, void* userdata);
+
+	wgpu::Device m_device = nullptr;
+	std::unordered_map<std::string, wgpu::ShaderModule> m_shaderModules;
+	std::unordered_map<uint64_t, PipelineEntry> m_pipelines;
+	std::vector<AsyncRequest*> m_asyncRequests;
+	uint32_t m_hitCount = 0;
+	uint32_t m_missCount = 0;
+	uint64_t m_uncachedCount = 0; // of the async pipelines with an entry of their own
+};
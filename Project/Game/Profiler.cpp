@@ -0,0 +1,369 @@
+#include "Engine.h"
+
+#include <chrono>
+#include <fstream>
+#include <imgui/imgui.h>
+
+//-----------------------------------------------------------------------------
+namespace
+{
+	// Open scopes of the thread
+	struct ProfileThreadState
+	{
+		struct OpenScope
+		{
+			const char* name;
+			double start;
+		};
+		std::vector<OpenScope> stack;
+		uint32_t thread = UINT32_MAX;
+	};
+	thread_local ProfileThreadState ProfileThread;
+
+	uint64_t getStatKey(const char* name, uint32_t depth, uint32_t thread)
+	{
+		// the names are string literals - the pointer identifies the scope
+		uint64_t key = reinterpret_cast<uintptr_t>(name);
+		key ^= (uint64_t(depth) << 48) ^ (uint64_t(thread) << 32) * 0x9E3779B97F4A7C15ull;
+		return key;
+	}
+}
+//-----------------------------------------------------------------------------
+Profiler& GetProfiler()
+{
+	static Profiler profiler;
+	return profiler;
+}
+//-----------------------------------------------------------------------------
+double Profiler::GetTime() const
+{
+	using namespace std::chrono;
+	static const steady_clock::time_point startTime = steady_clock::now();
+	return duration<double>(steady_clock::now() - startTime).count();
+}
+//-----------------------------------------------------------------------------
+void Profiler::BeginScope(const char* name)
+{
+	ProfileThread.stack.push_back({ name, GetTime() });
+}
+//-----------------------------------------------------------------------------
+void Profiler::EndScope()
+{
+	if (ProfileThread.stack.empty()) return;
+
+	const double end = GetTime();
+	const ProfileThreadState::OpenScope scope = ProfileThread.stack.back();
+	ProfileThread.stack.pop_back();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (ProfileThread.thread == UINT32_MAX)
+		ProfileThread.thread = m_nextThread++;
+	m_events.push_back({ scope.name, scope.start, end, static_cast<uint32_t>(ProfileThread.stack.size()), ProfileThread.thread });
+}
+//-----------------------------------------------------------------------------
+void Profiler::AddGpuEvent(const char* name, double submitTime, double start, double end)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_events.push_back({ name, submitTime + start, submitTime + end, 0, GpuThread });
+}
+//-----------------------------------------------------------------------------
+void Profiler::BeginFrame()
+{
+	m_frameStart = GetTime();
+	BeginScope("Frame");
+}
+//-----------------------------------------------------------------------------
+void Profiler::EndFrame()
+{
+	EndScope();
+	const float frameTime = static_cast<float>((GetTime() - m_frameStart) * 1000.0);
+	m_frameTime = m_frameTime > 0.0f ? glm::mix(m_frameTime, frameTime, 0.05f) : frameTime;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		std::swap(m_events, m_frameEvents);
+		m_events.clear();
+		if (m_capturing)
+		{
+			constexpr size_t MaxCaptureEvents = 1u << 20;
+			if (m_capture.size() + m_frameEvents.size() <= MaxCaptureEvents)
+				m_capture.insert(m_capture.end(), m_frameEvents.begin(), m_frameEvents.end());
+		}
+	}
+	updateStats(m_frameEvents);
+}
+//-----------------------------------------------------------------------------
+void Profiler::updateStats(const std::vector<ProfileEvent>& events)
+{
+	// the rows in the tree order: by thread, then by start (a parent starts before its children)
+	std::vector<ProfileEvent> sorted = events;
+	std::stable_sort(sorted.begin(), sorted.end(), [](const ProfileEvent& a, const ProfileEvent& b)
+		{
+			if (a.thread != b.thread) return a.thread < b.thread;
+			if (a.start != b.start) return a.start < b.start;
+			return a.depth < b.depth;
+		});
+
+	m_stats.clear();
+	for (const ProfileEvent& event : sorted)
+	{
+		const float time = static_cast<float>((event.end - event.start) * 1000.0);
+		ProfileStat& stat = m_statHistory[getStatKey(event.name, event.depth, event.thread)];
+		if (!stat.name)
+		{
+			stat.name = event.name;
+			stat.depth = event.depth;
+			stat.thread = event.thread;
+			stat.time = time;
+		}
+		else
+			stat.time = glm::mix(stat.time, time, 0.05f);
+		stat.maxTime = std::max(stat.maxTime, time);
+		m_stats.push_back(stat);
+	}
+}
+//-----------------------------------------------------------------------------
+void Profiler::StartCapture()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_capture.clear();
+	m_capturing = true;
+}
+//-----------------------------------------------------------------------------
+bool Profiler::SaveCapture(const std::filesystem::path& path)
+{
+	std::vector<ProfileEvent> capture;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		capture.swap(m_capture);
+		m_capturing = false;
+	}
+
+	std::ofstream file(path, std::ios::trunc);
+	if (!file)
+	{
+		Error("Could not write profiler capture: " + path.string());
+		return false;
+	}
+
+	// Trace Event Format, complete events ("X") in microseconds
+	file << "{\"traceEvents\":[\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << GpuThread << ",\"args\":{\"name\":\"GPU\"}}";
+	for (const ProfileEvent& event : capture)
+	{
+		file << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread
+			<< ",\"ts\":" << static_cast<uint64_t>(event.start * 1e6)
+			<< ",\"dur\":" << static_cast<uint64_t>((event.end - event.start) * 1e6) << "}";
+	}
+	file << "\n]}\n";
+	Print("Profiler capture: " + std::to_string(capture.size()) + " events -> " + path.string());
+	return file.good();
+}
+//-----------------------------------------------------------------------------
+void DrawProfilerOverlay(bool* open)
+{
+	Profiler& profiler = GetProfiler();
+	ImGui::SetNextWindowSize(ImVec2(360.0f, 300.0f), ImGuiCond_FirstUseEver);
+	if (!ImGui::Begin("Profiler", open))
+	{
+		ImGui::End();
+		return;
+	}
+
+	ImGui::Text("Frame: %.2f ms (%.0f fps)", profiler.GetFrameTime(), profiler.GetFrameTime() > 0.0f ? 1000.0f / profiler.GetFrameTime() : 0.0f);
+	if (!profiler.IsCapturing())
+	{
+		if (ImGui::Button("Start trace capture"))
+			profiler.StartCapture();
+	}
+	else if (ImGui::Button("Save trace (profile.json)"))
+		profiler.SaveCapture("profile.json");
+
+	if (ImGui::BeginTable("scopes", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_ScrollY))
+	{
+		ImGui::TableSetupColumn("Scope", ImGuiTableColumnFlags_WidthStretch);
+		ImGui::TableSetupColumn("ms", ImGuiTableColumnFlags_WidthFixed, 60.0f);
+		ImGui::TableSetupColumn("max", ImGuiTableColumnFlags_WidthFixed, 60.0f);
+		ImGui::TableHeadersRow();
+
+		uint32_t thread = UINT32_MAX;
+		for (const ProfileStat& stat : profiler.GetStats())
+		{
+			if (stat.thread != thread)
+			{
+				thread = stat.thread;
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				if (thread == Profiler::GpuThread)
+					ImGui::TextDisabled("GPU");
+				else
+					ImGui::TextDisabled("Thread %u", thread);
+			}
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::Indent(12.0f * static_cast<float>(stat.depth + 1));
+			ImGui::TextUnformatted(stat.name);
+			ImGui::Unindent(12.0f * static_cast<float>(stat.depth + 1));
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3f", stat.time);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3f", stat.maxTime);
+		}
+		ImGui::EndTable();
+	}
+	ImGui::End();
+}
+//-----------------------------------------------------------------------------
+bool GpuProfiler::Create(const wgpu::Device& device, uint32_t maxPasses, uint32_t frameCount)
+{
+	Destroy();
+	if (!device.HasFeature(wgpu::FeatureName::TimestampQuery))
+	{
+		Print("GPU profiler: the device has no TimestampQuery feature, the passes are not measured");
+		return false;
+	}
+
+	m_maxPasses = std::max(maxPasses, 1u);
+	frameCount = std::max(frameCount, 1u);
+	const uint32_t queriesPerFrame = m_maxPasses * 2;
+	const uint64_t frameSize = uint64_t(queriesPerFrame) * sizeof(uint64_t);
+
+	wgpu::QuerySetDescriptor querySetDesc{};
+	querySetDesc.type = wgpu::QueryType::Timestamp;
+	querySetDesc.count = queriesPerFrame * frameCount;
+	m_querySet = device.CreateQuerySet(&querySetDesc);
+
+	// the offsets of ResolveQuerySet must be 256-byte aligned
+	wgpu::BufferDescriptor resolveDesc{};
+	resolveDesc.usage = wgpu::BufferUsage::QueryResolve | wgpu::BufferUsage::CopySrc;
+	resolveDesc.size = (frameSize + 255) & ~uint64_t(255);
+	m_resolveBuffer = device.CreateBuffer(&resolveDesc);
+
+	for (uint32_t i = 0; i < frameCount; i++)
+	{
+		wgpu::BufferDescriptor readbackDesc{};
+		readbackDesc.usage = wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst;
+		readbackDesc.size = frameSize;
+		Slot* slot = new Slot;
+		slot->profiler = this;
+		slot->index = i;
+		slot->readback = device.CreateBuffer(&readbackDesc);
+		slot->passNames.reserve(m_maxPasses);
+		m_slots.push_back(slot);
+	}
+	m_timestampWrites.resize(m_maxPasses);
+	m_frame = 0;
+	return m_querySet && m_resolveBuffer;
+}
+//-----------------------------------------------------------------------------
+void GpuProfiler::Destroy()
+{
+	for (Slot* slot : m_slots)
+	{
+		if (slot->state == SlotState::Mapping)
+		{
+			// the map callback is still called (with an error status) - it frees the slot
+			slot->profiler = nullptr;
+			slot->readback.Destroy();
+		}
+		else
+			delete slot;
+	}
+	m_slots.clear();
+	m_timestampWrites.clear();
+	m_resolveBuffer = nullptr;
+	m_querySet = nullptr;
+	m_current = nullptr;
+}
+//-----------------------------------------------------------------------------
+void GpuProfiler::BeginFrame()
+{
+	m_current = nullptr;
+	if (!IsEnabled()) return;
+
+	// the frame is not measured while the results of its slot are not read yet
+	Slot& slot = *m_slots[m_frame % m_slots.size()];
+	m_frame++;
+	if (slot.state != SlotState::Free) return;
+
+	slot.state = SlotState::Recording;
+	slot.passNames.clear();
+	m_current = &slot;
+}
+//-----------------------------------------------------------------------------
+const wgpu::RenderPassTimestampWrites* GpuProfiler::AddPass(const char* name)
+{
+	if (!m_current || m_current->passNames.size() >= m_maxPasses)
+		return nullptr;
+
+	const uint32_t pass = static_cast<uint32_t>(m_current->passNames.size());
+	const uint32_t firstQuery = m_current->index * m_maxPasses * 2 + pass * 2;
+	m_current->passNames.push_back(name);
+
+	wgpu::RenderPassTimestampWrites& writes = m_timestampWrites[pass];
+	writes.querySet = m_querySet;
+	writes.beginningOfPassWriteIndex = firstQuery;
+	writes.endOfPassWriteIndex = firstQuery + 1;
+	return &writes;
+}
+//-----------------------------------------------------------------------------
+void GpuProfiler::Resolve(wgpu::CommandEncoder& encoder)
+{
+	if (!m_current || m_current->passNames.empty()) return;
+
+	const uint32_t queryCount = static_cast<uint32_t>(m_current->passNames.size()) * 2;
+	encoder.ResolveQuerySet(m_querySet, m_current->index * m_maxPasses * 2, queryCount, m_resolveBuffer, 0);
+	encoder.CopyBufferToBuffer(m_resolveBuffer, 0, m_current->readback, 0, uint64_t(queryCount) * sizeof(uint64_t));
+}
+//-----------------------------------------------------------------------------
+void GpuProfiler::EndFrame()
+{
+	if (!m_current) return;
+
+	Slot& slot = *m_current;
+	m_current = nullptr;
+	if (slot.passNames.empty())
+	{
+		slot.state = SlotState::Free;
+		return;
+	}
+
+	slot.state = SlotState::Mapping;
+	slot.submitTime = GetProfiler().GetTime();
+	slot.readback.MapAsync(wgpu::MapMode::Read, 0, slot.passNames.size() * 2 * sizeof(uint64_t), mapCallback, &slot);
+}
+//-----------------------------------------------------------------------------
+void GpuProfiler::mapCallback(WGPUBufferMapAsyncStatus status, void* userdata)
+{
+	Slot& slot = *static_cast<Slot*>(userdata);
+	if (!slot.profiler)
+	{
+		delete &slot;
+		return;
+	}
+
+	if (status == WGPUBufferMapAsyncStatus_Success)
+		slot.profiler->readSlot(slot);
+	else
+		slot.state = SlotState::Free;
+}
+//-----------------------------------------------------------------------------
+void GpuProfiler::readSlot(Slot& slot)
+{
+	// timestamps in nanoseconds, the first pass of the frame is placed at the submit time
+	const uint64_t* timestamps = static_cast<const uint64_t*>(slot.readback.GetConstMappedRange(0, slot.passNames.size() * 2 * sizeof(uint64_t)));
+	if (timestamps)
+	{
+		const uint64_t frameStart = timestamps[0];
+		for (size_t i = 0; i < slot.passNames.size(); i++)
+		{
+			const uint64_t begin = timestamps[i * 2];
+			const uint64_t end = timestamps[i * 2 + 1];
+			if (end < begin || begin < frameStart) continue; // the counter was reset (e.g. a power state change)
+			GetProfiler().AddGpuEvent(slot.passNames[i], slot.submitTime, double(begin - frameStart) * 1e-9, double(end - frameStart) * 1e-9);
+		}
+	}
+	slot.readback.Unmap();
+	slot.state = SlotState::Free;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "RenderResources.h"
+
+#include <mutex>
+
+// Scope of one frame. CPU times are seconds since the profiler start, GPU scopes are placed at the submit time of their frame.
+struct ProfileEvent
+{
+	const char* name = nullptr; // string literal
+	double start = 0.0;
+	double end = 0.0;
+	uint32_t depth = 0;
+	uint32_t thread = 0;        // GpuThread - the GPU timeline
+};
+
+// Smoothed time of a scope over the last frames (the rows of the overlay)
+struct ProfileStat
+{
+	const char* name = nullptr;
+	uint32_t depth = 0;
+	uint32_t thread = 0;
+	float time = 0.0f;    // ms
+	float maxTime = 0.0f; // ms, over the stat lifetime
+};
+
+// Hierarchical frame profiler. The CPU scopes (PROFILE_SCOPE) may be opened on any thread,
+// the GPU passes are measured by GpuProfiler. Engine calls BeginFrame/EndFrame around every frame.
+class Profiler
+{
+public:
+	static constexpr uint32_t GpuThread = 0xFFFFFFFF;
+
+	void BeginScope(const char* name);
+	void EndScope();
+	// GPU pass times (GpuProfiler), start and end in seconds relative to the submit
+	void AddGpuEvent(const char* name, double submitTime, double start, double end);
+
+	void BeginFrame();
+	void EndFrame();
+
+	// Chrome trace (chrome://tracing, ui.perfetto.dev) of the frames between StartCapture and SaveCapture
+	void StartCapture();
+	bool SaveCapture(const std::filesystem::path& path);
+	bool IsCapturing() const { return m_capturing; }
+
+	// Rows of the last frame in scope order with the smoothed times
+	const std::vector<ProfileStat>& GetStats() const { return m_stats; }
+	float GetFrameTime() const { return m_frameTime; } // ms, smoothed
+
+	double GetTime() const;
+
+private:
+	void updateStats(const std::vector<ProfileEvent>& events);
+
+	std::mutex m_mutex;
+	std::vector<ProfileEvent> m_events;      // the current frame
+	std::vector<ProfileEvent> m_frameEvents; // the last complete frame
+	std::vector<ProfileEvent> m_capture;
+	bool m_capturing = false;
+
+	std::vector<ProfileStat> m_stats;
+	std::unordered_map<uint64_t, ProfileStat> m_statHistory; // name, depth and thread -> smoothed times
+	double m_frameStart = 0.0;
+	float m_frameTime = 0.0f;
+	uint32_t m_nextThread = 0;
+};
+
+Profiler& GetProfiler();
+
+// Draws the profiler window, between ImGui::NewFrame and ImGui::Render
+void DrawProfilerOverlay(bool* open = nullptr);
+
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char* name) { GetProfiler().BeginScope(name); }
+	~ProfileScope() { GetProfiler().EndScope(); }
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+
+// Timestamp queries at the beginning and the end of render passes, resolved into a ring of readback buffers.
+// Disabled when the device has no TimestampQuery feature - AddPass returns nullptr and the passes are not measured.
+class GpuProfiler
+{
+public:
+	bool Create(const wgpu::Device& device, uint32_t maxPasses = 16, uint32_t frameCount = 3);
+	void Destroy();
+
+	void BeginFrame();
+	// For RenderPass::timestampWrites, nullptr when the frame is not measured
+	const wgpu::RenderPassTimestampWrites* AddPass(const char* name);
+	// Before encoder.Finish
+	void Resolve(wgpu::CommandEncoder& encoder);
+	// After queue.Submit - starts the readback of the frame
+	void EndFrame();
+
+	bool IsEnabled() const { return m_querySet != nullptr; }
+
+private:
+	enum class SlotState : uint8_t { Free, Recording, Mapping };
+	struct Slot
+	{
+		GpuProfiler* profiler = nullptr; // nullptr - the profiler was destroyed
+		uint32_t index = 0;
+		SlotState state = SlotState::Free;
+		wgpu::Buffer readback = nullptr;
+		std::vector<const char*> passNames;
+		double submitTime = 0.0;
+	};
+
+	static void mapCallback(WGPUBufferMapAsyncStatus status, void* userdata);
+	void readSlot(Slot& slot);
+
+	wgpu::QuerySet m_querySet = nullptr;
+	wgpu::Buffer m_resolveBuffer = nullptr;
+	std::vector<Slot*> m_slots; // a slot destroyed while mapping is freed by its callback
+	std::vector<wgpu::RenderPassTimestampWrites> m_timestampWrites;
+	uint32_t m_maxPasses = 0;
+	uint32_t m_frame = 0;
+	Slot* m_current = nullptr;
+};
@@ -1,6 +1,61 @@
 ﻿#pragma once
 
 #include "RenderResources.h"
+#include "TextureStreamer.h"
+#include "ComputeMipGenerator.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "InstanceBatcher.h"
+#include "PipelineCache.h"
+#include "BindGroupCache.h"
+#include "FramePacer.h"
+#include "Profiler.h"
+#include "ImageCapture.h"
+#include "FrameAllocator.h"
+
+// Draw data of one frame built by the simulation thread (IApp::Frame) and consumed by Render::Frame.
+// In the multithreaded mode the packets are recycled, vectors keep their capacity between frames.
+struct FrameDrawItem
+{
+	glm::mat4 transform = glm::mat4(1.0f);
+	uint32_t mesh = 0;
+	uint32_t material = 0;
+};
+
+struct FramePacket
+{
+	void Reset() { drawItems.clear(); arena.Reset(); }
+
+	uint64_t frameIndex = 0;
+	double time = 0.0;              // engine time of the frame
+	float frameTime = 0.0f;
+	float interpolationAlpha = 0.0f;
+	int frameBufferWidth = 0;       // the render resizes the swap chain when it differs
+	int frameBufferHeight = 0;
+
+	glm::mat4 view = glm::mat4(1.0f);
+	glm::mat4 projection = glm::mat4(1.0f);
+	std::vector<FrameDrawItem> drawItems;
+	// Transient data of the packet (IApp::GetFrameArena), released when the packet is reused
+	LinearArena arena;
+};
+
+// Adapter of the headless mode
+enum class HeadlessAdapter : uint8_t
+{
+	Default, // the usual choice: discrete, then integrated GPU
+	Cpu,     // software rasterizer (SwiftShader) - the same image on machines without a GPU
+	Null     // Dawn Null backend - nothing is drawn, measures the CPU side of the render only
+};
+
+// Rendering without a window and a swap chain, the frames go into an offscreen texture
+struct HeadlessInfo
+{
+	bool enabled = false;
+	uint32_t width = 1024;
+	uint32_t height = 768;
+	HeadlessAdapter adapter = HeadlessAdapter::Cpu;
+};
 
 struct RenderData;
 
@@ -10,10 +65,30 @@ public:
 	bool Create(void* glfwWindow, unsigned frameBufferWidth, unsigned frameBufferHeight);
 	void Destroy();
 
-	void Frame();
+	void Frame(const FramePacket& packet);
 
 	bool Resize(int width, int height);
 
+	unsigned GetFrameWidth() const { return m_frameWidth; }
+	unsigned GetFrameHeight() const { return m_frameHeight; }
+
+	// Worker threads for background work of the render (set by Engine before Create)
+	void SetJobSystem(JobSystem& jobSystem) { m_jobSystem = &jobSystem; }
+	// Present mode of the swap chain and the frame pacing (set by Engine before Create)
+	void SetPresentInfo(wgpu::PresentMode presentMode, const FramePacingInfo& pacingInfo) { m_presentMode = presentMode; m_pacingInfo = pacingInfo; }
+	// Waits for a free frame in flight and the pacing delay. Called before the input of the frame is read,
+	// otherwise Frame waits itself (the render thread).
+	void WaitForNextFrame() { m_framePacer.BeginFrame(); }
+	// Headless mode, glfwWindow of Create is ignored (set by Engine before Create)
+	void SetHeadless(const HeadlessInfo& info) { m_headless = info; }
+	bool IsHeadless() const { return m_headless.enabled; }
+	// Reads back the last rendered frame of the headless mode (waits for the GPU)
+	bool ReadFrame(CapturedImage& image);
+	// Work of the last rendered frame (read it between the frames, the render thread writes it)
+	const RenderStats& GetStats() const { return m_stats; }
+	const FramePacer& GetFramePacer() const { return m_framePacer; }
+	TextureStreamer& GetTextureStreamer() { return m_textureStreamer; }
+
 private:
 	bool createDevice(void* glfwWindow);
 	bool initSwapChain(int width, int height);
@@ -22,6 +97,14 @@ private:
 	void terminateDepthBuffer();
 
 	RenderData* m_data = nullptr;
+	JobSystem* m_jobSystem = nullptr;
+	TextureStreamer m_textureStreamer;
+	wgpu::PresentMode m_presentMode = wgpu::PresentMode::Fifo;
+	FramePacingInfo m_pacingInfo;
+	FramePacer m_framePacer;
+	HeadlessInfo m_headless;
+	RenderStats m_stats;
+	LinearArena m_frameArena; // transient data of Frame on the render thread, reset at the start of every Frame
 	unsigned m_frameWidth = 0;
 	unsigned m_frameHeight = 0;
 };
\ No newline at end of file
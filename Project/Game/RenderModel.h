@@ -1,6 +1,8 @@
 #pragma once
 
+#include "Hash.h"
 #include <tiny_obj_loader.h>
+#include <unordered_map>
 
 struct VertexAttributes 
 {
@@ -62,7 +64,80 @@ void populateTextureFrameAttributes(std::vector<VertexAttributes>& vertexData)
 	}
 }
 
-bool loadGeometryFromObj(const std::filesystem::path& path,  std::vector<VertexAttributes>& vertexData) 
+// Attributes that identify a vertex when welding (tangent frames are derived from them and averaged)
+struct VertexWeldKey
+{
+	bool operator==(const VertexWeldKey&) const = default;
+
+	glm::vec3 position;
+	glm::vec3 normal;
+	glm::vec3 color;
+	glm::vec2 uv;
+};
+
+struct VertexWeldKeyHash
+{
+	size_t operator()(const VertexWeldKey& key) const
+	{
+		const float values[] = { 
+			key.position.x, key.position.y, key.position.z,
+			key.normal.x, key.normal.y, key.normal.z,
+			key.color.x, key.color.y, key.color.z,
+			key.uv.x, key.uv.y };
+		Fnv1aHasher hasher;
+		for (float value : values)
+			hasher.Add(value);
+		return static_cast<size_t>(hasher.hash);
+	}
+};
+
+// Merges the corners with equal position, normal, uv and color into one vertex and builds the index list.
+// The tangent frames of the merged corners are averaged and re-orthonormalized against the normal.
+void weldVertices(const std::vector<VertexAttributes>& corners, std::vector<VertexAttributes>& vertexData, std::vector<uint32_t>& indexData)
+{
+	std::unordered_map<VertexWeldKey, uint32_t, VertexWeldKeyHash> vertexIndices;
+	vertexIndices.reserve(corners.size());
+	std::vector<glm::vec3> tangentSum;
+	std::vector<glm::vec3> bitangentSum;
+
+	vertexData.clear();
+	indexData.resize(corners.size());
+	for (size_t i = 0; i < corners.size(); ++i)
+	{
+		const VertexAttributes& corner = corners[i];
+		// + 0.0f turns -0.0f into 0.0f, they are equal but have different bits
+		const VertexWeldKey key{ corner.position + 0.0f, corner.normal + 0.0f, corner.color + 0.0f, corner.uv + 0.0f };
+
+		auto [it, inserted] = vertexIndices.try_emplace(key, static_cast<uint32_t>(vertexData.size()));
+		if (inserted)
+		{
+			vertexData.push_back(corner);
+			tangentSum.push_back(corner.tangent);
+			bitangentSum.push_back(corner.bitangent);
+		}
+		else
+		{
+			tangentSum[it->second] += corner.tangent;
+			bitangentSum[it->second] += corner.bitangent;
+		}
+		indexData[i] = it->second;
+	}
+
+	for (size_t i = 0; i < vertexData.size(); ++i)
+	{
+		VertexAttributes& vertex = vertexData[i];
+		const glm::vec3 T = tangentSum[i] - glm::dot(tangentSum[i], vertex.normal) * vertex.normal;
+		// opposite frames (mirrored uv) cancel out - the first corner keeps its own frame
+		if (glm::dot(T, T) < 1e-12f) continue;
+
+		vertex.tangent = glm::normalize(T);
+		const glm::vec3 B = glm::cross(vertex.normal, vertex.tangent);
+		vertex.bitangent = glm::dot(B, bitangentSum[i]) < 0.0f ? -B : B;
+	}
+}
+
+// bounds (optional) - the bounds of the loaded positions, computed here at load time
+bool loadGeometryFromObj(const std::filesystem::path& path,  std::vector<VertexAttributes>& vertexData, MeshBounds* bounds = nullptr) 
 {
 	tinyobj::attrib_t attrib;
 	std::vector<tinyobj::shape_t> shapes;
@@ -135,5 +210,188 @@ bool loadGeometryFromObj(const std::filesystem::path& path,  std::vector<VertexA
 
 	populateTextureFrameAttributes(vertexData);
 
+	if (bounds)
+		*bounds = ComputeMeshBounds(vertexData.data(), vertexData.size(), sizeof(VertexAttributes));
 	return true;
-}
\ No newline at end of file
+}
+
+// Indexed variant of loadGeometryFromObj (see weldVertices), optimized for the vertex cache (see OptimizeMesh)
+bool loadGeometryFromObj(const std::filesystem::path& path, std::vector<VertexAttributes>& vertexData, std::vector<uint32_t>& indexData, MeshBounds* bounds = nullptr)
+{
+	std::vector<VertexAttributes> corners;
+	if (!loadGeometryFromObj(path, corners, bounds))
+		return false;
+
+	weldVertices(corners, vertexData, indexData);
+
+	MeshOptimizationStats stats;
+	const size_t vertexCount = OptimizeMesh(vertexData.data(), vertexData.size(), sizeof(VertexAttributes), indexData.data(), indexData.size(), &stats);
+	vertexData.resize(vertexCount);
+
+	Print(path.filename().string() + ": " + std::to_string(corners.size()) + " corners welded to " + std::to_string(vertexCount) + " vertices, "
+		+ stats.before.ToString() + " -> " + stats.after.ToString());
+	return true;
+}
+
+// Packed vertex: 28 bytes instead of 68 (QuantizedVertexAttributes - 24 bytes).
+// The normal and tangent are octahedral-encoded, the bitangent is rebuilt in the shader from cross(N, T) * sign.
+struct PackedVertexAttributes
+{
+	glm::vec3 position; // float32x3
+	uint32_t normal;    // snorm16x2, octahedral
+	uint32_t tangent;   // uint32: snorm16x2 octahedral, bit 0 - bitangent sign (1 = +)
+	uint32_t uv;        // float16x2
+	uint32_t color;     // unorm8x4, alpha = 1
+};
+static_assert(sizeof(PackedVertexAttributes) == 28);
+
+// Same as PackedVertexAttributes with the position quantized to unorm16 relative to the mesh bounds
+struct QuantizedVertexAttributes
+{
+	uint16_t position[4]; // unorm16x4, (p - boundsMin) / (boundsMax - boundsMin), w unused
+	uint32_t normal;
+	uint32_t tangent;
+	uint32_t uv;
+	uint32_t color;
+};
+static_assert(sizeof(QuantizedVertexAttributes) == 24);
+
+// [-1..1]^2 coordinates of a unit vector on the octahedron unfolded onto a square
+glm::vec2 octahedralEncode(glm::vec3 v)
+{
+	v /= glm::abs(v.x) + glm::abs(v.y) + glm::abs(v.z);
+	glm::vec2 e(v.x, v.y);
+	if (v.z < 0.0f)
+	{
+		const glm::vec2 signNotZero(e.x >= 0.0f ? 1.0f : -1.0f, e.y >= 0.0f ? 1.0f : -1.0f);
+		e = (1.0f - glm::abs(glm::vec2(e.y, e.x))) * signNotZero;
+	}
+	return e;
+}
+
+void packVertexFrame(const VertexAttributes& vertex, uint32_t& normal, uint32_t& tangent, uint32_t& uv, uint32_t& color)
+{
+	normal = glm::packSnorm2x16(octahedralEncode(vertex.normal));
+	const bool positiveBitangent = glm::dot(glm::cross(vertex.normal, vertex.tangent), vertex.bitangent) >= 0.0f;
+	tangent = (glm::packSnorm2x16(octahedralEncode(vertex.tangent)) & ~1u) | (positiveBitangent ? 1u : 0u);
+	uv = glm::packHalf2x16(vertex.uv);
+	color = glm::packUnorm4x8(glm::vec4(vertex.color, 1.0f));
+}
+
+PackedVertexAttributes packVertex(const VertexAttributes& vertex)
+{
+	PackedVertexAttributes packed;
+	packed.position = vertex.position;
+	packVertexFrame(vertex, packed.normal, packed.tangent, packed.uv, packed.color);
+	return packed;
+}
+
+QuantizedVertexAttributes quantizeVertex(const VertexAttributes& vertex, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	const glm::vec3 extent = glm::max(boundsMax - boundsMin, glm::vec3(1e-20f));
+	const glm::vec3 normalized = glm::clamp((vertex.position - boundsMin) / extent, 0.0f, 1.0f);
+
+	QuantizedVertexAttributes quantized;
+	for (int i = 0; i < 3; ++i)
+		quantized.position[i] = static_cast<uint16_t>(glm::round(normalized[i] * 65535.0f));
+	quantized.position[3] = 0;
+	packVertexFrame(vertex, quantized.normal, quantized.tangent, quantized.uv, quantized.color);
+	return quantized;
+}
+
+// Shader locations as in the samples: 0 - position, 1 - normal, 2 - color, 3 - uv, 4 - tangent (bitangent is decoded)
+VertexBufferLayout getPackedVertexLayout()
+{
+	VertexBufferLayout layout;
+	layout.SetVertexSize(sizeof(PackedVertexAttributes));
+	layout.AddAttrib(0, wgpu::VertexFormat::Float32x3, offsetof(PackedVertexAttributes, position));
+	layout.AddAttrib(1, wgpu::VertexFormat::Snorm16x2, offsetof(PackedVertexAttributes, normal));
+	layout.AddAttrib(2, wgpu::VertexFormat::Unorm8x4, offsetof(PackedVertexAttributes, color));
+	layout.AddAttrib(3, wgpu::VertexFormat::Float16x2, offsetof(PackedVertexAttributes, uv));
+	layout.AddAttrib(4, wgpu::VertexFormat::Uint32, offsetof(PackedVertexAttributes, tangent));
+	return layout;
+}
+
+VertexBufferLayout getQuantizedVertexLayout()
+{
+	VertexBufferLayout layout;
+	layout.SetVertexSize(sizeof(QuantizedVertexAttributes));
+	layout.AddAttrib(0, wgpu::VertexFormat::Unorm16x4, offsetof(QuantizedVertexAttributes, position));
+	layout.AddAttrib(1, wgpu::VertexFormat::Snorm16x2, offsetof(QuantizedVertexAttributes, normal));
+	layout.AddAttrib(2, wgpu::VertexFormat::Unorm8x4, offsetof(QuantizedVertexAttributes, color));
+	layout.AddAttrib(3, wgpu::VertexFormat::Float16x2, offsetof(QuantizedVertexAttributes, uv));
+	layout.AddAttrib(4, wgpu::VertexFormat::Uint32, offsetof(QuantizedVertexAttributes, tangent));
+	return layout;
+}
+
+// Vertices stored by loadGeometryFromObjCached
+enum class CachedVertexFormat : uint8_t
+{
+	Full,     // VertexAttributes
+	Quantized // QuantizedVertexAttributes, dequantized with the bounds of the cache (MeshCache::GetBounds)
+};
+
+// Same as loadGeometryFromObj, but through the binary cache next to the file ("model.obj.mesh", "model.obj.qmesh" - quantized).
+// The OBJ is parsed only when the cache is missing or the OBJ content has changed. The bounds are stored in the cache (MeshCache::GetBounds).
+bool loadGeometryFromObjCached(const std::filesystem::path& path, MeshCache& meshCache, CachedVertexFormat format = CachedVertexFormat::Full)
+{
+	const bool quantized = format == CachedVertexFormat::Quantized;
+	std::filesystem::path cachePath = MeshCache::GetCachePath(path);
+	if (quantized)
+		cachePath.replace_extension(".qmesh");
+	const uint32_t vertexStride = quantized ? sizeof(QuantizedVertexAttributes) : sizeof(VertexAttributes);
+	if (meshCache.Open(cachePath, path, vertexStride))
+		return true;
+
+	std::vector<VertexAttributes> vertexData;
+	std::vector<uint32_t> indexData;
+	MeshBounds bounds;
+	if (!loadGeometryFromObj(path, vertexData, indexData, &bounds))
+		return false;
+
+	if (!quantized)
+	{
+		return meshCache.Build(cachePath, path, vertexStride,
+			vertexData.data(), static_cast<uint32_t>(vertexData.size()),
+			indexData.data(), static_cast<uint32_t>(indexData.size()));
+	}
+
+	std::vector<QuantizedVertexAttributes> quantizedData(vertexData.size());
+	for (size_t i = 0; i < vertexData.size(); i++)
+		quantizedData[i] = quantizeVertex(vertexData[i], bounds.box.min, bounds.box.max);
+	return meshCache.Build(cachePath, path, vertexStride,
+		quantizedData.data(), static_cast<uint32_t>(quantizedData.size()),
+		indexData.data(), static_cast<uint32_t>(indexData.size()), &bounds);
+}
+
+// WGSL decode of the packed attributes, to be pasted in front of a vertex shader.
+// The quantized position is decoded with dequantizePosition(in.position, boundsMin, boundsMax) (bounds from the mesh cache).
+const char* PackedVertexShaderCode = R"(
+struct PackedVertexInput {
+	@location(0) position: vec4f, // float32x3 or unorm16x4 (quantized)
+	@location(1) normal: vec2f,
+	@location(2) color: vec4f,
+	@location(3) uv: vec2f,
+	@location(4) tangent: u32,
+};
+
+fn octahedralDecode(e: vec2f) -> vec3f {
+	var v = vec3f(e, 1.0 - abs(e.x) - abs(e.y));
+	let t = max(-v.z, 0.0);
+	v.x += select(t, -t, v.x >= 0.0);
+	v.y += select(t, -t, v.y >= 0.0);
+	return normalize(v);
+}
+
+fn dequantizePosition(position: vec4f, boundsMin: vec3f, boundsMax: vec3f) -> vec3f {
+	return boundsMin + position.xyz * (boundsMax - boundsMin);
+}
+
+// returns the T, B, N frame as the columns
+fn decodeTangentFrame(in: PackedVertexInput) -> mat3x3f {
+	let N = octahedralDecode(in.normal);
+	let T = octahedralDecode(unpack2x16snorm(in.tangent));
+	let bitangentSign = select(-1.0, 1.0, (in.tangent & 1u) != 0u);
+	return mat3x3f(T, cross(N, T) * bitangentSign, N);
+}
+)";
\ No newline at end of file
@@ -1,4 +1,40 @@
 #include "Engine.h"
+
+#include <atomic>
+
+//-----------------------------------------------------------------------------
+namespace
+{
+	std::atomic<uint32_t> drawCallCounter = 0;
+	std::atomic<uint32_t> bufferUploadCounter = 0;
+	std::atomic<uint32_t> textureUploadCounter = 0;
+	std::atomic<uint64_t> uploadByteCounter = 0;
+}
+//-----------------------------------------------------------------------------
+RenderStats TakeRenderStats()
+{
+	RenderStats stats;
+	stats.drawCalls = drawCallCounter.exchange(0, std::memory_order_relaxed);
+	stats.bufferUploads = bufferUploadCounter.exchange(0, std::memory_order_relaxed);
+	stats.textureUploads = textureUploadCounter.exchange(0, std::memory_order_relaxed);
+	stats.uploadBytes = uploadByteCounter.exchange(0, std::memory_order_relaxed);
+	return stats;
+}
+//-----------------------------------------------------------------------------
+void WriteBuffer(const wgpu::Queue& queue, const wgpu::Buffer& buffer, uint64_t offset, const void* data, size_t size)
+{
+	queue.WriteBuffer(buffer, offset, data, size);
+	bufferUploadCounter.fetch_add(1, std::memory_order_relaxed);
+	uploadByteCounter.fetch_add(size, std::memory_order_relaxed);
+}
+//-----------------------------------------------------------------------------
+void WriteTexture(const wgpu::Queue& queue, const wgpu::ImageCopyTexture& destination, const void* data, size_t dataSize,
+	const wgpu::TextureDataLayout& dataLayout, const wgpu::Extent3D& writeSize)
+{
+	queue.WriteTexture(&destination, data, dataSize, &dataLayout, &writeSize);
+	textureUploadCounter.fetch_add(1, std::memory_order_relaxed);
+	uploadByteCounter.fetch_add(dataSize, std::memory_order_relaxed);
+}
 //-----------------------------------------------------------------------------
 Buffer::Buffer()
 {
@@ -21,7 +57,7 @@ bool Buffer::create(const wgpu::Device& device, wgpu::BufferUsage usage, uint64_
 	};
 	buffer = device.CreateBuffer(&descriptor);
 
-	if (data) device.GetQueue().WriteBuffer(buffer, 0, data, bufferSize);
+	if (data) WriteBuffer(device.GetQueue(), buffer, 0, data, bufferSize);
 	return true;
 }
 //-----------------------------------------------------------------------------
@@ -56,11 +92,224 @@ bool UniformBuffer::Create(const wgpu::Device& device, uint64_t size, const void
 	return create(device, wgpu::BufferUsage::Uniform, size, data);
 }
 //-----------------------------------------------------------------------------
+bool StorageBuffer::Create(const wgpu::Device& device, uint64_t size, const void* data, wgpu::BufferUsage extraUsage)
+{
+	return create(device, wgpu::BufferUsage::Storage | extraUsage, size, data);
+}
+//-----------------------------------------------------------------------------
+void RenderBundleCache::Create(const wgpu::Device& device, wgpu::TextureFormat colorFormat, wgpu::TextureFormat depthStencilFormat, uint32_t sampleCount)
+{
+	m_device = device;
+	SetFormats(colorFormat, depthStencilFormat, sampleCount);
+}
+//-----------------------------------------------------------------------------
+void RenderBundleCache::Destroy()
+{
+	m_frameBundles.clear();
+	m_chunks.clear();
+	m_device = nullptr;
+}
+//-----------------------------------------------------------------------------
+void RenderBundleCache::BeginFrame()
+{
+	m_frameBundles.clear();
+}
+//-----------------------------------------------------------------------------
+const RenderBundle& RenderBundleCache::Use(uint64_t chunkId, uint64_t contentHash, const RecordFunction& record)
+{
+	auto [it, inserted] = m_chunks.try_emplace(chunkId);
+	Chunk& chunk = it->second;
+	if (inserted || !chunk.bundle.bundle || chunk.contentHash != contentHash)
+	{
+		wgpu::RenderBundleEncoderDescriptor encoderDesc{};
+		encoderDesc.colorFormatCount = 1;
+		encoderDesc.colorFormats = &m_colorFormat;
+		encoderDesc.depthStencilFormat = m_depthStencilFormat;
+		encoderDesc.sampleCount = m_sampleCount;
+
+		wgpu::RenderBundleEncoder encoder = m_device.CreateRenderBundleEncoder(&encoderDesc);
+		chunk.bundle.drawCount = record(encoder);
+		chunk.bundle.bundle = encoder.Finish();
+		chunk.contentHash = contentHash;
+		m_recordCount++;
+	}
+
+	m_frameBundles.push_back(chunk.bundle);
+	return chunk.bundle;
+}
+//-----------------------------------------------------------------------------
+void RenderBundleCache::Invalidate(uint64_t chunkId)
+{
+	m_chunks.erase(chunkId);
+}
+//-----------------------------------------------------------------------------
+void RenderBundleCache::InvalidateAll()
+{
+	m_chunks.clear();
+}
+//-----------------------------------------------------------------------------
+void RenderBundleCache::SetFormats(wgpu::TextureFormat colorFormat, wgpu::TextureFormat depthStencilFormat, uint32_t sampleCount)
+{
+	if (colorFormat != m_colorFormat || depthStencilFormat != m_depthStencilFormat || sampleCount != m_sampleCount)
+		InvalidateAll();
+
+	m_colorFormat = colorFormat;
+	m_depthStencilFormat = depthStencilFormat;
+	m_sampleCount = sampleCount;
+}
+//-----------------------------------------------------------------------------
+bool UniformRingBuffer::Create(const wgpu::Device& device, uint64_t frameSize, uint32_t frameCount)
+{
+	m_device = device;
+
+	wgpu::SupportedLimits limits{};
+	if (m_device.GetLimits(&limits))
+		m_alignment = std::max(limits.limits.minUniformBufferOffsetAlignment, 4u);
+
+	m_frameSize = (frameSize + m_alignment - 1) / m_alignment * m_alignment;
+	m_frameCount = std::max(frameCount, 1u);
+	m_frameIndex = m_frameCount - 1; // the first BeginFrame starts at region 0
+	m_used = 0;
+	m_staging.resize(m_frameSize);
+
+	const wgpu::BufferDescriptor descriptor{
+		.usage = wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst,
+		.size = m_frameSize * m_frameCount
+	};
+	m_buffer = m_device.CreateBuffer(&descriptor);
+	if (!m_buffer)
+	{
+		Error("Could not create uniform ring buffer!");
+		return false;
+	}
+	return true;
+}
+//-----------------------------------------------------------------------------
+void UniformRingBuffer::Destroy()
+{
+	if (m_buffer) m_buffer.Destroy();
+	m_buffer = nullptr;
+	m_device = nullptr;
+	m_staging.clear();
+	m_staging.shrink_to_fit();
+}
+//-----------------------------------------------------------------------------
+void UniformRingBuffer::BeginFrame()
+{
+	m_frameIndex = (m_frameIndex + 1) % m_frameCount;
+	m_used = 0;
+}
+//-----------------------------------------------------------------------------
+UniformAllocation UniformRingBuffer::Allocate(uint32_t size)
+{
+	const uint64_t alignedSize = (uint64_t(size) + m_alignment - 1) / m_alignment * m_alignment;
+	if (m_used + alignedSize > m_frameSize)
+	{
+		Error("Uniform ring buffer: frame size " + std::to_string(m_frameSize) + " exceeded");
+		return {};
+	}
+
+	UniformAllocation allocation;
+	allocation.data = m_staging.data() + m_used;
+	allocation.offset = static_cast<uint32_t>(GetFrameOffset(m_frameIndex) + m_used);
+	allocation.size = size;
+	m_used += alignedSize;
+	return allocation;
+}
+//-----------------------------------------------------------------------------
+void UniformRingBuffer::Flush()
+{
+	if (m_used == 0) return;
+	WriteBuffer(m_device.GetQueue(), m_buffer, GetFrameOffset(m_frameIndex), m_staging.data(), m_used);
+}
+//-----------------------------------------------------------------------------
+void BindGroupLayout::AddVertexUniform(uint64_t minBindingSize, bool hasDynamicOffset)
+{
+	AddUniform(wgpu::ShaderStage::Vertex, minBindingSize, hasDynamicOffset);
+}
+//-----------------------------------------------------------------------------
+void BindGroupLayout::AddUniform(wgpu::ShaderStage visibility, uint64_t minBindingSize, bool hasDynamicOffset)
+{
+	wgpu::BindGroupLayoutEntry& entry = addEntry(visibility);
+	entry.buffer.type = wgpu::BufferBindingType::Uniform;
+	entry.buffer.hasDynamicOffset = hasDynamicOffset;
+	entry.buffer.minBindingSize = minBindingSize;
+}
+//-----------------------------------------------------------------------------
+void BindGroupLayout::AddStorage(wgpu::ShaderStage visibility, bool readOnly, uint64_t minBindingSize, bool hasDynamicOffset)
+{
+	wgpu::BindGroupLayoutEntry& entry = addEntry(visibility);
+	entry.buffer.type = readOnly ? wgpu::BufferBindingType::ReadOnlyStorage : wgpu::BufferBindingType::Storage;
+	entry.buffer.hasDynamicOffset = hasDynamicOffset;
+	entry.buffer.minBindingSize = minBindingSize;
+}
+//-----------------------------------------------------------------------------
+void BindGroupLayout::AddTexture(wgpu::ShaderStage visibility, wgpu::TextureSampleType sampleType, wgpu::TextureViewDimension viewDimension)
+{
+	wgpu::BindGroupLayoutEntry& entry = addEntry(visibility);
+	entry.texture.sampleType = sampleType;
+	entry.texture.viewDimension = viewDimension;
+	entry.texture.multisampled = false;
+}
+//-----------------------------------------------------------------------------
+void BindGroupLayout::AddSampler(wgpu::ShaderStage visibility, wgpu::SamplerBindingType type)
+{
+	wgpu::BindGroupLayoutEntry& entry = addEntry(visibility);
+	entry.sampler.type = type;
+}
+//-----------------------------------------------------------------------------
+bool BindGroupLayout::Create(const wgpu::Device& device)
+{
+	m_device = device;
+	wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc{};
+	bindGroupLayoutDesc.entryCount = m_entries.size();
+	bindGroupLayoutDesc.entries = m_entries.data();
+	layout = device.CreateBindGroupLayout(&bindGroupLayoutDesc);
+	return layout != nullptr;
+}
+//-----------------------------------------------------------------------------
+bool BindGroupLayout::Create(BindGroupCache& cache)
+{
+	m_device = cache.GetDevice();
+	wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc{};
+	bindGroupLayoutDesc.entryCount = m_entries.size();
+	bindGroupLayoutDesc.entries = m_entries.data();
+	layout = cache.GetBindGroupLayout(bindGroupLayoutDesc);
+	return layout != nullptr;
+}
+//-----------------------------------------------------------------------------
+wgpu::PipelineLayout BindGroupLayout::CreatePipelineLayout() const
+{
+	if (!m_device || !layout)
+	{
+		Error("BindGroupLayout::CreatePipelineLayout: the layout is not created");
+		return nullptr;
+	}
+
+	wgpu::PipelineLayoutDescriptor pipelineLayoutDesc{};
+	pipelineLayoutDesc.bindGroupLayoutCount = 1;
+	pipelineLayoutDesc.bindGroupLayouts = &layout;
+	return m_device.CreatePipelineLayout(&pipelineLayoutDesc);
+}
+//-----------------------------------------------------------------------------
+wgpu::BindGroupLayoutEntry& BindGroupLayout::addEntry(wgpu::ShaderStage visibility)
+{
+	wgpu::BindGroupLayoutEntry& entry = m_entries.emplace_back();
+	entry.binding = static_cast<uint32_t>(m_entries.size() - 1);
+	entry.visibility = visibility;
+	return entry;
+}
+//-----------------------------------------------------------------------------
 void VertexBufferLayout::SetVertexSize(uint64_t size)
 {
 	m_size = size;
 }
 //-----------------------------------------------------------------------------
+void VertexBufferLayout::SetStepMode(wgpu::VertexStepMode stepMode)
+{
+	m_stepMode = stepMode;
+}
+//-----------------------------------------------------------------------------
 void VertexBufferLayout::AddAttrib(wgpu::VertexFormat format, uint64_t offset)
 {
 	AddAttrib(m_attribs.size(), format, offset);
@@ -81,7 +330,7 @@ wgpu::VertexBufferLayout VertexBufferLayout::Get() const
 	vertexBufferLayout.attributeCount = static_cast<uint32_t>(m_attribs.size());
 	vertexBufferLayout.attributes = m_attribs.data();
 	vertexBufferLayout.arrayStride = m_size;
-	vertexBufferLayout.stepMode = wgpu::VertexStepMode::Vertex;
+	vertexBufferLayout.stepMode = m_stepMode;
 	return vertexBufferLayout;
 }
 //-----------------------------------------------------------------------------
@@ -119,25 +368,28 @@ void RenderPipeline::SetDepthStencilState(wgpu::DepthStencilState depthStencilSt
 //-----------------------------------------------------------------------------
 void RenderPipeline::SetVertexBufferLayout(VertexBufferLayout vertexBufferLayout)
 {
-	SetVertexBufferLayout(std::vector<VertexBufferLayout>{ vertexBufferLayout });
+	SetVertexBufferLayout(&vertexBufferLayout, 1);
 }
 //-----------------------------------------------------------------------------
 void RenderPipeline::SetVertexBufferLayout(const std::vector<VertexBufferLayout>& vertexBufferLayout)
 {
-	if (vertexBufferLayout.empty() || vertexBufferLayout[0].IsZero())
+	SetVertexBufferLayout(vertexBufferLayout.data(), vertexBufferLayout.size());
+}
+//-----------------------------------------------------------------------------
+void RenderPipeline::SetVertexBufferLayout(const VertexBufferLayout* vertexBufferLayout, size_t count)
+{
+	if (count == 0 || vertexBufferLayout[0].IsZero())
 	{
 		m_pipelineDescriptor.vertex.bufferCount = 0;
 		m_pipelineDescriptor.vertex.buffers = nullptr;
 	}
 	else
 	{
-		m_vbLayout.resize(vertexBufferLayout.size());
-		m_privateLayout.resize(vertexBufferLayout.size());
-		for (size_t i = 0; i < vertexBufferLayout.size(); i++)
-		{
-			m_vbLayout[i] = vertexBufferLayout[i];
+		// the vectors keep their capacity, a pipeline set up again doesn't allocate
+		m_vbLayout.assign(vertexBufferLayout, vertexBufferLayout + count);
+		m_privateLayout.resize(count);
+		for (size_t i = 0; i < count; i++)
 			m_privateLayout[i] = m_vbLayout[i].Get();
-		}
 		m_pipelineDescriptor.vertex.bufferCount = m_privateLayout.size();
 		m_pipelineDescriptor.vertex.buffers = m_privateLayout.data();
 	}
@@ -161,6 +413,42 @@ void RenderPipeline::SetPipelineLayout(const PipelineLayout& layout)
 }
 //-----------------------------------------------------------------------------
 bool RenderPipeline::Create(wgpu::Device device)
+{
+	prepareDescriptor();
+	pipeline = device.CreateRenderPipeline(&m_pipelineDescriptor);
+
+	return true;
+}
+//-----------------------------------------------------------------------------
+bool RenderPipeline::Create(PipelineCache& cache)
+{
+	prepareDescriptor();
+	pipeline = cache.GetRenderPipeline(m_pipelineDescriptor);
+	m_asyncCache = nullptr;
+
+	return pipeline != nullptr;
+}
+//-----------------------------------------------------------------------------
+void RenderPipeline::CreateAsync(PipelineCache& cache)
+{
+	prepareDescriptor();
+	pipeline = nullptr;
+	m_asyncKey = cache.RequestRenderPipelineAsync(m_pipelineDescriptor);
+	m_asyncCache = &cache;
+	IsReady();
+}
+//-----------------------------------------------------------------------------
+bool RenderPipeline::IsReady()
+{
+	if (!pipeline && m_asyncCache)
+	{
+		pipeline = m_asyncCache->FindRenderPipeline(m_asyncKey);
+		if (pipeline) m_asyncCache = nullptr;
+	}
+	return pipeline != nullptr;
+}
+//-----------------------------------------------------------------------------
+void RenderPipeline::prepareDescriptor()
 {
 	// TODO:      
 	m_fragmentState.targetCount = 1;
@@ -175,10 +463,6 @@ bool RenderPipeline::Create(wgpu::Device device)
 
 	if (m_depthStencilState.format != wgpu::TextureFormat::Undefined)
 		m_pipelineDescriptor.depthStencil = &m_depthStencilState;
-
-	pipeline = device.CreateRenderPipeline(&m_pipelineDescriptor);
-
-	return true;
 }
 //-----------------------------------------------------------------------------
 RenderPass::RenderPass()
@@ -211,7 +495,7 @@ void RenderPass::SetTextureView(wgpu::TextureView backBufferView, wgpu::TextureV
 void RenderPass::Start(wgpu::CommandEncoder& encoder)
 {
 	wgpu::RenderPassDescriptor renderPassDescriptor{};
-	renderPassDescriptor.timestampWrites = nullptr;
+	renderPassDescriptor.timestampWrites = timestampWrites;
 
 	renderPassDescriptor.colorAttachmentCount = 1;
 	renderPassDescriptor.colorAttachments = &renderPassColorAttachment;
@@ -276,34 +560,59 @@ void RenderPass::End()
 //-----------------------------------------------------------------------------
 void RenderPass::ExecuteBundles(size_t bundleCount, const RenderBundle* bundles) const
 {
+	if (bundleCount == 0) return;
+	uint32_t drawCount = 0;
+	for (size_t i = 0; i < bundleCount; i++)
+		drawCount += bundles[i].drawCount;
+	drawCallCounter.fetch_add(drawCount, std::memory_order_relaxed);
 	if (bundleCount == 1)
 	{
 		renderPass.ExecuteBundles(1, &bundles->bundle);
+		return;
 	}
-	else
+
+	// RenderBundle only wraps the handle - gather the handles into a contiguous array
+	constexpr size_t LocalCount = 64;
+	wgpu::RenderBundle localBundles[LocalCount];
+	std::vector<wgpu::RenderBundle> heapBundles;
+	wgpu::RenderBundle* handles = localBundles;
+	if (bundleCount > LocalCount)
 	{
-		// TODO:
-		Fatal("TODO -      ");
+		heapBundles.resize(bundleCount);
+		handles = heapBundles.data();
 	}
+	for (size_t i = 0; i < bundleCount; i++)
+		handles[i] = bundles[i].bundle;
+
+	renderPass.ExecuteBundles(bundleCount, handles);
+}
+//-----------------------------------------------------------------------------
+void RenderPass::ExecuteBundles(const std::vector<RenderBundle>& bundles) const
+{
+	ExecuteBundles(bundles.size(), bundles.data());
 }
 //-----------------------------------------------------------------------------
 void RenderPass::Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) const
 {
 	renderPass.Draw(vertexCount, instanceCount, firstVertex, firstInstance);
+	drawCallCounter.fetch_add(1, std::memory_order_relaxed);
 }
 //-----------------------------------------------------------------------------
 void RenderPass::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex, uint32_t firstInstance) const
 {
 	renderPass.DrawIndexed(indexCount, instanceCount, firstIndex, baseVertex, firstInstance);
+	drawCallCounter.fetch_add(1, std::memory_order_relaxed);
 }
 //-----------------------------------------------------------------------------
 void RenderPass::DrawIndexedIndirect(const Buffer& indirectBuffer, uint64_t indirectOffset) const
 {
 	renderPass.DrawIndexedIndirect(indirectBuffer.buffer, indirectOffset);
+	drawCallCounter.fetch_add(1, std::memory_order_relaxed);
 }
 //-----------------------------------------------------------------------------
 void RenderPass::DrawIndirect(const Buffer& indirectBuffer, uint64_t indirectOffset) const
 {
 	renderPass.DrawIndirect(indirectBuffer.buffer, indirectOffset);
+	drawCallCounter.fetch_add(1, std::memory_order_relaxed);
 }
 //-----------------------------------------------------------------------------
\ No newline at end of file
@@ -7,6 +7,29 @@
 #include <Dawn/utils/WGPUHelpers.h>
 #include <Dawn/dawn_proc.h>
 
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+
+class PipelineCache;
+
+// Work counted by the upload helpers below and by the draws of RenderPass (with the draws of the executed render bundles)
+struct RenderStats
+{
+	uint32_t drawCalls = 0;
+	uint32_t bufferUploads = 0;  // WriteBuffer calls
+	uint32_t textureUploads = 0; // WriteTexture calls
+	uint64_t uploadBytes = 0;
+};
+
+// The work since the previous call, the counters start again from zero. Thread-safe: the uploads may come from other threads.
+RenderStats TakeRenderStats();
+
+// queue.WriteBuffer/WriteTexture counted in the render stats - every upload of the renderer goes through them
+void WriteBuffer(const wgpu::Queue& queue, const wgpu::Buffer& buffer, uint64_t offset, const void* data, size_t size);
+void WriteTexture(const wgpu::Queue& queue, const wgpu::ImageCopyTexture& destination, const void* data, size_t dataSize,
+	const wgpu::TextureDataLayout& dataLayout, const wgpu::Extent3D& writeSize);
+
 class Buffer
 {
 public:
@@ -40,21 +63,98 @@ public:
 	bool Create(const wgpu::Device& device, uint64_t size, const void* data);
 };
 
+class StorageBuffer final : public Buffer
+{
+public:
+	// extraUsage - e.g. Vertex to read the same data as an instance-rate vertex buffer
+	bool Create(const wgpu::Device& device, uint64_t size, const void* data, wgpu::BufferUsage extraUsage = wgpu::BufferUsage::None);
+};
+
+// Suballocation of UniformRingBuffer, bound with offset as the dynamic offset
+struct UniformAllocation
+{
+	void* data = nullptr; // CPU copy, written until UniformRingBuffer::Flush
+	uint32_t offset = 0;
+	uint32_t size = 0;
+};
+
+// Per-frame linear allocator for uniform data. Allocations are bump-allocated (aligned to minUniformBufferOffsetAlignment)
+// from a CPU copy of the frame region, Flush uploads the whole region with one WriteBuffer.
+// The buffer is a ring of frameCount regions; bind it once with hasDynamicOffset and pass UniformAllocation::offset per draw.
+class UniformRingBuffer
+{
+public:
+	// frameSize - bytes available per frame (allocations beyond it fail)
+	bool Create(const wgpu::Device& device, uint64_t frameSize, uint32_t frameCount = 3);
+	void Destroy();
+
+	// Moves to the next region of the ring (once per frame, before Allocate)
+	void BeginFrame();
+	UniformAllocation Allocate(uint32_t size);
+	template<typename T>
+	UniformAllocation Push(const T& value)
+	{
+		UniformAllocation allocation = Allocate(sizeof(T));
+		if (allocation.data) memcpy(allocation.data, &value, sizeof(T));
+		return allocation;
+	}
+	// Uploads the allocations of the frame
+	void Flush();
+
+	const wgpu::Buffer& GetBuffer() const { return m_buffer; }
+	uint32_t GetAlignment() const { return m_alignment; }
+	uint32_t GetFrameCount() const { return m_frameCount; }
+	uint32_t GetFrameIndex() const { return m_frameIndex; }
+	// Offset of the region of a frame index
+	uint64_t GetFrameOffset(uint32_t frameIndex) const { return uint64_t(frameIndex) * m_frameSize; }
+	uint64_t GetUsedSize() const { return m_used; }
+
+private:
+	wgpu::Device m_device = nullptr;
+	wgpu::Buffer m_buffer = nullptr;
+	std::vector<uint8_t> m_staging;
+	uint64_t m_frameSize = 0;
+	uint64_t m_used = 0;
+	uint32_t m_alignment = 256;
+	uint32_t m_frameCount = 0;
+	uint32_t m_frameIndex = 0;
+};
+
 class BindGroup
 {
 public:
 	wgpu::BindGroup bindGroup = nullptr;
 };
 
+class BindGroupCache;
+
+// The bindings are numbered in the order of the Add calls (like the locations of VertexBufferLayout::AddAttrib)
 class BindGroupLayout
 {
 public:
-	void AddVertexUniform();
-	void Create();
+	void AddVertexUniform(uint64_t minBindingSize = 0, bool hasDynamicOffset = false);
+	void AddUniform(wgpu::ShaderStage visibility, uint64_t minBindingSize = 0, bool hasDynamicOffset = false);
+	void AddStorage(wgpu::ShaderStage visibility, bool readOnly = true, uint64_t minBindingSize = 0, bool hasDynamicOffset = false);
+	void AddTexture(wgpu::ShaderStage visibility = wgpu::ShaderStage::Fragment,
+		wgpu::TextureSampleType sampleType = wgpu::TextureSampleType::Float,
+		wgpu::TextureViewDimension viewDimension = wgpu::TextureViewDimension::e2D);
+	void AddSampler(wgpu::ShaderStage visibility = wgpu::ShaderStage::Fragment, wgpu::SamplerBindingType type = wgpu::SamplerBindingType::Filtering);
 
+	bool Create(const wgpu::Device& device);
+	// Identical layouts share one wgpu::BindGroupLayout of the cache
+	bool Create(BindGroupCache& cache);
+
+	// Pipeline layout with this bind group layout as group 0
 	wgpu::PipelineLayout CreatePipelineLayout() const;
 
+	const std::vector<wgpu::BindGroupLayoutEntry>& GetEntries() const { return m_entries; }
+
 	wgpu::BindGroupLayout layout = nullptr;
+private:
+	wgpu::BindGroupLayoutEntry& addEntry(wgpu::ShaderStage visibility);
+
+	wgpu::Device m_device = nullptr;
+	std::vector<wgpu::BindGroupLayoutEntry> m_entries;
 };
 
 class PipelineLayout
@@ -68,6 +168,8 @@ class VertexBufferLayout
 public:
 	// example offset = offsetof(VertexAttributes, position);
 	void SetVertexSize(uint64_t size);
+	// Instance - the attributes advance per instance instead of per vertex
+	void SetStepMode(wgpu::VertexStepMode stepMode);
 	void AddAttrib(wgpu::VertexFormat format, uint64_t offset);
 	void AddAttrib(uint32_t shaderLocation, wgpu::VertexFormat format, uint64_t offset);
 	wgpu::VertexBufferLayout Get() const;
@@ -77,12 +179,57 @@ public:
 private:
 	std::vector<wgpu::VertexAttribute> m_attribs;
 	uint64_t m_size = 0;
+	wgpu::VertexStepMode m_stepMode = wgpu::VertexStepMode::Vertex;
 };
 
 class RenderBundle
 {
 public:
 	wgpu::RenderBundle bundle = nullptr;
+	uint32_t drawCount = 0; // recorded into the bundle, counted by RenderPass::ExecuteBundles
+};
+
+// Render bundles of static scene chunks. A chunk is recorded on first use and re-recorded only when its content hash
+// changes or it is invalidated, otherwise the same bundle is executed every frame without any encoding.
+class RenderBundleCache
+{
+public:
+	// returns the number of draws it has recorded
+	using RecordFunction = std::function<uint32_t(wgpu::RenderBundleEncoder& encoder)>;
+
+	// the formats of the render pass the bundles are executed in
+	void Create(const wgpu::Device& device, wgpu::TextureFormat colorFormat, wgpu::TextureFormat depthStencilFormat, uint32_t sampleCount = 1);
+	void Destroy();
+
+	// Starts the bundle list of a frame
+	void BeginFrame();
+	// Adds the bundle of the chunk to the frame list. record is called only when the chunk is missing or contentHash differs.
+	const RenderBundle& Use(uint64_t chunkId, uint64_t contentHash, const RecordFunction& record);
+	// Bundles added by Use since BeginFrame, in call order (RenderPass::ExecuteBundles)
+	const std::vector<RenderBundle>& GetFrameBundles() const { return m_frameBundles; }
+
+	void Invalidate(uint64_t chunkId);
+	// e.g. after the render pass formats have changed
+	void InvalidateAll();
+	void SetFormats(wgpu::TextureFormat colorFormat, wgpu::TextureFormat depthStencilFormat, uint32_t sampleCount = 1);
+
+	// Bundles recorded since Create (all Use calls minus cache hits)
+	uint32_t GetRecordCount() const { return m_recordCount; }
+
+private:
+	struct Chunk
+	{
+		RenderBundle bundle;
+		uint64_t contentHash = 0;
+	};
+
+	wgpu::Device m_device = nullptr;
+	wgpu::TextureFormat m_colorFormat = wgpu::TextureFormat::Undefined;
+	wgpu::TextureFormat m_depthStencilFormat = wgpu::TextureFormat::Undefined;
+	uint32_t m_sampleCount = 1;
+	std::unordered_map<uint64_t, Chunk> m_chunks;
+	std::vector<RenderBundle> m_frameBundles;
+	uint32_t m_recordCount = 0;
 };
 
 class RenderPipeline
@@ -108,14 +255,25 @@ public:
 
 	void SetVertexBufferLayout(VertexBufferLayout vertexBufferLayout);
 	void SetVertexBufferLayout(const std::vector<VertexBufferLayout>& vertexBufferLayout);
+	void SetVertexBufferLayout(const VertexBufferLayout* vertexBufferLayout, size_t count);
 	void SetVertexShaderCode(wgpu::ShaderModule shaderModule, const char* entryPoint = "vs_main");
 	void SetFragmentShaderCode(wgpu::ShaderModule shaderModule, const char* entryPoint = "fs_main");
 	void SetPipelineLayout(const PipelineLayout& layout); // ===>  BindGroupLayout???
 
 	bool Create(wgpu::Device device);
+	// Identical descriptors share one pipeline of the cache
+	bool Create(PipelineCache& cache);
+	// Compiles the pipeline on the Dawn worker threads, the draws must be skipped until IsReady
+	void CreateAsync(PipelineCache& cache);
+	// Picks up the pipeline of CreateAsync
+	bool IsReady();
 
 	wgpu::RenderPipeline pipeline = nullptr;
 private:
+	void prepareDescriptor();
+
+	PipelineCache* m_asyncCache = nullptr;
+	uint64_t m_asyncKey = 0;
 	wgpu::RenderPipelineDescriptor m_pipelineDescriptor{};
 	wgpu::BlendState m_blendState{};
 	wgpu::ColorTargetState m_colorTargetState{};
@@ -153,8 +311,11 @@ public:
 	void End();
 
 	void ExecuteBundles(size_t bundleCount, const RenderBundle* bundles) const;
+	void ExecuteBundles(const std::vector<RenderBundle>& bundles) const;
 
 	wgpu::RenderPassColorAttachment renderPassColorAttachment{};
 	wgpu::RenderPassDepthStencilAttachment depthStencilAttachment{};
+	// GpuProfiler::AddPass, nullptr - the pass is not measured
+	const wgpu::RenderPassTimestampWrites* timestampWrites = nullptr;
 	wgpu::RenderPassEncoder renderPass = nullptr;
 };
\ No newline at end of file
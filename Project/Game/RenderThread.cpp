@@ -0,0 +1,109 @@
+#include "Engine.h"
+
+//-----------------------------------------------------------------------------
+bool RenderThread::Create(Render& render, RenderThreadMode mode)
+{
+	m_render = &render;
+	m_mode = mode;
+
+	uint32_t packetCount = 1;
+	if (m_mode == RenderThreadMode::DoubleBuffered) packetCount = 2;
+	else if (m_mode == RenderThreadMode::TripleBuffered) packetCount = 3;
+	m_packets.resize(packetCount);
+	m_writeIndex = m_readIndex = m_queuedCount = 0;
+
+	if (IsMultithreaded())
+	{
+		m_isRun = true;
+		m_thread = std::thread(&RenderThread::threadFunction, this);
+		Print("Render thread: " + std::to_string(packetCount) + " frame packets");
+	}
+	return true;
+}
+//-----------------------------------------------------------------------------
+void RenderThread::Destroy()
+{
+	if (m_thread.joinable())
+	{
+		// the frames already queued are rendered before the thread exits
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_isRun = false;
+		}
+		m_frameQueued.notify_one();
+		m_thread.join();
+	}
+	m_packets.clear();
+	m_render = nullptr;
+}
+//-----------------------------------------------------------------------------
+FramePacket& RenderThread::BeginFrame()
+{
+	if (IsMultithreaded())
+	{
+		// a packet stays queued until the render thread has finished drawing it
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_frameRendered.wait(lock, [this]() { return m_queuedCount < m_packets.size(); });
+	}
+
+	FramePacket& packet = m_packets[m_writeIndex];
+	packet.Reset();
+	return packet;
+}
+//-----------------------------------------------------------------------------
+void RenderThread::EndFrame()
+{
+	if (!IsMultithreaded())
+	{
+		renderFrame(m_packets[0]);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_writeIndex = (m_writeIndex + 1) % m_packets.size();
+		m_queuedCount++;
+	}
+	m_frameQueued.notify_one();
+}
+//-----------------------------------------------------------------------------
+void RenderThread::threadFunction()
+{
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_frameQueued.wait(lock, [this]() { return m_queuedCount > 0 || !m_isRun; });
+			if (m_queuedCount == 0) break; // stopped and nothing left to draw
+		}
+
+		// the simulation thread doesn't touch a queued packet until m_queuedCount is decremented
+		renderFrame(m_packets[m_readIndex]);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_readIndex = (m_readIndex + 1) % m_packets.size();
+			m_queuedCount--;
+		}
+		m_frameRendered.notify_one();
+	}
+}
+//-----------------------------------------------------------------------------
+void RenderThread::renderFrame(const FramePacket& packet)
+{
+	// minimized window
+	if (packet.frameBufferWidth <= 0 || packet.frameBufferHeight <= 0)
+		return;
+
+	// the swap chain is recreated only on the thread that presents
+	if (static_cast<unsigned>(packet.frameBufferWidth) != m_render->GetFrameWidth() || static_cast<unsigned>(packet.frameBufferHeight) != m_render->GetFrameHeight())
+	{
+		if (!m_render->Resize(packet.frameBufferWidth, packet.frameBufferHeight))
+			Fatal("render resize error");
+	}
+
+	// uploads of the streamed textures are spread over frames
+	m_render->GetTextureStreamer().Update();
+	m_render->Frame(packet);
+}
+//-----------------------------------------------------------------------------
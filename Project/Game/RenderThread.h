@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+enum class RenderThreadMode : uint8_t
+{
+	SingleThread,   // Render::Frame is called on the main thread right after IApp::Frame
+	DoubleBuffered, // dedicated render thread, the simulation may run one frame ahead
+	TripleBuffered  // dedicated render thread, the simulation may run two frames ahead
+};
+
+// Hands the frame packets from the simulation thread to the render thread.
+// The packets form a ring: BeginFrame blocks while all of them are in flight, so the simulation never gets more than (packet count - 1) frames ahead.
+class RenderThread
+{
+public:
+	bool Create(Render& render, RenderThreadMode mode);
+	void Destroy();
+
+	// Packet to fill for the next frame (simulation thread)
+	FramePacket& BeginFrame();
+	// Passes the packet returned by BeginFrame to the render (simulation thread)
+	void EndFrame();
+
+	bool IsMultithreaded() const { return m_mode != RenderThreadMode::SingleThread; }
+
+private:
+	void threadFunction();
+	void renderFrame(const FramePacket& packet);
+
+	Render* m_render = nullptr;
+	RenderThreadMode m_mode = RenderThreadMode::SingleThread;
+
+	std::vector<FramePacket> m_packets;
+	uint32_t m_writeIndex = 0;
+	uint32_t m_readIndex = 0;
+	uint32_t m_queuedCount = 0; // packets submitted and not yet rendered (guarded by m_mutex)
+
+	std::thread m_thread;
+	std::mutex m_mutex;
+	std::condition_variable m_frameQueued;
+	std::condition_variable m_frameRendered;
+	bool m_isRun = false;
+};
@@ -30,7 +30,7 @@ wgpu::Buffer CreateBuffer(const wgpu::Device& device, const void* data, uint64_t
 	};
 	wgpu::Buffer buffer = device.CreateBuffer(&descriptor);
 
-	if (data) device.GetQueue().WriteBuffer(buffer, 0, data, size);
+	if (data) WriteBuffer(device.GetQueue(), buffer, 0, data, size);
 	return buffer;
 }
 
@@ -100,15 +100,16 @@ wgpu::Texture CreateTexture(wgpu::Device& device, wgpu::Extent3D size, wgpu::Tex
 			.bytesPerRow = size.width * texelBlockSize,
 			.rowsPerImage = size.height,
 		};
-		device.GetQueue().WriteTexture(&destination, data, size.width * size.height * texelBlockSize, &dataLayout, &size);
+		WriteTexture(device.GetQueue(), destination, data, size.width * size.height * texelBlockSize, dataLayout, size);
 	}
 	return texture;
 }
 
-wgpu::Texture CreateRenderTexture(wgpu::Device& device, wgpu::Extent3D size, wgpu::TextureFormat format)
+wgpu::Texture CreateRenderTexture(wgpu::Device& device, wgpu::Extent3D size, wgpu::TextureFormat format,
+	wgpu::TextureUsage usage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::TextureBinding)
 {
 	wgpu::TextureDescriptor textureDesc{
-		.usage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::TextureBinding,
+		.usage = usage,
 		.size = size,
 		.format = format,
 	};
@@ -122,63 +123,34 @@ uint32_t bit_width(uint32_t m) {
 }
 
 // Auxiliary function for loadTexture
-static void writeMipMaps(wgpu::Device& device, wgpu::Texture texture, wgpu::Extent3D textureSize, [[maybe_unused]] uint32_t mipLevelCount, const unsigned char* pixelData)
+static void writeMipMaps(wgpu::Device& device, wgpu::Texture texture, wgpu::Extent3D textureSize, uint32_t mipLevelCount, const unsigned char* pixelData)
 {
+	// all levels are built in one allocation (SIMD box filter), then uploaded level by level
+	MipChain mipChain;
+	mipChain.Generate(pixelData, textureSize.width, textureSize.height, mipLevelCount);
+
 	wgpu::ImageCopyTexture destination;
 	destination.texture = texture;
-	//destination.mipLevel = 0;
 	destination.origin = { 0, 0, 0 };
 	destination.aspect = wgpu::TextureAspect::All;
 
 	wgpu::TextureDataLayout source;
 	source.offset = 0;
 
-	// Create image data
-	wgpu::Extent3D mipLevelSize = textureSize;
-	std::vector<unsigned char> previousLevelPixels;
-	wgpu::Extent3D previousMipLevelSize;
-	for (uint32_t level = 0; level < mipLevelCount; ++level)
+	for (uint32_t level = 0; level < mipChain.GetLevelCount(); ++level)
 	{
-		// Pixel data for the current level
-		std::vector<unsigned char> pixels(4 * mipLevelSize.width * mipLevelSize.height);
-		if (level == 0) {
-			// We cannot really avoid this copy since we need this
-			// in previousLevelPixels at the next iteration
-			memcpy(pixels.data(), pixelData, pixels.size());
-		}
-		else {
-			// Create mip level data
-			for (uint32_t i = 0; i < mipLevelSize.width; ++i) {
-				for (uint32_t j = 0; j < mipLevelSize.height; ++j) {
-					unsigned char* p = &pixels[4 * (j * mipLevelSize.width + i)];
-					// Get the corresponding 4 pixels from the previous level
-					unsigned char* p00 = &previousLevelPixels[4 * ((2 * j + 0) * previousMipLevelSize.width + (2 * i + 0))];
-					unsigned char* p01 = &previousLevelPixels[4 * ((2 * j + 0) * previousMipLevelSize.width + (2 * i + 1))];
-					unsigned char* p10 = &previousLevelPixels[4 * ((2 * j + 1) * previousMipLevelSize.width + (2 * i + 0))];
-					unsigned char* p11 = &previousLevelPixels[4 * ((2 * j + 1) * previousMipLevelSize.width + (2 * i + 1))];
-					// Average
-					p[0] = (p00[0] + p01[0] + p10[0] + p11[0]) / 4;
-					p[1] = (p00[1] + p01[1] + p10[1] + p11[1]) / 4;
-					p[2] = (p00[2] + p01[2] + p10[2] + p11[2]) / 4;
-					p[3] = (p00[3] + p01[3] + p10[3] + p11[3]) / 4;
-				}
-			}
-		}
+		const MipLevel& mipLevel = mipChain.GetLevel(level);
+		wgpu::Extent3D mipLevelSize{ mipLevel.width, mipLevel.height, 1 };
 
-		// Upload data to the GPU texture
 		destination.mipLevel = level;
-		source.bytesPerRow = 4 * mipLevelSize.width;
-		source.rowsPerImage = mipLevelSize.height;
-		device.GetQueue().WriteTexture(&destination, pixels.data(), pixels.size(), &source, &mipLevelSize);
-
-		previousLevelPixels = std::move(pixels);
-		previousMipLevelSize = mipLevelSize;
-		mipLevelSize.width /= 2;
-		mipLevelSize.height /= 2;
+		source.bytesPerRow = 4 * mipLevel.width;
+		source.rowsPerImage = mipLevel.height;
+		WriteTexture(device.GetQueue(), destination, mipChain.GetLevelData(level), mipChain.GetLevelSize(level), source, mipLevelSize);
 	}
 }
 
-wgpu::Texture LoadTexture(wgpu::Device& device, std::filesystem::path path, wgpu::TextureView* pTextureView = nullptr)
+// mipGenerator = nullptr or disabled - mip levels are built on the CPU
+wgpu::Texture LoadTexture(wgpu::Device& device, std::filesystem::path path, wgpu::TextureView* pTextureView = nullptr, ComputeMipGenerator* mipGenerator = nullptr)
 {
 	int width, height, channels;
 	unsigned char* pixelData = stbi_load(path.string().c_str(), &width, &height, &channels, 4);
@@ -186,17 +158,37 @@ wgpu::Texture LoadTexture(wgpu::Device& device, std::filesystem::path path, wgpu
 
 	wgpu::Extent3D size{ static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1 };
 
-	wgpu::TextureDescriptor textureDesc{
-		.usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopyDst,
-		.dimension = wgpu::TextureDimension::e2D,
-		.size = size,
-		.format = wgpu::TextureFormat::RGBA8Unorm,
-		.mipLevelCount = bit_width(std::max(textureDesc.size.width, textureDesc.size.height)),
-		.sampleCount = 1,
-	};
+	wgpu::TextureDescriptor textureDesc{};
+	textureDesc.usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopyDst;
+	textureDesc.dimension = wgpu::TextureDimension::e2D;
+	textureDesc.size = size;
+	textureDesc.format = wgpu::TextureFormat::RGBA8Unorm;
+	textureDesc.mipLevelCount = bit_width(std::max(size.width, size.height));
+	textureDesc.sampleCount = 1;
+	const bool generateOnGPU = mipGenerator && mipGenerator->IsSupported(textureDesc.format);
+	if (generateOnGPU)
+		textureDesc.usage |= wgpu::TextureUsage::StorageBinding;
+	// the generator reads the levels back to compare them with the CPU chain
+	if (generateOnGPU && mipGenerator->IsValidationEnabled())
+		textureDesc.usage |= wgpu::TextureUsage::CopySrc;
 	wgpu::Texture texture = device.CreateTexture(&textureDesc);
 
-	writeMipMaps(device, texture, textureDesc.size, textureDesc.mipLevelCount, pixelData);
+	bool generated = false;
+	if (generateOnGPU)
+	{
+		wgpu::ImageCopyTexture destination{};
+		destination.texture = texture;
+		wgpu::TextureDataLayout source{};
+		source.bytesPerRow = 4 * size.width;
+		source.rowsPerImage = size.height;
+		WriteTexture(device.GetQueue(), destination, pixelData, 4 * size.width * size.height, source, size);
+		generated = mipGenerator->Generate(texture);
+	}
+	// the CPU levels replace the GPU ones that failed (or failed the validation)
+	if (!generated)
+	{
+		writeMipMaps(device, texture, textureDesc.size, textureDesc.mipLevelCount, pixelData);
+	}
 
 	stbi_image_free(pixelData);
 
@@ -264,7 +256,7 @@ wgpu::Texture LoadTextureMipmap(wgpu::Device& device, std::filesystem::path path
 			.bytesPerRow = 4 * currSize.width,
 			.rowsPerImage = currSize.height,
 		};
-		device.GetQueue().WriteTexture(&destination, currData, currSize.width * currSize.height * 4, &source, &currSize );
+		WriteTexture(device.GetQueue(), destination, currData, currSize.width * currSize.height * 4, source, currSize);
 	}
 
 	stbi_image_free(currData);
@@ -0,0 +1,267 @@
+#include "Engine.h"
+
+//-----------------------------------------------------------------------------
+SceneNodeId SceneGraph::CreateNode(SceneNodeId parent)
+{
+	if (parent != kNoSceneNode && !IsAlive(parent))
+	{
+		Error("SceneGraph::CreateNode: the parent node is not alive");
+		parent = kNoSceneNode;
+	}
+
+	SceneNodeId id;
+	if (!m_freeIds.empty())
+	{
+		id = m_freeIds.back();
+		m_freeIds.pop_back();
+	}
+	else
+	{
+		id = static_cast<SceneNodeId>(m_nodes.size());
+		m_nodes.emplace_back();
+	}
+
+	// appended after its parent - the order stays valid until the next rebuild
+	Node& node = m_nodes[id];
+	node.parent = parent;
+	node.index = static_cast<uint32_t>(m_ids.size());
+	node.alive = true;
+
+	m_ids.push_back(id);
+	m_parentIndices.push_back(parent != kNoSceneNode ? m_nodes[parent].index : UINT32_MAX);
+	m_positions.push_back(glm::vec3(0.0f));
+	m_rotations.push_back(glm::identity<glm::quat>());
+	m_scales.push_back(glm::vec3(1.0f));
+	m_dirty.push_back({ true });
+	m_localBounds.emplace_back();
+	m_worldMatrices.push_back(glm::mat4(1.0f));
+	m_worldBounds.emplace_back();
+	m_firstDirty = std::min(m_firstDirty, node.index);
+	return id;
+}
+//-----------------------------------------------------------------------------
+void SceneGraph::DestroyNode(SceneNodeId node)
+{
+	if (!IsAlive(node)) return;
+	m_nodes[node].alive = false;
+	m_orderDirty = true;
+}
+//-----------------------------------------------------------------------------
+void SceneGraph::SetParent(SceneNodeId node, SceneNodeId parent)
+{
+	if (!IsAlive(node) || m_nodes[node].parent == parent) return;
+	if (parent != kNoSceneNode)
+	{
+		if (!IsAlive(parent))
+		{
+			Error("SceneGraph::SetParent: the parent node is not alive");
+			return;
+		}
+		for (SceneNodeId ancestor = parent; ancestor != kNoSceneNode; ancestor = m_nodes[ancestor].parent)
+		{
+			if (ancestor == node)
+			{
+				Error("SceneGraph::SetParent: a node can't be moved into its own subtree");
+				return;
+			}
+		}
+	}
+
+	m_nodes[node].parent = parent;
+	m_orderDirty = true;
+	markDirty(node);
+}
+//-----------------------------------------------------------------------------
+void SceneGraph::SetLocalTransform(SceneNodeId node, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+	const uint32_t index = m_nodes[node].index;
+	m_positions[index] = position;
+	m_rotations[index] = rotation;
+	m_scales[index] = scale;
+	markDirty(node);
+}
+//-----------------------------------------------------------------------------
+void SceneGraph::SetPosition(SceneNodeId node, const glm::vec3& position)
+{
+	m_positions[m_nodes[node].index] = position;
+	markDirty(node);
+}
+//-----------------------------------------------------------------------------
+void SceneGraph::SetRotation(SceneNodeId node, const glm::quat& rotation)
+{
+	m_rotations[m_nodes[node].index] = rotation;
+	markDirty(node);
+}
+//-----------------------------------------------------------------------------
+void SceneGraph::SetScale(SceneNodeId node, const glm::vec3& scale)
+{
+	m_scales[m_nodes[node].index] = scale;
+	markDirty(node);
+}
+//-----------------------------------------------------------------------------
+void SceneGraph::SetLocalBounds(SceneNodeId node, const BoundingBox& bounds)
+{
+	m_localBounds[m_nodes[node].index] = bounds;
+	markDirty(node);
+}
+//-----------------------------------------------------------------------------
+void SceneGraph::Update()
+{
+	PROFILE_SCOPE("SceneGraph Update");
+	if (m_orderDirty)
+		rebuildOrder();
+
+	m_updatedNodeCount = 0;
+	const uint32_t count = GetNodeCount();
+	const uint32_t first = m_firstDirty;
+	if (first >= count) return;
+
+	// a parent precedes its children: one pass marks the whole subtrees of the changed nodes
+	for (uint32_t i = first; i < count; i++)
+	{
+		const uint32_t parent = m_parentIndices[i];
+		if (parent != UINT32_MAX && m_dirty[parent].value)
+			m_dirty[i].value = true;
+	}
+
+	// local matrices of the dirty nodes in SIMD batches, then parent * local in place
+	static_assert(sizeof(DirtyFlag) == sizeof(bool), "the dirty flags are passed to the kernel as a plain bool array");
+	ComputeWorldMatrices(count - first, &m_positions[first], &m_rotations[first], &m_scales[first], &m_dirty[first].value, &m_worldMatrices[first]);
+	for (uint32_t i = first; i < count; i++)
+	{
+		if (!m_dirty[i].value) continue;
+
+		const uint32_t parent = m_parentIndices[i];
+		if (parent != UINT32_MAX)
+			m_worldMatrices[i] = m_worldMatrices[parent] * m_worldMatrices[i];
+		m_worldBounds[i] = m_localBounds[i].Transform(m_worldMatrices[i]);
+		updateProxy(m_nodes[m_ids[i]], i);
+		m_dirty[i].value = false;
+		m_updatedNodeCount++;
+	}
+	m_firstDirty = UINT32_MAX;
+}
+//-----------------------------------------------------------------------------
+void SceneGraph::markDirty(SceneNodeId node)
+{
+	const uint32_t index = m_nodes[node].index;
+	m_dirty[index].value = true;
+	m_firstDirty = std::min(m_firstDirty, index);
+}
+//-----------------------------------------------------------------------------
+void SceneGraph::updateProxy(Node& node, uint32_t index)
+{
+	const BoundingBox& bounds = m_worldBounds[index];
+	if (bounds.IsEmpty())
+	{
+		if (node.proxy != Bvh::kNullProxy)
+		{
+			m_bvh.Remove(node.proxy);
+			node.proxy = Bvh::kNullProxy;
+		}
+	}
+	else if (node.proxy == Bvh::kNullProxy)
+		node.proxy = m_bvh.Insert(bounds, m_ids[index]);
+	else
+		m_bvh.Move(node.proxy, bounds);
+}
+//-----------------------------------------------------------------------------
+void SceneGraph::rebuildOrder()
+{
+	PROFILE_SCOPE("SceneGraph rebuildOrder");
+	m_orderDirty = false;
+	const uint32_t nodeCount = static_cast<uint32_t>(m_nodes.size());
+
+	// children of every node in id order (counting sort by parent)
+	std::vector<uint32_t> childStart(nodeCount + 1, 0);
+	for (SceneNodeId id = 0; id < nodeCount; id++)
+	{
+		if (m_nodes[id].alive && m_nodes[id].parent != kNoSceneNode)
+			childStart[m_nodes[id].parent + 1]++;
+	}
+	for (uint32_t i = 0; i < nodeCount; i++)
+		childStart[i + 1] += childStart[i];
+	std::vector<SceneNodeId> children(childStart[nodeCount]);
+	std::vector<uint32_t> childCount(nodeCount, 0);
+	for (SceneNodeId id = 0; id < nodeCount; id++)
+	{
+		const SceneNodeId parent = m_nodes[id].parent;
+		if (m_nodes[id].alive && parent != kNoSceneNode)
+			children[childStart[parent] + childCount[parent]++] = id;
+	}
+
+	// breadth-first from the roots, the subtrees of destroyed nodes are not reached
+	std::vector<SceneNodeId> order;
+	order.reserve(m_ids.size());
+	for (SceneNodeId id = 0; id < nodeCount; id++)
+	{
+		if (m_nodes[id].alive && m_nodes[id].parent == kNoSceneNode)
+			order.push_back(id);
+	}
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		const SceneNodeId id = order[i];
+		for (uint32_t c = childStart[id]; c < childStart[id + 1]; c++)
+			order.push_back(children[c]);
+	}
+
+	std::vector<bool> reached(nodeCount, false);
+	for (SceneNodeId id : order)
+		reached[id] = true;
+	m_freeIds.clear();
+	for (SceneNodeId id = nodeCount; id-- > 0;)
+	{
+		if (!reached[id])
+		{
+			if (m_nodes[id].proxy != Bvh::kNullProxy)
+			{
+				m_bvh.Remove(m_nodes[id].proxy);
+				m_nodes[id].proxy = Bvh::kNullProxy;
+			}
+			m_nodes[id].alive = false;
+			m_freeIds.push_back(id); // the lowest id is reused first
+		}
+	}
+
+	// the arrays are gathered in the new order
+	const uint32_t count = static_cast<uint32_t>(order.size());
+	std::vector<uint32_t> parentIndices(count);
+	std::vector<glm::vec3> positions(count);
+	std::vector<glm::quat> rotations(count);
+	std::vector<glm::vec3> scales(count);
+	std::vector<DirtyFlag> dirty(count);
+	std::vector<BoundingBox> localBounds(count);
+	std::vector<glm::mat4> worldMatrices(count);
+	std::vector<BoundingBox> worldBounds(count);
+	m_firstDirty = UINT32_MAX;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const uint32_t oldIndex = m_nodes[order[i]].index;
+		positions[i] = m_positions[oldIndex];
+		rotations[i] = m_rotations[oldIndex];
+		scales[i] = m_scales[oldIndex];
+		dirty[i] = m_dirty[oldIndex];
+		localBounds[i] = m_localBounds[oldIndex];
+		worldMatrices[i] = m_worldMatrices[oldIndex];
+		worldBounds[i] = m_worldBounds[oldIndex];
+		if (dirty[i].value)
+			m_firstDirty = std::min(m_firstDirty, i);
+	}
+	for (uint32_t i = 0; i < count; i++)
+	{
+		m_nodes[order[i]].index = i;
+		const SceneNodeId parent = m_nodes[order[i]].parent;
+		parentIndices[i] = parent != kNoSceneNode ? m_nodes[parent].index : UINT32_MAX;
+	}
+
+	m_ids = std::move(order);
+	m_parentIndices = std::move(parentIndices);
+	m_positions = std::move(positions);
+	m_rotations = std::move(rotations);
+	m_scales = std::move(scales);
+	m_dirty = std::move(dirty);
+	m_localBounds = std::move(localBounds);
+	m_worldMatrices = std::move(worldMatrices);
+	m_worldBounds = std::move(worldBounds);
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Bvh.h"
+
+// Node of a SceneGraph. The id stays the same when the hierarchy is reordered, it is reused after the node is destroyed.
+using SceneNodeId = uint32_t;
+constexpr SceneNodeId kNoSceneNode = UINT32_MAX;
+
+// Transform hierarchy. The nodes are kept in flat arrays in breadth-first order (a parent always precedes its children),
+// so the world matrices are computed in one forward pass. Only the nodes changed since the last Update and their
+// subtrees are recomputed: a static level costs nothing per frame.
+// The nodes with bounds are kept in a BVH for the visibility queries.
+// Not thread-safe, the results are read after Update.
+class SceneGraph
+{
+public:
+	SceneNodeId CreateNode(SceneNodeId parent = kNoSceneNode);
+	// The subtree of the node is destroyed too (the ids of the children are released by the next Update)
+	void DestroyNode(SceneNodeId node);
+	void SetParent(SceneNodeId node, SceneNodeId parent);
+	SceneNodeId GetParent(SceneNodeId node) const { return m_nodes[node].parent; }
+	bool IsAlive(SceneNodeId node) const { return node < m_nodes.size() && m_nodes[node].alive; }
+
+	void SetLocalTransform(SceneNodeId node, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+	void SetPosition(SceneNodeId node, const glm::vec3& position);
+	void SetRotation(SceneNodeId node, const glm::quat& rotation);
+	void SetScale(SceneNodeId node, const glm::vec3& scale);
+	// Bounds of the node content (mesh) in its local space, empty - the node has no content
+	void SetLocalBounds(SceneNodeId node, const BoundingBox& bounds);
+
+	const glm::vec3& GetPosition(SceneNodeId node) const { return m_positions[m_nodes[node].index]; }
+	const glm::quat& GetRotation(SceneNodeId node) const { return m_rotations[m_nodes[node].index]; }
+	const glm::vec3& GetScale(SceneNodeId node) const { return m_scales[m_nodes[node].index]; }
+	// Valid after Update
+	const glm::mat4& GetWorldMatrix(SceneNodeId node) const { return m_worldMatrices[m_nodes[node].index]; }
+	const BoundingBox& GetWorldBounds(SceneNodeId node) const { return m_worldBounds[m_nodes[node].index]; }
+
+	// Restores the breadth-first order after hierarchy changes and recomputes the dirty subtrees
+	void Update();
+
+	// The flat arrays in breadth-first order (for the systems that walk all nodes, valid until the next hierarchy change)
+	uint32_t GetNodeCount() const { return static_cast<uint32_t>(m_ids.size()); }
+	const SceneNodeId* GetNodeIds() const { return m_ids.data(); }
+	const glm::mat4* GetWorldMatrices() const { return m_worldMatrices.data(); }
+	const BoundingBox* GetWorldBounds() const { return m_worldBounds.data(); }
+	// Nodes recomputed by the last Update
+	uint32_t GetUpdatedNodeCount() const { return m_updatedNodeCount; }
+
+	// Replaces visible with the nodes whose world bounds are not outside the frustum (valid after Update)
+	void QueryVisible(const Frustum& frustum, std::vector<SceneNodeId>& visible) const { m_bvh.Query(frustum, visible); }
+	const Bvh& GetBvh() const { return m_bvh; }
+
+private:
+	struct Node
+	{
+		SceneNodeId parent = kNoSceneNode;
+		uint32_t index = 0; // in the flat arrays
+		uint32_t proxy = Bvh::kNullProxy; // the node has non-empty world bounds
+		bool alive = false;
+	};
+	// std::vector<bool> is a bit array, the transform kernel reads a bool array
+	struct DirtyFlag
+	{
+		bool value = false;
+	};
+
+	void markDirty(SceneNodeId node);
+	// Inserts, moves or removes the BVH leaf after the world bounds of the node changed
+	void updateProxy(Node& node, uint32_t index);
+	void rebuildOrder();
+
+	std::vector<Node> m_nodes; // by id
+	std::vector<SceneNodeId> m_freeIds;
+	bool m_orderDirty = false;
+	uint32_t m_firstDirty = UINT32_MAX; // index of the first dirty node, the dirty subtrees are all after it
+
+	// breadth-first order
+	std::vector<SceneNodeId> m_ids;
+	std::vector<uint32_t> m_parentIndices; // UINT32_MAX - root
+	std::vector<glm::vec3> m_positions;
+	std::vector<glm::quat> m_rotations;
+	std::vector<glm::vec3> m_scales;
+	std::vector<DirtyFlag> m_dirty;
+	std::vector<BoundingBox> m_localBounds;
+	std::vector<glm::mat4> m_worldMatrices;
+	std::vector<BoundingBox> m_worldBounds;
+
+	Bvh m_bvh; // the user data is the node id
+
+	uint32_t m_updatedNodeCount = 0;
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+// Compile time SIMD selection. The predefined macros are the same ones glm/simd/platform.h checks,
+// glm itself doesn't enable them because glmConfig.h sets GLM_FORCE_XYZW_ONLY.
+// SIMD_AVX2 implies SIMD_SSE2.
+
+#if defined(__AVX2__)
+#	define SIMD_AVX2 1
+#	define SIMD_SSE2 1
+#	include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define SIMD_SSE2 1
+#	include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#	define SIMD_NEON 1
+#	include <arm_neon.h>
+#endif
+
+inline const char* GetSimdName()
+{
+#if defined(SIMD_AVX2)
+	return "AVX2";
+#elif defined(SIMD_SSE2)
+	return "SSE2";
+#elif defined(SIMD_NEON)
+	return "NEON";
+#else
+	return "Scalar";
+#endif
+}
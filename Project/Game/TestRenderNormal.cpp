@@ -75,16 +75,17 @@ wgpu::Buffer m_lightingUniformBuffer = nullptr;
 LightingUniforms m_lightingUniforms;
 
 int indexCount;
-std::vector<VertexAttributes> vertexData;
+MeshCache meshCache;
 float angle1;
 glm::mat4x4 R1;
 glm::mat4x4 T1;
 glm::mat4x4 S;
 
-wgpu::Texture m_baseColorTexture;
-wgpu::TextureView m_baseColorTextureView;
-wgpu::Texture m_normalTexture;
-wgpu::TextureView m_normalTextureView;
+std::shared_ptr<StreamedTexture> m_baseColorTexture;
+std::shared_ptr<StreamedTexture> m_normalTexture;
+// versions of the textures used by bindGroup2
+uint32_t m_baseColorTextureVersion = 0;
+uint32_t m_normalTextureVersion = 0;
 
 wgpu::Sampler sampler2;
 wgpu::BindGroupLayout bindGroupLayout;
@@ -395,7 +396,7 @@ fn fs_main(in: VertexOutput) -> @location(0) vec4f
 	return pipeline2 != nullptr;
 }
 
-bool initTexture(wgpu::Device device)
+bool initTexture(wgpu::Device device, TextureStreamer& textureStreamer)
 {
 	// Create a sampler
 	wgpu::SamplerDescriptor samplerDesc;
@@ -412,23 +413,23 @@ bool initTexture(wgpu::Device device)
 	sampler2 = device.CreateSampler(&samplerDesc);
 
 #if SHIP
-	m_baseColorTexture = LoadTexture(device, "../Data/Models/fourareen2K_albedo.jpg", &m_baseColorTextureView);
-	m_normalTexture = LoadTexture(device, "../Data/Models/fourareen2K_normals.png", &m_normalTextureView);
+	m_baseColorTexture = textureStreamer.Load("../Data/Models/fourareen2K_albedo.jpg");
+	m_normalTexture = textureStreamer.Load("../Data/Models/fourareen2K_normals.png");
 #else
-	m_baseColorTexture = LoadTexture(device, "../Data/Models/cobblestone_floor_08_diff_2k.jpg", &m_baseColorTextureView);
-	m_normalTexture = LoadTexture(device, "../Data/Models/cobblestone_floor_08_nor_gl_2k.png", &m_normalTextureView);
+	m_baseColorTexture = textureStreamer.Load("../Data/Models/cobblestone_floor_08_diff_2k.jpg");
+	m_normalTexture = textureStreamer.Load("../Data/Models/cobblestone_floor_08_nor_gl_2k.png");
 #endif
 
-	return m_baseColorTextureView != nullptr && m_normalTextureView != nullptr;
+	return m_baseColorTexture != nullptr && m_normalTexture != nullptr;
 }
 
 bool initGeometry(wgpu::Device device)
 {
 	// Load mesh data from OBJ file
 #if SHIP
-	bool success = loadGeometryFromObj("../Data/models/fourareen.obj", vertexData);
+	bool success = loadGeometryFromObjCached("../Data/models/fourareen.obj", meshCache);
 #else
-	bool success = loadGeometryFromObj("../Data/models/cylinder.obj", vertexData);
+	bool success = loadGeometryFromObjCached("../Data/models/cylinder.obj", meshCache);
 #endif
 	if (!success)
 	{
@@ -436,10 +437,12 @@ bool initGeometry(wgpu::Device device)
 		return false;
 	}
 
-	vertexBuffer2 = CreateBuffer(device, vertexData.data(), vertexData.size() * sizeof(VertexAttributes), wgpu::BufferUsage::Vertex);
-	indexCount = static_cast<int>(vertexData.size());
+	// the streams are uploaded straight from the mapped cache file
+	vertexBuffer2 = CreateBuffer(device, meshCache.GetVertexData(), meshCache.GetVertexDataSize(), wgpu::BufferUsage::Vertex);
+	indexBuffer2 = CreateBuffer(device, meshCache.GetIndexData(), meshCache.GetIndexDataSize(), wgpu::BufferUsage::Index);
+	indexCount = static_cast<int>(meshCache.GetIndexCount());
 
-	return vertexBuffer2 != nullptr;
+	return vertexBuffer2 != nullptr && indexBuffer2 != nullptr;
 }
 
 bool initUniforms(wgpu::Device device)
@@ -466,10 +469,12 @@ bool initBindGroup(wgpu::Device device)
 	bindings[0].size = sizeof(MyUniforms);
 
 	bindings[1].binding = 1;
-	bindings[1].textureView = m_baseColorTextureView;
+	bindings[1].textureView = m_baseColorTexture->view;
+	m_baseColorTextureVersion = m_baseColorTexture->version;
 
 	bindings[2].binding = 2;
-	bindings[2].textureView = m_normalTextureView;
+	bindings[2].textureView = m_normalTexture->view;
+	m_normalTextureVersion = m_normalTexture->version;
 
 	bindings[3].binding = 3;
 	bindings[3].sampler = sampler2;
@@ -641,7 +646,9 @@ bool Render::Create(void* glfwWindow)
 		return false;
 	if (!initRenderPipeline(m_data->device, m_data->swapChainFormat, m_data->depthTextureFormat))
 		return false;
-	if (!initTexture(m_data->device))
+	if (!m_textureStreamer.Create(m_data->device, m_jobSystem))
+		return false;
+	if (!initTexture(m_data->device, m_textureStreamer))
 		return false;
 	if (!initGeometry(m_data->device))
 		return false;
@@ -661,6 +668,7 @@ bool Render::Create(void* glfwWindow)
 //-----------------------------------------------------------------------------
 void Render::Destroy()
 {
+	m_textureStreamer.Destroy();
 	terminateLightingUniforms();
 	terminateGui();
 	terminateDepthBuffer();
@@ -669,16 +677,20 @@ void Render::Destroy()
 	delete m_data;
 }
 //-----------------------------------------------------------------------------
-void Render::Frame()
+void Render::Frame(const FramePacket& packet)
 {
 	if (updateDragInertia())
 		updateViewMatrix();
 
 	updateLightingUniforms(m_data->device);
 
+	// the streamed textures have replaced the placeholders
+	if (m_baseColorTexture->version != m_baseColorTextureVersion || m_normalTexture->version != m_normalTextureVersion)
+		initBindGroup(m_data->device);
+
 	{
 		// Update uniform buffer
-		uniforms.time = static_cast<float>(glfwGetTime());
+		uniforms.time = static_cast<float>(packet.time);
 		m_data->queue.WriteBuffer(uniformBuffer, offsetof(MyUniforms, time), &uniforms.time, sizeof(MyUniforms::time));
 	}
 
@@ -722,10 +734,10 @@ void Render::Frame()
 	{
 		wgpu::RenderPassEncoder renderPass = encoder.BeginRenderPass(&renderPassDesc);
 		renderPass.SetPipeline(pipeline2);
-		renderPass.SetVertexBuffer(0, vertexBuffer2, 0, vertexData.size() * sizeof(VertexAttributes));
-		//renderPass.SetIndexBuffer(indexBuffer2, wgpu::IndexFormat::Uint16, 0/*, indexData.size() * sizeof(uint16_t)*/);
+		renderPass.SetVertexBuffer(0, vertexBuffer2, 0, meshCache.GetVertexDataSize());
+		renderPass.SetIndexBuffer(indexBuffer2, meshCache.GetIndexFormat(), 0, meshCache.GetIndexDataSize());
 		renderPass.SetBindGroup(0, bindGroup2, 0, nullptr);
-		renderPass.Draw(indexCount, 1, 0, 0);
+		renderPass.DrawIndexed(indexCount, 1, 0, 0, 0);
 
 		updateGui(renderPass);
 
@@ -8,8 +8,6 @@
 #include <glfw.h>
 #include "Texture.h"
 
-#include "texture.h"
-
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
@@ -236,11 +234,13 @@ wgpu_mipmap_generator* wgpu_mipmap_generator_create(const wgpu::Device& device)
 	sampler_desc.maxAnisotropy = 1;
 
 	mipmap_generator->sampler = device.CreateSampler(&sampler_desc);
+	mipmap_generator->compute.Create(device);
 	return mipmap_generator;
 }
 
 void wgpu_mipmap_generator_destroy(wgpu_mipmap_generator* mipmap_generator)
 {
+	mipmap_generator->compute.Destroy();
 	delete mipmap_generator;
 }
 
@@ -358,11 +358,15 @@ wgpu::RenderPipeline wgpu_mipmap_generator_get_mipmap_pipeline(wgpu_mipmap_gener
 	return mipmap_generator->pipelines[pipeline_index];
 }
 
-WGPUTexture
-wgpu_mipmap_generator_generate_mipmap(wgpu_mipmap_generator_t* mipmap_generator,
-	WGPUTexture texture,
-	WGPUTextureDescriptor* texture_desc)
+wgpu::Texture wgpu_mipmap_generator_generate_mipmap(wgpu_mipmap_generator* mipmap_generator, wgpu::Texture texture, wgpu::TextureDescriptor* texture_desc)
 {
+	// Compute path: up to 4 levels per dispatch instead of a render pass per level
+	if (mipmap_generator->compute.IsSupported(texture_desc->format) && (texture_desc->usage & wgpu::TextureUsage::StorageBinding))
+	{
+		if (mipmap_generator->compute.Generate(texture))
+			return texture;
+	}
+
 	WGPURenderPipeline pipeline = wgpu_mipmap_generator_get_mipmap_pipeline(
 		mipmap_generator, texture_desc->format);
 
@@ -554,6 +558,24 @@ wgpu_mipmap_generator_generate_mipmap(wgpu_mipmap_generator_t* mipmap_generator,
 * WebGPU Texture Client
 * -------------------------------------------------------------------------- */
 
+/* The texture client keeps C handles: the generator takes over the texture
+ * reference and returns the (possibly new) texture as a C handle again. */
+static WGPUTexture generate_mipmap_c(wgpu_mipmap_generator* mipmap_generator,
+	WGPUTexture texture, WGPUTextureDescriptor* texture_desc)
+{
+	return wgpu_mipmap_generator_generate_mipmap(mipmap_generator,
+		wgpu::Texture::Acquire(texture),
+		reinterpret_cast<wgpu::TextureDescriptor*>(texture_desc)).MoveToCHandle();
+}
+
+static void create_mipmap_generator(struct wgpu_texture_client_t* texture_client)
+{
+	if (texture_client->wgpu_mipmap_generator == NULL) {
+		texture_client->wgpu_mipmap_generator = wgpu_mipmap_generator_create(
+			wgpu::Device(texture_client->wgpu_context->device));
+	}
+}
+
 typedef struct texture_result_t {
 	WGPUTexture texture;
 	uint32_t width;
@@ -630,6 +652,14 @@ texture_result_t wgpu_texture_client_load_texture_from_memory(
 	.mipLevelCount = mip_level_count,
 	.sampleCount = 1,
 	};
+	if (generate_mipmaps) {
+		create_mipmap_generator(texture_client);
+	}
+	// the compute mip generator writes the levels as storage textures
+	if (generate_mipmaps && texture_client->wgpu_mipmap_generator != NULL
+		&& texture_client->wgpu_mipmap_generator->compute.IsSupported((wgpu::TextureFormat)texture_desc.format)) {
+		texture_desc.usage |= WGPUTextureUsage_StorageBinding;
+	}
 	WGPUTexture texture = wgpuDeviceCreateTexture(
 		texture_client->wgpu_context->device, &texture_desc);
 
@@ -639,7 +669,7 @@ texture_result_t wgpu_texture_client_load_texture_from_memory(
 	free(pixel_data);
 
 	if (generate_mipmaps) {
-		texture = wgpu_mipmap_generator_generate_mipmap(
+		texture = generate_mipmap_c(
 			texture_client->wgpu_mipmap_generator, texture, &texture_desc);
 	}
 
@@ -759,6 +789,14 @@ wgpu_texture_load_with_stb(struct wgpu_texture_client_t* texture_client,
 	.mipLevelCount = mip_level_count,
 	.sampleCount = 1,
 	};
+	if (generate_mipmaps) {
+		create_mipmap_generator(texture_client);
+	}
+	// the compute mip generator writes the levels as storage textures
+	if (generate_mipmaps && texture_client->wgpu_mipmap_generator != NULL
+		&& texture_client->wgpu_mipmap_generator->compute.IsSupported((wgpu::TextureFormat)texture_desc.format)) {
+		texture_desc.usage |= WGPUTextureUsage_StorageBinding;
+	}
 	WGPUTexture texture = wgpuDeviceCreateTexture(
 		texture_client->wgpu_context->device, &texture_desc);
 
@@ -768,11 +806,7 @@ wgpu_texture_load_with_stb(struct wgpu_texture_client_t* texture_client,
 	stbi_image_free(pixel_data);
 
 	if (generate_mipmaps) {
-		if (texture_client->wgpu_mipmap_generator == NULL) {
-			texture_client->wgpu_mipmap_generator
-				= wgpu_mipmap_generator_create(texture_client->wgpu_context);
-		}
-		texture = wgpu_mipmap_generator_generate_mipmap(
+		texture = generate_mipmap_c(
 			texture_client->wgpu_mipmap_generator, texture, &texture_desc);
 	}
 
@@ -41,6 +41,8 @@ void wgpu_destroy_texture(texture_t* texture);
 #define NUMBER_OF_TEXTURE_FORMATS WGPUTextureFormat_R8BG8Biplanar420Unorm
 struct wgpu_mipmap_generator 
 {
+	// rgba8unorm/rgba16float/rgba32float textures with StorageBinding usage (compute.SetEnabled(false) - always render passes)
+	ComputeMipGenerator compute;
 	wgpu::Sampler sampler;
 	// Pipeline for every texture format used.
 	wgpu::BindGroupLayout pipeline_layouts[(uint32_t)NUMBER_OF_TEXTURE_FORMATS];
@@ -60,21 +62,23 @@ wgpu::RenderPipeline wgpu_mipmap_generator_get_mipmap_pipeline(wgpu_mipmap_gener
 
 /**
 * @brief Generates mipmaps for the given GPUTexture from the data in level 0.
+* Uses the compute generator when the format and usage allow it, otherwise
+* one render pass per level.
 *
-* @param {wgpu_mipmap_generator_t*} mipmap_generator - The mip map generator.
-* @param {WGPUTexture*} texture - Texture to generate mipmaps for.
-* @param {WGPUTextureDescriptor*} texture_desc - the texture description was
+* @param {wgpu_mipmap_generator*} mipmap_generator - The mip map generator.
+* @param {wgpu::Texture} texture - Texture to generate mipmaps for.
+* @param {wgpu::TextureDescriptor*} texture_desc - the texture description was
 * created with.
-* @returns {WGPUTexture} - The originally passed texture
+* @returns {wgpu::Texture} - The originally passed texture
 */
-WGPUTexture wgpu_mipmap_generator_generate_mipmap(wgpu_mipmap_generator_t* mipmap_generator, WGPUTexture texture, WGPUTextureDescriptor* texture_desc);
+wgpu::Texture wgpu_mipmap_generator_generate_mipmap(wgpu_mipmap_generator* mipmap_generator, wgpu::Texture texture, wgpu::TextureDescriptor* texture_desc);
 
 /* -------------------------------------------------------------------------- *
 * WebGPU Texture Client
 * -------------------------------------------------------------------------- */
 
 typedef struct wgpu_texture_client_t {
-	wgpu_mipmap_generator_t* wgpu_mipmap_generator;
+	struct wgpu_mipmap_generator* wgpu_mipmap_generator;
 	bool allow_compressed_formats;
 	struct {
 		WGPUTextureFormat values[4];
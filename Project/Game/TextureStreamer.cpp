@@ -0,0 +1,213 @@
+#include "Engine.h"
+
+#if defined(_MSC_VER)
+#	pragma warning(push, 3)
+#endif
+
+#include <stb/stb_image.h>
+
+#if defined(_MSC_VER)
+#	pragma warning(pop)
+#endif
+
+//-----------------------------------------------------------------------------
+struct TextureStreamRequest
+{
+	std::shared_ptr<StreamedTexture> target;
+	std::filesystem::path path;
+	bool generateMipmaps = true;
+
+	// decoded image with all mip levels
+	MipChain mipChain;
+
+	// upload progress
+	wgpu::Texture texture = nullptr;
+	uint32_t uploadLevel = 0;
+	uint32_t uploadRow = 0;
+};
+//-----------------------------------------------------------------------------
+TextureStreamer::TextureStreamer() = default;
+//-----------------------------------------------------------------------------
+TextureStreamer::~TextureStreamer() = default;
+//-----------------------------------------------------------------------------
+bool TextureStreamer::Create(const wgpu::Device& device, JobSystem* jobSystem, uint64_t uploadBudgetPerFrame)
+{
+	m_device = device;
+	m_jobSystem = jobSystem;
+	m_uploadBudgetPerFrame = std::max<uint64_t>(uploadBudgetPerFrame, 1);
+
+	// 1x1 white texture, shared by all textures that are still loading
+	wgpu::TextureDescriptor textureDesc{};
+	textureDesc.usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopyDst;
+	textureDesc.dimension = wgpu::TextureDimension::e2D;
+	textureDesc.size = { 1, 1, 1 };
+	textureDesc.format = wgpu::TextureFormat::RGBA8Unorm;
+	m_placeholderTexture = m_device.CreateTexture(&textureDesc);
+	if (!m_placeholderTexture)
+	{
+		Error("Could not create placeholder texture!");
+		return false;
+	}
+
+	const uint8_t whitePixel[4] = { 255, 255, 255, 255 };
+	wgpu::ImageCopyTexture destination{};
+	destination.texture = m_placeholderTexture;
+	wgpu::TextureDataLayout source{};
+	source.bytesPerRow = 4;
+	source.rowsPerImage = 1;
+	WriteTexture(m_device.GetQueue(), destination, whitePixel, sizeof(whitePixel), source, textureDesc.size);
+	m_placeholderView = m_placeholderTexture.CreateView();
+
+	return m_placeholderView != nullptr;
+}
+//-----------------------------------------------------------------------------
+void TextureStreamer::Destroy()
+{
+	// the workers push into m_decoded
+	if (m_jobSystem) m_jobSystem->Wait(m_decodeJobs);
+
+	m_decoded.clear();
+	m_uploads.clear();
+	m_pendingCount = 0;
+	m_placeholderView = nullptr;
+	m_placeholderTexture = nullptr;
+	m_device = nullptr;
+}
+//-----------------------------------------------------------------------------
+std::shared_ptr<StreamedTexture> TextureStreamer::Load(const std::filesystem::path& path, bool generateMipmaps)
+{
+	auto result = std::make_shared<StreamedTexture>();
+	result->texture = m_placeholderTexture;
+	result->view = m_placeholderView;
+
+	TextureStreamRequest* request = new TextureStreamRequest;
+	request->target = result;
+	request->path = path;
+	request->generateMipmaps = generateMipmaps;
+	m_pendingCount++;
+
+	if (m_jobSystem)
+		m_jobSystem->Run([this, request]() { decode(*request); }, &m_decodeJobs);
+	else
+		decode(*request);
+
+	return result;
+}
+//-----------------------------------------------------------------------------
+void TextureStreamer::Update()
+{
+	if (!m_device) return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_decodedMutex);
+		for (auto& request : m_decoded)
+			m_uploads.push_back(std::move(request));
+		m_decoded.clear();
+	}
+
+	uint64_t budget = m_uploadBudgetPerFrame;
+	while (!m_uploads.empty() && budget > 0)
+	{
+		TextureStreamRequest& request = *m_uploads.front();
+		if (!upload(request, budget))
+			break;
+
+		// all levels are uploaded - replace the placeholder
+		StreamedTexture& target = *request.target;
+		target.texture = request.texture;
+		target.view = request.texture.CreateView();
+		// the mip chain was released by upload, the size comes from the texture
+		target.width = request.texture.GetWidth();
+		target.height = request.texture.GetHeight();
+		target.mipLevelCount = request.texture.GetMipLevelCount();
+		target.version++;
+		target.state = StreamedTextureState::Ready;
+
+		m_uploads.pop_front();
+		m_pendingCount--;
+	}
+}
+//-----------------------------------------------------------------------------
+uint32_t TextureStreamer::GetPendingCount() const
+{
+	return m_pendingCount;
+}
+//-----------------------------------------------------------------------------
+void TextureStreamer::decode(TextureStreamRequest& request)
+{
+	int width, height, channels;
+	uint8_t* pixelData = stbi_load(request.path.string().c_str(), &width, &height, &channels, 4);
+	if (!pixelData)
+	{
+		Warning("Could not load texture: " + request.path.string());
+		request.target->state = StreamedTextureState::Failed;
+		m_pendingCount--;
+		delete &request;
+		return;
+	}
+
+	request.mipChain.Generate(pixelData, static_cast<uint32_t>(width), static_cast<uint32_t>(height), request.generateMipmaps ? 0 : 1);
+	stbi_image_free(pixelData);
+
+	std::lock_guard<std::mutex> lock(m_decodedMutex);
+	m_decoded.emplace_back(&request);
+}
+//-----------------------------------------------------------------------------
+bool TextureStreamer::upload(TextureStreamRequest& request, uint64_t& budget)
+{
+	if (!request.texture)
+	{
+		wgpu::TextureDescriptor textureDesc{};
+		textureDesc.usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopyDst;
+		textureDesc.dimension = wgpu::TextureDimension::e2D;
+		textureDesc.size = { request.mipChain.GetLevel(0).width, request.mipChain.GetLevel(0).height, 1 };
+		textureDesc.format = wgpu::TextureFormat::RGBA8Unorm;
+		textureDesc.mipLevelCount = request.mipChain.GetLevelCount();
+		request.texture = m_device.CreateTexture(&textureDesc);
+	}
+
+	wgpu::Queue queue = m_device.GetQueue();
+	while (request.uploadLevel < request.mipChain.GetLevelCount())
+	{
+		const MipLevel& level = request.mipChain.GetLevel(request.uploadLevel);
+		const uint64_t bytesPerRow = 4 * uint64_t(level.width);
+
+		// the level is split into row strips to fit the budget
+		uint32_t rowCount = level.height - request.uploadRow;
+		if (rowCount * bytesPerRow > budget)
+		{
+			rowCount = static_cast<uint32_t>(budget / bytesPerRow);
+			if (rowCount == 0)
+			{
+				// a single row larger than the whole budget is still uploaded, otherwise the texture never finishes
+				if (budget < m_uploadBudgetPerFrame) return false;
+				rowCount = 1;
+			}
+		}
+
+		wgpu::ImageCopyTexture destination{};
+		destination.texture = request.texture;
+		destination.mipLevel = request.uploadLevel;
+		destination.origin = { 0, request.uploadRow, 0 };
+		wgpu::TextureDataLayout source{};
+		source.bytesPerRow = static_cast<uint32_t>(bytesPerRow);
+		source.rowsPerImage = rowCount;
+		wgpu::Extent3D size{ level.width, rowCount, 1 };
+		const uint64_t dataSize = rowCount * bytesPerRow;
+		WriteTexture(queue, destination, request.mipChain.GetLevelData(request.uploadLevel) + request.uploadRow * bytesPerRow, dataSize, source, size);
+
+		budget -= std::min(budget, dataSize);
+		request.uploadRow += rowCount;
+		if (request.uploadRow == level.height)
+		{
+			request.uploadLevel++;
+			request.uploadRow = 0;
+		}
+		if (budget == 0 && request.uploadLevel < request.mipChain.GetLevelCount())
+			return false;
+	}
+
+	request.mipChain.Clear();
+	return true;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "RenderResources.h"
+#include "JobSystem.h"
+#include "MipGenerator.h"
+
+#include <deque>
+
+enum class StreamedTextureState : uint8_t
+{
+	Loading,
+	Ready,
+	Failed
+};
+
+// Texture loaded in the background. Until the image is decoded and uploaded, texture/view are a 1x1 placeholder.
+// texture/view are replaced by TextureStreamer::Update on the render thread - bind groups that use the view must be recreated when version changes.
+struct StreamedTexture
+{
+	bool IsReady() const { return state == StreamedTextureState::Ready; }
+
+	wgpu::Texture texture = nullptr;
+	wgpu::TextureView view = nullptr;
+	uint32_t width = 1;
+	uint32_t height = 1;
+	uint32_t mipLevelCount = 1;
+	uint32_t version = 0;
+	std::atomic<StreamedTextureState> state = StreamedTextureState::Loading;
+};
+
+struct TextureStreamRequest;
+
+// Asynchronous texture loader: files are decoded and mipmapped on the job system threads,
+// the GPU upload is spread over frames with a budget in bytes per frame.
+class TextureStreamer
+{
+public:
+	TextureStreamer();
+	~TextureStreamer(); // TextureStreamRequest is complete only in TextureStreamer.cpp
+
+	// jobSystem = nullptr - images are decoded on the calling thread of Load
+	bool Create(const wgpu::Device& device, JobSystem* jobSystem, uint64_t uploadBudgetPerFrame = 4 * 1024 * 1024);
+	void Destroy();
+
+	// Returns immediately. The result refers to the placeholder until the file is loaded.
+	std::shared_ptr<StreamedTexture> Load(const std::filesystem::path& path, bool generateMipmaps = true);
+
+	// Uploads the decoded images within the frame budget (render thread, once per frame)
+	void Update();
+
+	// Textures not yet decoded or uploaded
+	uint32_t GetPendingCount() const;
+	bool IsValid() const { return m_device != nullptr; }
+
+private:
+	void decode(TextureStreamRequest& request);
+	bool upload(TextureStreamRequest& request, uint64_t& budget);
+
+	wgpu::Device m_device = nullptr;
+	JobSystem* m_jobSystem = nullptr;
+	uint64_t m_uploadBudgetPerFrame = 0;
+
+	wgpu::Texture m_placeholderTexture = nullptr;
+	wgpu::TextureView m_placeholderView = nullptr;
+
+	JobCounter m_decodeJobs;
+	mutable std::mutex m_decodedMutex;
+	std::vector<std::unique_ptr<TextureStreamRequest>> m_decoded; // finished by the workers (guarded by m_decodedMutex)
+	std::deque<std::unique_ptr<TextureStreamRequest>> m_uploads; // render thread only, oldest first
+	std::atomic<uint32_t> m_pendingCount = 0;
+};
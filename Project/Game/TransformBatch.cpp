@@ -0,0 +1,156 @@
+#include "Engine.h"
+#include "Simd.h"
+
+//-----------------------------------------------------------------------------
+namespace
+{
+	static_assert(sizeof(glm::vec3) == 12 && sizeof(glm::quat) == 16 && sizeof(glm::mat4) == 64);
+
+	void worldMatrix(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale, glm::mat4& world)
+	{
+		const float xx = rotation.x * rotation.x, yy = rotation.y * rotation.y, zz = rotation.z * rotation.z;
+		const float xy = rotation.x * rotation.y, xz = rotation.x * rotation.z, yz = rotation.y * rotation.z;
+		const float wx = rotation.w * rotation.x, wy = rotation.w * rotation.y, wz = rotation.w * rotation.z;
+
+		world[0] = glm::vec4(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f) * scale.x;
+		world[1] = glm::vec4(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f) * scale.y;
+		world[2] = glm::vec4(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f) * scale.z;
+		world[3] = glm::vec4(position, 1.0f);
+	}
+
+#if defined(SIMD_SSE2)
+	// 4 transforms: the quaternions are transposed so that every lane is one transform
+	void worldMatrices4SSE2(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales, const bool* dirty, glm::mat4* worlds)
+	{
+		// glm stores the quaternion as w, x, y, z unless GLM_FORCE_QUAT_DATA_XYZW
+		__m128 q0 = _mm_loadu_ps(reinterpret_cast<const float*>(&rotations[0]));
+		__m128 q1 = _mm_loadu_ps(reinterpret_cast<const float*>(&rotations[1]));
+		__m128 q2 = _mm_loadu_ps(reinterpret_cast<const float*>(&rotations[2]));
+		__m128 q3 = _mm_loadu_ps(reinterpret_cast<const float*>(&rotations[3]));
+		_MM_TRANSPOSE4_PS(q0, q1, q2, q3);
+#if defined(GLM_FORCE_QUAT_DATA_XYZW)
+		const __m128 x = q0, y = q1, z = q2, w = q3;
+#else
+		const __m128 w = q0, x = q1, y = q2, z = q3;
+#endif
+
+		const __m128 two = _mm_set1_ps(2.0f);
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 x2 = _mm_mul_ps(x, two), y2 = _mm_mul_ps(y, two), z2 = _mm_mul_ps(z, two);
+		const __m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+		const __m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+		const __m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+
+		const __m128 sx = _mm_setr_ps(scales[0].x, scales[1].x, scales[2].x, scales[3].x);
+		const __m128 sy = _mm_setr_ps(scales[0].y, scales[1].y, scales[2].y, scales[3].y);
+		const __m128 sz = _mm_setr_ps(scales[0].z, scales[1].z, scales[2].z, scales[3].z);
+
+		// columns of the rotation-scale part, one lane per transform
+		__m128 c0x = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx);
+		__m128 c0y = _mm_mul_ps(_mm_add_ps(xy, wz), sx);
+		__m128 c0z = _mm_mul_ps(_mm_sub_ps(xz, wy), sx);
+		__m128 c0w = _mm_setzero_ps();
+		__m128 c1x = _mm_mul_ps(_mm_sub_ps(xy, wz), sy);
+		__m128 c1y = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy);
+		__m128 c1z = _mm_mul_ps(_mm_add_ps(yz, wx), sy);
+		__m128 c1w = _mm_setzero_ps();
+		__m128 c2x = _mm_mul_ps(_mm_add_ps(xz, wy), sz);
+		__m128 c2y = _mm_mul_ps(_mm_sub_ps(yz, wx), sz);
+		__m128 c2z = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz);
+		__m128 c2w = _mm_setzero_ps();
+		_MM_TRANSPOSE4_PS(c0x, c0y, c0z, c0w);
+		_MM_TRANSPOSE4_PS(c1x, c1y, c1z, c1w);
+		_MM_TRANSPOSE4_PS(c2x, c2y, c2z, c2w);
+
+		const __m128 column0[4] = { c0x, c0y, c0z, c0w };
+		const __m128 column1[4] = { c1x, c1y, c1z, c1w };
+		const __m128 column2[4] = { c2x, c2y, c2z, c2w };
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			if (dirty && !dirty[i]) continue;
+			float* world = &worlds[i][0][0];
+			_mm_storeu_ps(world + 0, column0[i]);
+			_mm_storeu_ps(world + 4, column1[i]);
+			_mm_storeu_ps(world + 8, column2[i]);
+			_mm_storeu_ps(world + 12, _mm_setr_ps(positions[i].x, positions[i].y, positions[i].z, 1.0f));
+		}
+	}
+#endif
+
+#if defined(SIMD_AVX2)
+	// two result columns per step: the columns c and c + 1 of world in the lanes 0-3 and 4-7
+	void mvpMatrixAVX2(const __m256 viewProjection[4], const glm::mat4& world, glm::mat4& mvp)
+	{
+		const __m256 c01 = _mm256_loadu_ps(&world[0][0]);
+		const __m256 c23 = _mm256_loadu_ps(&world[2][0]);
+		__m256 r01 = _mm256_mul_ps(viewProjection[0], _mm256_permute_ps(c01, _MM_SHUFFLE(0, 0, 0, 0)));
+		r01 = _mm256_fmadd_ps(viewProjection[1], _mm256_permute_ps(c01, _MM_SHUFFLE(1, 1, 1, 1)), r01);
+		r01 = _mm256_fmadd_ps(viewProjection[2], _mm256_permute_ps(c01, _MM_SHUFFLE(2, 2, 2, 2)), r01);
+		r01 = _mm256_fmadd_ps(viewProjection[3], _mm256_permute_ps(c01, _MM_SHUFFLE(3, 3, 3, 3)), r01);
+		__m256 r23 = _mm256_mul_ps(viewProjection[0], _mm256_permute_ps(c23, _MM_SHUFFLE(0, 0, 0, 0)));
+		r23 = _mm256_fmadd_ps(viewProjection[1], _mm256_permute_ps(c23, _MM_SHUFFLE(1, 1, 1, 1)), r23);
+		r23 = _mm256_fmadd_ps(viewProjection[2], _mm256_permute_ps(c23, _MM_SHUFFLE(2, 2, 2, 2)), r23);
+		r23 = _mm256_fmadd_ps(viewProjection[3], _mm256_permute_ps(c23, _MM_SHUFFLE(3, 3, 3, 3)), r23);
+		_mm256_storeu_ps(&mvp[0][0], r01);
+		_mm256_storeu_ps(&mvp[2][0], r23);
+	}
+#elif defined(SIMD_SSE2)
+	void mvpMatrixSSE2(const __m128 viewProjection[4], const glm::mat4& world, glm::mat4& mvp)
+	{
+		__m128 result[4];
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			const __m128 column = _mm_loadu_ps(&world[c][0]);
+			__m128 r = _mm_mul_ps(viewProjection[0], _mm_shuffle_ps(column, column, _MM_SHUFFLE(0, 0, 0, 0)));
+			r = _mm_add_ps(r, _mm_mul_ps(viewProjection[1], _mm_shuffle_ps(column, column, _MM_SHUFFLE(1, 1, 1, 1))));
+			r = _mm_add_ps(r, _mm_mul_ps(viewProjection[2], _mm_shuffle_ps(column, column, _MM_SHUFFLE(2, 2, 2, 2))));
+			r = _mm_add_ps(r, _mm_mul_ps(viewProjection[3], _mm_shuffle_ps(column, column, _MM_SHUFFLE(3, 3, 3, 3))));
+			result[c] = r;
+		}
+		// stored after all loads: world and mvp may alias
+		for (uint32_t c = 0; c < 4; c++)
+			_mm_storeu_ps(&mvp[c][0], result[c]);
+	}
+#endif
+}
+//-----------------------------------------------------------------------------
+void ComputeWorldMatrices(uint32_t count, const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales,
+	const bool* dirty, glm::mat4* worlds)
+{
+	uint32_t i = 0;
+#if defined(SIMD_SSE2)
+	for (; i + 4 <= count; i += 4)
+	{
+		const bool* dirty4 = dirty ? dirty + i : nullptr;
+		if (dirty4 && !(dirty4[0] || dirty4[1] || dirty4[2] || dirty4[3]))
+			continue;
+		worldMatrices4SSE2(positions + i, rotations + i, scales + i, dirty4, worlds + i);
+	}
+#endif
+	for (; i < count; i++)
+	{
+		if (!dirty || dirty[i])
+			worldMatrix(positions[i], rotations[i], scales[i], worlds[i]);
+	}
+}
+//-----------------------------------------------------------------------------
+void ComputeMvpMatrices(uint32_t count, const glm::mat4& viewProjection, const glm::mat4* worlds, glm::mat4* mvps)
+{
+#if defined(SIMD_AVX2)
+	__m256 columns[4];
+	for (uint32_t c = 0; c < 4; c++)
+		columns[c] = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&viewProjection[c][0]));
+	for (uint32_t i = 0; i < count; i++)
+		mvpMatrixAVX2(columns, worlds[i], mvps[i]);
+#elif defined(SIMD_SSE2)
+	__m128 columns[4];
+	for (uint32_t c = 0; c < 4; c++)
+		columns[c] = _mm_loadu_ps(&viewProjection[c][0]);
+	for (uint32_t i = 0; i < count; i++)
+		mvpMatrixSSE2(columns, worlds[i], mvps[i]);
+#else
+	for (uint32_t i = 0; i < count; i++)
+		mvps[i] = viewProjection * worlds[i];
+#endif
+}
+//-----------------------------------------------------------------------------
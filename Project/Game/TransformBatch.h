@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+// Batch transform kernels over arrays (SoA: positions, rotations and scales in separate arrays).
+// SSE2 processes 4 transforms per step, AVX2 builds multiply two matrix columns per instruction (Simd.h).
+// The arrays may be split into ranges and processed on several threads.
+
+// worlds[i] = translate(positions[i]) * mat4_cast(rotations[i]) * scale(scales[i]),
+// only for the entries with dirty[i] (dirty = nullptr - all). The other worlds[i] are not written.
+void ComputeWorldMatrices(uint32_t count, const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales,
+	const bool* dirty, glm::mat4* worlds);
+
+// mvps[i] = viewProjection * worlds[i]. worlds and mvps may be the same array.
+void ComputeMvpMatrices(uint32_t count, const glm::mat4& viewProjection, const glm::mat4* worlds, glm::mat4* mvps);
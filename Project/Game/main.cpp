@@ -1,11 +1,14 @@
 ﻿#include "Engine.h"
 #include "TestApp.h"
+#include "BenchmarkApp.h"
 //-----------------------------------------------------------------------------
 int main(
-	[[maybe_unused]] int   argc,
-	[[maybe_unused]] char* argv[])
+	int   argc,
+	char* argv[])
 {
-	Engine::Run<TestApp>();
-	return 0;
+	BenchmarkSettings benchmark;
+	if (ParseBenchmarkArgs(argc, argv, benchmark))
+		return Engine::Run<BenchmarkApp>(benchmark);
+	return Engine::Run<TestApp>();
 }
 //-----------------------------------------------------------------------------
\ No newline at end of file